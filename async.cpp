@@ -0,0 +1,242 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Coroutine based async evaluation:
+//------------------------------------------------------------------------------
+
+#include "async.hpp"
+#include "parallel.hpp"
+
+using namespace circuits;
+
+//------------------------------------------------------------------------------
+// Executor:
+//------------------------------------------------------------------------------
+
+async_executor::async_executor(size_t threads)
+{
+  if (threads == 0) {
+    threads = get_thread_count();
+  }
+
+  for (size_t i{}; i < threads; ++i) {
+    workers.emplace_back([this]() { worker_loop(); });
+  }
+}
+
+async_executor::~async_executor()
+{
+  {
+    std::lock_guard<std::mutex> lock{queue_mutex};
+    stopping = true;
+  }
+  queue_ready.notify_all();
+
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+size_t async_executor::get_size() const
+{
+  return workers.size();
+}
+
+//------------------------------------------------------------------------------
+
+async_executor::job_awaiter async_executor::run(const size_t &count,
+  std::function<void(const size_t &, const size_t &)> work,
+  const async_options &options)
+{
+  if (options.chunk_size == 0) {
+    throw std::invalid_argument("Chunk size must be at least 1.");
+  }
+
+  auto new_job = std::make_shared<job>();
+  new_job->count = count;
+  new_job->work = std::move(work);
+  new_job->options = options;
+
+  return job_awaiter{this, new_job};
+}
+
+bool async_executor::submit(const std::shared_ptr<job> &new_job)
+{
+  {
+    std::lock_guard<std::mutex> lock{queue_mutex};
+
+    // Nobody left to run it, so the awaiting coroutine carries straight on:
+    if (stopping) {
+      new_job->error = std::make_exception_ptr(operation_cancelled{});
+      new_job->completed = true;
+      return false;
+    }
+
+    queue.push_back(new_job);
+  }
+  queue_ready.notify_one();
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
+void async_executor::worker_loop()
+{
+  while (true) {
+    std::shared_ptr<job> current;
+    size_t begin{}, end{};
+    bool claimed = false, finished = false;
+
+    {
+      std::unique_lock<std::mutex> lock{queue_mutex};
+      queue_ready.wait(lock, [&]() { return stopping || !queue.empty(); });
+
+      if (queue.empty()) {
+        return;
+      }
+
+      current = queue.front();
+      queue.pop_front();
+
+      // Stops handing out chunks (those already running still finish):
+      if ((stopping || current->options.cancel.is_cancelled())
+        && !current->error) {
+        current->error = std::make_exception_ptr(operation_cancelled{});
+        current->next = current->count;
+      }
+
+      if (current->next < current->count) {
+        begin = current->next;
+        end = std::min(current->count, begin + current->options.chunk_size);
+        current->next = end;
+        ++current->in_flight;
+        claimed = true;
+
+        // Back of the queue, so every other job gets a chunk first:
+        if (current->next < current->count) {
+          queue.push_back(current);
+          queue_ready.notify_one();
+        }
+
+      // No chunks left (after an error / cancel), finish if nothing running:
+      } else if (current->in_flight == 0 && !current->completed) {
+        current->completed = true;
+        finished = true;
+      }
+    }
+
+    if (claimed) {
+      bool failed = false;
+      try {
+        current->work(begin, end);
+      }
+      catch (...) {
+        failed = true;
+        std::lock_guard<std::mutex> lock{queue_mutex};
+        if (!current->error) {
+          current->error = std::current_exception();
+        }
+        current->next = current->count;
+      }
+
+      // Reported before this chunk counts as finished, so the callback never
+      // runs after the awaiting coroutine has moved on:
+      if (!failed && current->options.progress) {
+        std::lock_guard<std::mutex> progress_lock{current->progress_mutex};
+
+        size_t done{};
+        {
+          std::lock_guard<std::mutex> lock{queue_mutex};
+          current->done += end - begin;
+          done = current->done;
+        }
+        current->options.progress(done, current->count);
+      }
+
+      std::lock_guard<std::mutex> lock{queue_mutex};
+      --current->in_flight;
+
+      if (current->next >= current->count && current->in_flight == 0
+        && !current->completed) {
+        current->completed = true;
+        finished = true;
+      }
+    }
+
+    // Awaiting coroutine continues on this worker:
+    if (finished) {
+      current->waiter.resume();
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Circuit evaluation:
+//------------------------------------------------------------------------------
+
+namespace
+{
+  // Coroutines take their arguments by value (copied into the frame), so the
+  // caller's arguments can go out of scope while the task is waiting:
+  task<std::vector<std::complex<double>>> sweep_task(
+    async_executor &executor, std::shared_ptr<const circuit> circ,
+    std::vector<double> frequencies, async_options options)
+  {
+    std::vector<std::complex<double>> impedances(frequencies.size());
+
+    co_await executor.run(frequencies.size(),
+      [&](const size_t &begin, const size_t &end) {
+        // evaluate() is const, so every chunk shares the circuit:
+        for (size_t i{begin}; i < end; ++i) {
+          impedances[i] = circ->evaluate(frequencies[i]);
+        }
+      }, options);
+
+    co_return impedances;
+  }
+
+  task<std::complex<double>> evaluate_task(
+    async_executor &executor, std::shared_ptr<const circuit> circ,
+    std::vector<double> frequencies, async_options options)
+  {
+    auto sweep = sweep_task(executor, circ, frequencies, options);
+    auto impedances = co_await sweep;
+
+    co_return impedances[0];
+  }
+}
+
+//------------------------------------------------------------------------------
+
+task<std::vector<std::complex<double>>> circuits::sweep_async(
+  async_executor &executor, const std::shared_ptr<const circuit> &circ,
+  const std::vector<double> &frequencies, const async_options &options)
+{
+  return sweep_task(executor, circ, frequencies, options);
+}
+
+task<std::complex<double>> circuits::evaluate_async(
+  async_executor &executor, const std::shared_ptr<const circuit> &circ,
+  const double &freq, const async_options &options)
+{
+  return evaluate_task(executor, circ, std::vector<double>(1, freq), options);
+}
+
+task<std::vector<std::complex<double>>> circuits::sweep_async(
+  async_executor &executor, const std::shared_ptr<const circuit> &circ,
+  const std::vector<double> &frequencies)
+{
+  return sweep_task(executor, circ, frequencies, async_options{});
+}
+
+task<std::complex<double>> circuits::evaluate_async(
+  async_executor &executor, const std::shared_ptr<const circuit> &circ,
+  const double &freq)
+{
+  return evaluate_task(
+    executor, circ, std::vector<double>(1, freq), async_options{});
+}
@@ -0,0 +1,367 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Coroutine based async evaluation (needs C++20):
+//------------------------------------------------------------------------------
+
+#ifndef async_hpp
+#define async_hpp
+
+#include "circuit.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+
+//------------------------------------------------------------------------------
+// Usage (inside a coroutine returning task<...>):
+//
+//   async_executor executor;
+//   auto impedances = co_await sweep_async(executor, circ, frequencies);
+//
+// or from ordinary code: sync_wait(sweep_async(executor, circ, frequencies)).
+//
+// Work is split into chunks and the executor takes one chunk from each waiting
+// job in turn, so a huge sweep can't starve many small ones. Other long jobs
+// (e.g. Monte Carlo trials) can be chunked the same way with executor.run().
+//------------------------------------------------------------------------------
+
+namespace circuits
+{
+  // Thrown when awaiting a job that was cancelled:
+  class operation_cancelled : public std::runtime_error
+  {
+  public:
+    operation_cancelled() : std::runtime_error{"Operation was cancelled."} {}
+  };
+
+  // Copies share the same flag, so keep one to cancel a running job:
+  class cancellation_token
+  {
+  private:
+    std::shared_ptr<std::atomic<bool>> flag =
+      std::make_shared<std::atomic<bool>>(false);
+
+  public:
+    void cancel() const
+    {
+      flag->store(true);
+    }
+
+    bool is_cancelled() const
+    {
+      return flag->load();
+    }
+  };
+
+  struct async_options
+  {
+    // Checked before every chunk:
+    cancellation_token cancel;
+
+    // Called with (items done, total items) after each chunk:
+    // (from worker threads, but never two calls at once for the same job)
+    std::function<void(const size_t &, const size_t &)> progress;
+
+    // Items per chunk, other jobs get a turn between chunks:
+    size_t chunk_size = 256;
+  };
+
+//------------------------------------------------------------------------------
+// Task (lazy, starts when awaited, resumes the awaiting coroutine when done):
+//------------------------------------------------------------------------------
+
+  template <class T> struct task_result
+  {
+    std::optional<T> value;
+
+    template <class U> void return_value(U &&result)
+    {
+      value.emplace(std::forward<U>(result));
+    }
+
+    T take()
+    {
+      return std::move(*value);
+    }
+  };
+
+  template <> struct task_result<void>
+  {
+    void return_void() {}
+    void take() {}
+  };
+
+  template <class T> class task
+  {
+  public:
+    struct promise_type : task_result<T>
+    {
+      std::exception_ptr error;
+      std::coroutine_handle<> continuation;
+
+      task get_return_object()
+      {
+        return task{std::coroutine_handle<promise_type>::from_promise(*this)};
+      }
+
+      std::suspend_always initial_suspend() noexcept
+      {
+        return {};
+      }
+
+      // Hands control straight to whoever awaited the task:
+      struct final_awaiter
+      {
+        bool await_ready() noexcept
+        {
+          return false;
+        }
+
+        std::coroutine_handle<> await_suspend(
+          std::coroutine_handle<promise_type> handle) noexcept
+        {
+          auto next = handle.promise().continuation;
+          return next ? next : std::noop_coroutine();
+        }
+
+        void await_resume() noexcept {}
+      };
+
+      final_awaiter final_suspend() noexcept
+      {
+        return {};
+      }
+
+      void unhandled_exception()
+      {
+        error = std::current_exception();
+      }
+    };
+
+  private:
+    std::coroutine_handle<promise_type> handle;
+
+    explicit task(std::coroutine_handle<promise_type> h) : handle{h} {}
+
+  public:
+    task(task &&other) noexcept : handle{other.handle}
+    {
+      other.handle = nullptr;
+    }
+
+    task(const task &) = delete;
+    task &operator=(const task &) = delete;
+    task &operator=(task &&) = delete;
+
+    ~task()
+    {
+      if (handle) {
+        handle.destroy();
+      }
+    }
+
+    bool await_ready() const noexcept
+    {
+      return false;
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting)
+    {
+      handle.promise().continuation = awaiting;
+      return handle;
+    }
+
+    T await_resume()
+    {
+      if (handle.promise().error) {
+        std::rethrow_exception(handle.promise().error);
+      }
+      return handle.promise().take();
+    }
+  };
+
+//------------------------------------------------------------------------------
+// Executor (round robin over chunks of every waiting job):
+//------------------------------------------------------------------------------
+
+  class async_executor
+  {
+  private:
+    struct job
+    {
+      size_t count;
+      std::function<void(const size_t &, const size_t &)> work;
+      async_options options;
+
+      // Guarded by the executor's queue_mutex:
+      size_t next = 0;
+      size_t done = 0;
+      size_t in_flight = 0;
+      bool completed = false;
+      std::exception_ptr error;
+
+      std::mutex progress_mutex;
+      std::coroutine_handle<> waiter;
+    };
+
+    std::vector<std::thread> workers;
+
+    std::deque<std::shared_ptr<job>> queue;
+    std::mutex queue_mutex;
+    std::condition_variable queue_ready;
+    bool stopping = false;
+
+    void worker_loop();
+
+    // Queues a job, false if the executor is stopping (job is cancelled):
+    bool submit(const std::shared_ptr<job> &new_job);
+
+  public:
+    // Awaited by the coroutine running a job:
+    class job_awaiter
+    {
+    private:
+      async_executor *executor;
+      std::shared_ptr<job> pending;
+
+    public:
+      job_awaiter(async_executor *exec, std::shared_ptr<job> j)
+        : executor{exec}, pending{std::move(j)} {}
+
+      bool await_ready() const noexcept
+      {
+        return pending->count == 0;
+      }
+
+      bool await_suspend(std::coroutine_handle<> handle)
+      {
+        pending->waiter = handle;
+        return executor->submit(pending);
+      }
+
+      // Throws the first error from work, or operation_cancelled:
+      void await_resume() const
+      {
+        if (pending->error) {
+          std::rethrow_exception(pending->error);
+        }
+      }
+    };
+
+    // Worker threads (0 = one per core):
+    async_executor(size_t threads = 0);
+
+    // Cancels jobs still waiting, then joins the workers:
+    ~async_executor();
+
+    async_executor(const async_executor &) = delete;
+    async_executor &operator=(const async_executor &) = delete;
+
+    size_t get_size() const;
+
+    // Calls work(begin, end) over [0, count) in chunks, co_await the result:
+    // (work may run on several threads at once, for different chunks)
+    job_awaiter run(const size_t &count,
+      std::function<void(const size_t &, const size_t &)> work,
+      const async_options &options);
+  };
+
+//------------------------------------------------------------------------------
+// Circuit evaluation:
+//------------------------------------------------------------------------------
+
+  // (overloads rather than default arguments, as GCC 12 destroys a default
+  // argument temporary twice when it is part of a co_await expression)
+
+  // Impedance at every frequency (Hz), chunks share the circuit (evaluate()):
+  // (arguments are copied, so the task doesn't depend on them afterwards)
+  task<std::vector<std::complex<double>>> sweep_async(
+    async_executor &executor, const std::shared_ptr<const circuit> &circ,
+    const std::vector<double> &frequencies, const async_options &options);
+
+  task<std::vector<std::complex<double>>> sweep_async(
+    async_executor &executor, const std::shared_ptr<const circuit> &circ,
+    const std::vector<double> &frequencies);
+
+  // Impedance at a single frequency (Hz):
+  task<std::complex<double>> evaluate_async(
+    async_executor &executor, const std::shared_ptr<const circuit> &circ,
+    const double &freq, const async_options &options);
+
+  task<std::complex<double>> evaluate_async(
+    async_executor &executor, const std::shared_ptr<const circuit> &circ,
+    const double &freq);
+
+//------------------------------------------------------------------------------
+// Waiting from ordinary (non coroutine) code:
+//------------------------------------------------------------------------------
+
+  // Runs the coroutine to completion and resumes it with nothing else:
+  struct detached_task
+  {
+    struct promise_type
+    {
+      detached_task get_return_object()
+      {
+        return {};
+      }
+
+      std::suspend_never initial_suspend() noexcept
+      {
+        return {};
+      }
+
+      std::suspend_never final_suspend() noexcept
+      {
+        return {};
+      }
+
+      void return_void() {}
+
+      void unhandled_exception()
+      {
+        std::terminate();
+      }
+    };
+  };
+
+  // Blocks the calling thread until the task finishes, returning its result:
+  template <class T> T sync_wait(task<T> pending)
+  {
+    std::promise<T> finished;
+    std::future<T> result = finished.get_future();
+
+    auto wait_for = [](task<T> &t, std::promise<T> &done) -> detached_task {
+      try {
+        if constexpr (std::is_void_v<T>) {
+          co_await t;
+          done.set_value();
+        } else {
+          done.set_value(co_await t);
+        }
+      }
+      catch (...) {
+        done.set_exception(std::current_exception());
+      }
+    };
+
+    wait_for(pending, finished);
+    return result.get();
+  }
+}
+
+//------------------------------------------------------------------------------
+#endif
+//------------------------------------------------------------------------------
@@ -11,15 +11,46 @@
 
 //------------------------------------------------------------------------------
 
+namespace
+{
+  struct kind_info
+  {
+    const char *name;
+    char symbol;
+  };
+
+  // In the order of component_kind:
+  const kind_info kind_table[] = {
+    {"empty", 'N'},
+    {"resistor", 'R'},
+    {"capacitor", 'C'},
+    {"inductor", 'L'},
+    {"real resistor", 'r'},
+    {"real capacitor", 'c'},
+    {"real inductor", 'l'},
+    {"circuit", '~'},
+    {"frozen circuit", 'F'},
+    {"reduced model", 'M'},
+    {"measured", 'T'}
+  };
+}
+
+//------------------------------------------------------------------------------
+
 std::string component::get_type() const
 {
-  return type;
+  return kind_table[static_cast<size_t>(kind)].name;
+}
+
+component_kind component::get_kind() const
+{
+  return kind;
 }
 
 // For each type of component:
 char component::get_symbol() const
 {
-  return symbol;
+  return kind_table[static_cast<size_t>(kind)].symbol;
 }
 
 void component::set_connection_type(const char &conn)
@@ -44,6 +75,15 @@ bool component::get_nested_bool() const
 
 //------------------------------------------------------------------------------
 
+// Only drifting<T> (see base_component.hpp) has any:
+circuits::temperature_coefficients component::get_temperature_coefficients()
+  const
+{
+  return circuits::temperature_coefficients{};
+}
+
+//------------------------------------------------------------------------------
+
 std::complex<double> component::get_impedance() const
 {
   return impedance;
@@ -59,4 +99,24 @@ double component::get_phase() const
   return std::arg(impedance);
 }
 
+//------------------------------------------------------------------------------
+
+// Buffered, so the whole block reaches the terminal in one write:
+void component::print_info() const
+{
+  circuits::report_writer out{std::cout};
+  write_info(out);
+}
+
+//------------------------------------------------------------------------------
+void circuits::temperature_coefficients::write_info(report_writer &out) const
+{
+  if (is_zero()) {
+    return;
+  }
+
+  out << "    Temperature coefficients = " << first << " /C, " << second
+  << " /C^2." << '\n';
+}
+
 //------------------------------------------------------------------------------
\ No newline at end of file
@@ -15,25 +15,82 @@
 #include <complex>
 #include<vector>
 #include <algorithm>
+#include <cstdint>
 #include <string>
 #include <cmath>
 #include <exception>
+#include <stdexcept>
 #include <memory>
 
+#include "format.hpp"
+
+//------------------------------------------------------------------------------
+
+// Every kind of component, names / symbols are in a table (base_component.cpp),
+// so each object carries one byte rather than a string:
+enum class component_kind : uint8_t
+{
+  empty,
+  resistor,
+  capacitor,
+  inductor,
+  real_resistor,
+  real_capacitor,
+  real_inductor,
+  circuit,
+  frozen_circuit,
+  reduced_model,
+  measured
+};
+
+//------------------------------------------------------------------------------
+
+namespace circuits
+{
+  // Temperature (Celsius) component values are given at:
+  const double nominal_temperature = 25.0;
+
+  // Drift of a component's value (resistance, capacitance or inductance):
+  // value at T = value x (1 + first dT + second dT^2), dT = T - 25 C
+  // (netlist TC1 / TC2, given about SPICE's 27 C, are converted to this)
+  struct temperature_coefficients
+  {
+    double first = 0;
+    double second = 0;
+
+    double get_factor(const double &temperature) const
+    {
+      double difference = temperature - nominal_temperature;
+      return 1.0 + (first * difference) + (second * difference * difference);
+    }
+
+    bool is_zero() const
+    {
+      return (first == 0.0) && (second == 0.0);
+    }
+
+    // Line for write_info() (nothing if zero):
+    void write_info(report_writer &out) const;
+  };
+}
+
 //------------------------------------------------------------------------------
 
 class component
 {
 protected:
-  std::string type;
-  std::complex<double> impedance;
-  double frequency;
+  // Doubles first, then the one byte fields share the last 8 bytes:
+  // (so derived members start right after, 40 bytes with the vtable pointer)
+  double frequency = 0;
+  std::complex<double> impedance{};
+
+  component_kind kind = component_kind::empty;
+
   // Series (s) or parallel (p):
   char connection_type;
 
   // Is the component nested:
   bool is_nested = false;
-  char symbol;
 
 public:
   // Returns a unique pointer to the component itself:
@@ -49,6 +106,10 @@ public:
   // For cases where other data members will affect impedance value:
   virtual void set_impedance() = 0;
 
+  // Impedance at freq (Hz), changing nothing (not even the frequency), so
+  // many threads can evaluate one component / circuit at once:
+  virtual std::complex<double> evaluate(const double &freq) const = 0;
+
   // value refers to either the resis / induc / capac (and for non-ideal):
   virtual void set_value(const double &value) = 0;
 
@@ -58,13 +119,24 @@ public:
   virtual void set_frequency(const double &freq) = 0;
   virtual double get_frequency() const = 0;
 
-  // PVF to print info of given component:
-  virtual void print_info() const = 0;
+  // Drift of the value with temperature (zero unless a drifting<T>):
+  virtual circuits::temperature_coefficients get_temperature_coefficients()
+    const;
+
+  // Returns dZ/df at the current frequency (analytic, used by analysis):
+  virtual std::complex<double> get_impedance_derivative() const = 0;
+
+  // PVF to write info of given component (see format.hpp):
+  virtual void write_info(circuits::report_writer &out) const = 0;
+
+  // Prints info of given component to std::cout:
+  void print_info() const;
 
 //------------------------------------------------------------------------------
 
   // Returns name of component:
   std::string get_type() const;
+  component_kind get_kind() const;
 
   // Returns symbol of component (diagram):
   char get_symbol() const;
@@ -89,6 +161,49 @@ public:
   double get_phase() const;
 };
 
+//------------------------------------------------------------------------------
+// One of the six basic types with temperature coefficients. Only parts that
+// drift are made as these, so the others don't carry the coefficients:
+//------------------------------------------------------------------------------
+
+template <class T> class drifting : public T
+{
+private:
+  circuits::temperature_coefficients coefficients;
+
+public:
+  // Same constructors as T (no drift until set):
+  using T::T;
+
+  // For cloning unique_ptr of component (keeps the coefficients):
+  std::unique_ptr<component> clone() const
+  {
+    return std::make_unique<drifting<T>>(*this);
+  }
+
+  // Per C and per C^2 (see above):
+  void set_temperature_coefficients(
+    const circuits::temperature_coefficients &tc)
+  {
+    if (!std::isfinite(tc.first) || !std::isfinite(tc.second)) {
+      throw std::invalid_argument{"Temperature coefficients must be finite."};
+    }
+
+    coefficients = tc;
+  }
+
+  circuits::temperature_coefficients get_temperature_coefficients() const
+  {
+    return coefficients;
+  }
+
+  void write_info(circuits::report_writer &out) const
+  {
+    T::write_info(out);
+    coefficients.write_info(out);
+  }
+};
+
 //------------------------------------------------------------------------------
 #endif
 //------------------------------------------------------------------------------
\ No newline at end of file
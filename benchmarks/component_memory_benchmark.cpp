@@ -0,0 +1,107 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Memory used per component (object size and heap bytes in a circuit):
+//
+//   g++ -std=c++20 -O2 -pthread -I. benchmarks/component_memory_benchmark.cpp
+//     $(ls *.cpp | grep -v main.cpp) -o memory_benchmark   (one line)
+//   ./memory_benchmark [components]
+//
+// Heap bytes come from malloc's own count (glibc mallinfo2), so they include
+// allocator overhead, shared_ptr control blocks and the circuit's vector.
+//------------------------------------------------------------------------------
+
+#include "generator.hpp"
+#include "resistors.hpp"
+#include "capacitors.hpp"
+#include "inductors.hpp"
+
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include <malloc.h>
+
+using namespace circuits;
+
+//------------------------------------------------------------------------------
+
+namespace
+{
+  size_t heap_in_use()
+  {
+    return mallinfo2().uordblks;
+  }
+
+  // Heap bytes per component of a circuit holding count of them, built as
+  // the generator does (make_shared) and as a copy does (clone):
+  void report(const std::string &name, const size_t &object_size,
+    const size_t &count, const std::function<std::shared_ptr<component>()> &make)
+  {
+    size_t before = heap_in_use();
+    double built_bytes{};
+    double copied_bytes{};
+
+    {
+      std::vector<std::shared_ptr<component>> parts;
+      parts.reserve(count);
+      for (size_t i{}; i < count; ++i) {
+        parts.push_back(make());
+        parts.back()->set_connection_type('s');
+      }
+
+      circuit circ{1e3, 1.0, std::move(parts)};
+      parts.clear();
+      parts.shrink_to_fit();
+      built_bytes = double(heap_in_use() - before) / count;
+
+      size_t before_copy = heap_in_use();
+      circuit copy{circ};
+      copied_bytes = double(heap_in_use() - before_copy) / count;
+    }
+
+    std::cout << std::left << std::setw(16) << name << std::setw(10)
+      << object_size << std::setw(14) << built_bytes << copied_bytes
+      << std::endl;
+  }
+}
+
+//------------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+  size_t count = (argc > 1) ? std::stoul(argv[1]) : 1000000;
+
+  std::cout << std::fixed << std::setprecision(1);
+  std::cout << count << " components per circuit\n" << std::left
+    << std::setw(16) << "type" << std::setw(10) << "sizeof"
+    << std::setw(14) << "built B" << "copied B" << std::endl;
+
+  report("resistor", sizeof(resistor), count,
+    [] { return std::make_shared<resistor>(100); });
+  report("capacitor", sizeof(capacitor), count,
+    [] { return std::make_shared<capacitor>(1e-6); });
+  report("inductor", sizeof(inductor), count,
+    [] { return std::make_shared<inductor>(1e-3); });
+  report("real resistor", sizeof(real_resistor), count,
+    [] { return std::make_shared<real_resistor>(100, 1e-9, 1e-12); });
+  report("real capacitor", sizeof(real_capacitor), count,
+    [] { return std::make_shared<real_capacitor>(0.1, 1e-9, 1e-6); });
+  report("real inductor", sizeof(real_inductor), count,
+    [] { return std::make_shared<real_inductor>(0.5, 1e-3, 1e-12); });
+
+  // Whole circuit, all six types mixed:
+  size_t before = heap_in_use();
+  {
+    circuit circ = generate_circuit(circuit_shape::random_mix, count, 1);
+    std::cout << "random_mix circuit: "
+      << double(heap_in_use() - before) / count << " B per component"
+      << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,214 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Worst case corner search against brute force over every corner:
+//
+//   g++ -std=c++20 -O2 -pthread -I. benchmarks/corner_benchmark.cpp
+//     $(ls *.cpp | grep -v main.cpp) -o corner_benchmark   (one line)
+//   ./corner_benchmark [tolerances]
+//------------------------------------------------------------------------------
+
+#include "corners.hpp"
+#include "generator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace circuits;
+
+//------------------------------------------------------------------------------
+
+namespace
+{
+  // Components in depth first order (tolerance indices), to set values on:
+  void list_parts(const circuit &circ, std::vector<component *> &parts)
+  {
+    for (const auto &comp : circ.get_components()) {
+      parts.push_back(comp.get());
+      if (auto sub = dynamic_cast<const circuit *>(comp.get())) {
+        list_parts(*sub, parts);
+      }
+    }
+  }
+
+  // count random parts (not circuits) of up to 10% tolerance:
+  std::vector<component_tolerance> pick_tolerances(const circuit &circ,
+    const size_t &count, std::mt19937_64 &rng)
+  {
+    std::vector<component *> parts;
+    list_parts(circ, parts);
+
+    std::vector<size_t> candidates;
+    for (size_t i{}; i < parts.size(); ++i) {
+      if (parts[i]->get_kind() != component_kind::circuit) {
+        candidates.push_back(i);
+      }
+    }
+    std::shuffle(candidates.begin(), candidates.end(), rng);
+
+    std::uniform_real_distribution<double> relative(0.01, 0.1);
+    std::vector<component_tolerance> tolerances;
+    for (size_t i{}; i < count && i < candidates.size(); ++i) {
+      tolerances.push_back(component_tolerance{candidates[i], relative(rng)});
+    }
+    return tolerances;
+  }
+
+  // Impedance with each tolerance at its top (bit set) or bottom:
+  std::complex<double> evaluate_corner(const circuit &circ,
+    const std::vector<component_tolerance> &tolerances,
+    const std::vector<bool> &high, const double &freq)
+  {
+    circuit copy{circ};
+    std::vector<component *> parts;
+    list_parts(copy, parts);
+
+    for (size_t k{}; k < tolerances.size(); ++k) {
+      component &part = *parts[tolerances[k].component];
+      double sign = high[k] ? 1.0 : -1.0;
+      part.set_value(part.get_value() * (1.0 + sign * tolerances[k].relative));
+    }
+    return copy.evaluate(freq);
+  }
+
+  double relative_error(const double &found, const double &expected)
+  {
+    return std::abs(found - expected) / std::abs(expected);
+  }
+
+  bool same_corner(const tolerance_corner &a, const tolerance_corner &b)
+  {
+    return a.high == b.high && a.impedance == b.impedance;
+  }
+
+  double seconds_since(const std::chrono::steady_clock::time_point &start)
+  {
+    return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  }
+}
+
+//------------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+  size_t count = (argc > 1) ? std::stoul(argv[1]) : 12;
+  const double freq = 2e3;
+
+  std::mt19937_64 rng{42};
+  double worst_error{};
+  bool passed = true;
+
+  for (auto shape : {circuit_shape::alternating, circuit_shape::deep_nesting,
+    circuit_shape::random_mix}) {
+    circuit circ = generate_circuit(shape, 60, 7);
+    std::vector<component_tolerance> tolerances = pick_tolerances(circ,
+      count, rng);
+
+    auto start = std::chrono::steady_clock::now();
+    corner_analysis found = find_worst_corners(circ, tolerances, freq, 0, 1);
+    double search_time = seconds_since(start);
+
+    // Every corner, and that each lies in the bound:
+    double max_magnitude{}, min_magnitude{}, max_phase{}, min_phase{};
+    bool inside = true;
+    start = std::chrono::steady_clock::now();
+    for (size_t mask{}; mask < (size_t{1} << tolerances.size()); ++mask) {
+      std::vector<bool> high(tolerances.size());
+      for (size_t k{}; k < tolerances.size(); ++k) {
+        high[k] = (mask >> k) & 1;
+      }
+
+      std::complex<double> z = evaluate_corner(circ, tolerances, high, freq);
+      if (mask == 0 || std::abs(z) > max_magnitude) {
+        max_magnitude = std::abs(z);
+      }
+      if (mask == 0 || std::abs(z) < min_magnitude) {
+        min_magnitude = std::abs(z);
+      }
+      if (mask == 0 || std::arg(z) > max_phase) {
+        max_phase = std::arg(z);
+      }
+      if (mask == 0 || std::arg(z) < min_phase) {
+        min_phase = std::arg(z);
+      }
+
+      if (std::abs(z - found.bound.center)
+        > found.bound.radius * (1 + 1e-9) + 1e-12 * std::abs(z)) {
+        inside = false;
+      }
+    }
+    double brute_time = seconds_since(start);
+
+    // Each reported corner is what evaluate() gives there:
+    double corner_error{};
+    for (const auto *corner : {&found.max_magnitude, &found.min_magnitude,
+      &found.max_phase, &found.min_phase}) {
+      std::complex<double> z = evaluate_corner(circ, tolerances,
+        corner->high, freq);
+      corner_error = std::max(corner_error,
+        std::abs(corner->impedance - z) / std::abs(z));
+    }
+
+    double error = std::max({corner_error,
+      relative_error(std::abs(found.max_magnitude.impedance), max_magnitude),
+      relative_error(std::abs(found.min_magnitude.impedance), min_magnitude),
+      std::abs(std::arg(found.max_phase.impedance) - max_phase),
+      std::abs(std::arg(found.min_phase.impedance) - min_phase)});
+    worst_error = std::max(worst_error, error);
+
+    corner_analysis threaded = find_worst_corners(circ, tolerances, freq, 0,
+      4);
+    bool same = same_corner(found.max_magnitude, threaded.max_magnitude)
+      && same_corner(found.min_magnitude, threaded.min_magnitude)
+      && same_corner(found.max_phase, threaded.max_phase)
+      && same_corner(found.min_phase, threaded.min_phase);
+
+    passed = passed && inside && same && found.complete;
+
+    std::cout << get_shape_name(shape) << ": " << tolerances.size()
+      << " tolerances, search " << search_time << " s (" << found.bounds
+      << " bounds), brute force " << brute_time << " s, worst difference "
+      << error << (inside ? "" : ", corner outside bound")
+      << (same ? "" : ", 1 and 4 threads differ") << '\n';
+  }
+
+  // Too many corners to enumerate, but a search wide enough (neighbouring
+  // parts interacting) to be split across threads:
+  circuit circ = generate_circuit(circuit_shape::random_mix, 2000, 3);
+  std::vector<component *> parts;
+  list_parts(circ, parts);
+
+  std::vector<component_tolerance> tolerances;
+  for (size_t i{}; i < parts.size() && tolerances.size() < 28; i += 37) {
+    if (parts[i]->get_kind() != component_kind::circuit) {
+      tolerances.push_back(component_tolerance{i, 0.05});
+    }
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  corner_analysis single = find_worst_corners(circ, tolerances, 5e3, 0, 1);
+  double single_time = seconds_since(start);
+
+  start = std::chrono::steady_clock::now();
+  corner_analysis threaded = find_worst_corners(circ, tolerances, 5e3, 0, 4);
+  double threaded_time = seconds_since(start);
+
+  bool same = same_corner(single.max_magnitude, threaded.max_magnitude)
+    && same_corner(single.min_magnitude, threaded.min_magnitude)
+    && same_corner(single.max_phase, threaded.max_phase)
+    && same_corner(single.min_phase, threaded.min_phase);
+  passed = passed && same && single.complete && threaded.complete;
+
+  std::cout << tolerances.size() << " tolerances of 2000 components: "
+    << single.bounds << " bounds, 1 thread " << single_time << " s, 4 threads "
+    << threaded_time << " s" << (same ? "" : ", corners differ") << '\n';
+
+  return (passed && worst_error < 1e-9) ? 0 : 1;
+}
@@ -0,0 +1,205 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Single fault simulation against evaluate() of each faulted circuit:
+//
+//   g++ -std=c++20 -O2 -pthread -I. benchmarks/fault_benchmark.cpp
+//     $(ls *.cpp | grep -v main.cpp) -o fault_benchmark   (one line)
+//   ./fault_benchmark [components]
+//------------------------------------------------------------------------------
+
+#include "fault.hpp"
+#include "generator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+
+using namespace circuits;
+
+//------------------------------------------------------------------------------
+
+namespace
+{
+  // Far enough from any real impedance to stand in for an open / short:
+  const double open_resistance = 1e150;
+  const double short_resistance = 1e-150;
+
+  // Same impedance at every frequency (any value, unlike a resistor):
+  class fixed_impedance : public component
+  {
+  public:
+    fixed_impedance(const double &res)
+    {
+      kind = component_kind::resistor;
+      impedance = res;
+    }
+
+    std::unique_ptr<component> clone() const
+    {
+      return std::make_unique<fixed_impedance>(*this);
+    }
+
+    void set_impedance() {}
+
+    std::complex<double> evaluate(const double &) const
+    {
+      return impedance;
+    }
+
+    void set_value(const double &res)
+    {
+      impedance = res;
+    }
+    double get_value() const
+    {
+      return impedance.real();
+    }
+
+    void set_frequency(const double &freq)
+    {
+      frequency = freq;
+    }
+    double get_frequency() const
+    {
+      return frequency;
+    }
+
+    std::complex<double> get_impedance_derivative() const
+    {
+      return 0.0;
+    }
+
+    void write_info(report_writer &) const {}
+  };
+
+  // Components (nested circuits included) below comp:
+  size_t count_inside(const component &comp)
+  {
+    size_t count{};
+    if (auto sub = dynamic_cast<const circuit *>(&comp)) {
+      for (const auto &inner : sub->get_components()) {
+        count += 1 + count_inside(*inner);
+      }
+    }
+    return count;
+  }
+
+  // Copy of circ with the component at depth first index target (the order
+  // of fault_table, index counting from the start of circ) replaced:
+  std::shared_ptr<circuit> replace_component(const circuit &circ,
+    const size_t &target, const double &res, size_t &index)
+  {
+    std::vector<std::shared_ptr<component>> comps;
+
+    for (const auto &comp : circ.get_components()) {
+      std::shared_ptr<component> comp_copy;
+
+      if (index == target) {
+        comp_copy = std::make_shared<fixed_impedance>(res);
+        index += 1 + count_inside(*comp);
+
+      } else if (auto sub = dynamic_cast<const circuit *>(comp.get())) {
+        ++index;
+        comp_copy = replace_component(*sub, target, res, index);
+
+      } else {
+        ++index;
+        comp_copy = comp->clone();
+      }
+
+      // Component copy constructors don't carry the connection data:
+      comp_copy->set_connection_type(comp->get_connection_type());
+      comp_copy->set_nested_bool(comp->get_nested_bool());
+      comps.push_back(comp_copy);
+    }
+
+    return std::make_shared<circuit>(circ.get_frequency(), circ.get_voltage(),
+      std::move(comps));
+  }
+
+  std::complex<double> evaluate_fault(const circuit &circ,
+    const size_t &target, const double &res, const double &freq)
+  {
+    size_t index{};
+    return replace_component(circ, target, res, index)->evaluate(freq);
+  }
+
+  // Relative difference (or 1 if only one of them is an open circuit):
+  double fault_error(const std::complex<double> &found,
+    const std::complex<double> &expected)
+  {
+    bool found_open = std::isinf(found.real());
+    bool expected_open = !(std::abs(expected) < 1e100);
+    if (found_open || expected_open) {
+      return (found_open == expected_open) ? 0.0 : 1.0;
+    }
+
+    // (a short across the whole circuit leaves about 1e-150 Ohms)
+    return std::abs(found - expected) / std::max(std::abs(expected), 1e-6);
+  }
+
+  double seconds_since(const std::chrono::steady_clock::time_point &start)
+  {
+    return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  }
+}
+
+//------------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+  size_t count = (argc > 1) ? std::stoul(argv[1]) : 300;
+  const std::vector<double> frequencies{10.3, 1.1e3, 47e3, 2.2e6};
+
+  double worst_error{};
+  bool same = true;
+
+  for (auto shape : {circuit_shape::alternating, circuit_shape::deep_nesting,
+    circuit_shape::random_mix}) {
+    circuit circ = generate_circuit(shape, count, 5);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<fault_table> single = simulate_faults(circ, frequencies, 1);
+    double fault_time = seconds_since(start);
+
+    std::vector<fault_table> threaded = simulate_faults(circ, frequencies,
+      4);
+    for (size_t f{}; f < frequencies.size(); ++f) {
+      same = same && single[f].open == threaded[f].open
+        && single[f].shorted == threaded[f].shorted;
+    }
+
+    double error{};
+    start = std::chrono::steady_clock::now();
+    for (size_t f{}; f < frequencies.size(); ++f) {
+      const fault_table &table = single[f];
+      for (size_t i{}; i < table.components.size(); ++i) {
+        error = std::max({error,
+          fault_error(table.open[i], evaluate_fault(circ, i,
+            open_resistance, frequencies[f])),
+          fault_error(table.shorted[i], evaluate_fault(circ, i,
+            short_resistance, frequencies[f]))});
+      }
+    }
+    double direct_time = seconds_since(start);
+    worst_error = std::max(worst_error, error);
+
+    std::cout << get_shape_name(shape) << ": "
+      << single[0].components.size() << " faults x " << frequencies.size()
+      << " frequencies, simulate_faults() " << fault_time
+      << " s, evaluate() of each " << direct_time
+      << " s, worst relative difference " << error << '\n';
+  }
+
+  if (!same) {
+    std::cout << "1 and 4 threads differ" << '\n';
+  }
+
+  return (same && worst_error < 1e-9) ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Virtual component path vs flat_circuit (type batched, no virtual calls):
+//
+//   g++ -std=c++20 -O2 -pthread -I. benchmarks/flat_circuit_benchmark.cpp
+//     $(ls *.cpp | grep -v main.cpp) -o flat_benchmark   (one line)
+//   ./flat_benchmark [components] [frequencies]
+//------------------------------------------------------------------------------
+
+#include "flat_circuit.hpp"
+#include "resistors.hpp"
+#include "capacitors.hpp"
+#include "inductors.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace circuits;
+
+//------------------------------------------------------------------------------
+
+namespace
+{
+  // Random mix of the six types, runs of series / parallel connections:
+  circuit make_random_circuit(const size_t &count, std::mt19937_64 &rng)
+  {
+    std::uniform_int_distribution<int> pick_type(0, 5);
+    std::uniform_real_distribution<double> scale(0.5, 2.0);
+    std::bernoulli_distribution switch_connection(0.2);
+
+    std::vector<std::shared_ptr<component>> comps;
+    comps.reserve(count);
+    char conn = 's';
+
+    for (size_t i{}; i < count; ++i) {
+      double res = 100 * scale(rng);
+      double ind = 1e-3 * scale(rng);
+      double cap = 1e-6 * scale(rng);
+
+      std::shared_ptr<component> comp;
+      switch (pick_type(rng)) {
+        case 0: comp = std::make_shared<resistor>(res); break;
+        case 1: comp = std::make_shared<capacitor>(cap); break;
+        case 2: comp = std::make_shared<inductor>(ind); break;
+        case 3: comp = std::make_shared<real_resistor>(res, 1e-9, 1e-12); break;
+        case 4: comp = std::make_shared<real_capacitor>(0.1, 1e-9, cap); break;
+        default: comp = std::make_shared<real_inductor>(0.5, ind, 1e-12); break;
+      }
+
+      if (switch_connection(rng)) {
+        conn = (conn == 's') ? 'p' : 's';
+      }
+      comp->set_connection_type(conn);
+      comps.push_back(comp);
+    }
+
+    return circuit{50, 1, std::move(comps)};
+  }
+
+  double seconds_since(const std::chrono::steady_clock::time_point &start)
+  {
+    return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  }
+}
+
+//------------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+  size_t count = (argc > 1) ? std::stoul(argv[1]) : 10000;
+  size_t sweeps = (argc > 2) ? std::stoul(argv[2]) : 200;
+
+  std::mt19937_64 rng{42};
+  circuit circ = make_random_circuit(count, rng);
+  flat_circuit flat{circ};
+
+  std::vector<double> frequencies(sweeps);
+  for (size_t i{}; i < sweeps; ++i) {
+    frequencies[i] = 10 * std::pow(1e5, double(i) / sweeps);
+  }
+
+  // Virtual path:
+  std::vector<std::complex<double>> virtual_results(sweeps);
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i{}; i < sweeps; ++i) {
+    circ.set_frequency(frequencies[i]);
+    virtual_results[i] = circ.get_impedance();
+  }
+  double virtual_time = seconds_since(start);
+
+  // Flat path:
+  std::vector<std::complex<double>> flat_results(sweeps);
+  start = std::chrono::steady_clock::now();
+  for (size_t i{}; i < sweeps; ++i) {
+    flat.set_frequency(frequencies[i]);
+    flat_results[i] = flat.get_impedance();
+  }
+  double flat_time = seconds_since(start);
+
+  double worst_error{};
+  for (size_t i{}; i < sweeps; ++i) {
+    double error = std::abs(flat_results[i] - virtual_results[i])
+      / std::abs(virtual_results[i]);
+    worst_error = std::max(worst_error, error);
+  }
+
+  double evaluations = double(count) * sweeps;
+
+  std::cout << count << " components, " << sweeps << " frequencies\n"
+    << "virtual: " << virtual_time << " s ("
+    << (1e9 * virtual_time / evaluations) << " ns / component)\n"
+    << "flat:    " << flat_time << " s ("
+    << (1e9 * flat_time / evaluations) << " ns / component)\n"
+    << "speed up: " << (virtual_time / flat_time) << "x\n"
+    << "worst relative difference: " << worst_error << std::endl;
+
+  return (worst_error < 1e-9) ? 0 : 1;
+}
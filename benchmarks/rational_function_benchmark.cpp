@@ -0,0 +1,143 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Circuit evaluate() vs its compiled rational function (and freeze()):
+//
+//   g++ -std=c++20 -O2 -pthread -I. benchmarks/rational_function_benchmark.cpp
+//     $(ls *.cpp | grep -v main.cpp) -o rational_benchmark   (one line)
+//   ./rational_benchmark [frequencies]
+//------------------------------------------------------------------------------
+
+#include "rational_function.hpp"
+#include "frozen_circuit.hpp"
+#include "resistors.hpp"
+#include "capacitors.hpp"
+#include "inductors.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace circuits;
+
+//------------------------------------------------------------------------------
+
+namespace
+{
+  // Alternating L / C sections with equal values, nested three times, so
+  // the normalised centre frequency sits on a resonance (order above the
+  // Horner limit, so the factored form is used):
+  circuit make_lc_circuit()
+  {
+    circuit section{50, 1};
+    for (size_t i{}; i < 16; ++i) {
+      char conn = ((i / 2) % 2 == 1) ? 'p' : 's';
+      if (i % 2 == 1) {
+        section.emplace_component<capacitor>(conn, false, 1e-6);
+      } else {
+        section.emplace_component<inductor>(conn, false, 1e-3);
+      }
+    }
+
+    circuit circ{50, 1};
+    for (size_t i{}; i < 3; ++i) {
+      auto sub = std::make_shared<circuit>(section);
+      circ.add_component(sub, (i == 1) ? 'p' : 's', true);
+      circ.emplace_component<inductor>('s', false, 1e-3);
+      circ.emplace_component<capacitor>('p', false, 1e-6);
+    }
+    return circ;
+  }
+
+  // Small random mix of resistors, capacitors and inductors:
+  circuit make_rlc_circuit(std::mt19937_64 &rng)
+  {
+    std::uniform_int_distribution<int> pick_type(0, 2);
+    std::uniform_real_distribution<double> scale(0.5, 2.0);
+    std::bernoulli_distribution switch_connection(0.3);
+
+    circuit circ{50, 1};
+    char conn = 's';
+    for (size_t i{}; i < 12; ++i) {
+      if (switch_connection(rng)) {
+        conn = (conn == 's') ? 'p' : 's';
+      }
+
+      switch (pick_type(rng)) {
+        case 0: circ.emplace_component<resistor>(conn, false,
+          100 * scale(rng)); break;
+        case 1: circ.emplace_component<capacitor>(conn, false,
+          1e-6 * scale(rng)); break;
+        default: circ.emplace_component<inductor>(conn, false,
+          1e-3 * scale(rng)); break;
+      }
+    }
+    return circ;
+  }
+
+  double seconds_since(const std::chrono::steady_clock::time_point &start)
+  {
+    return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  }
+
+  // Prints timings and returns the worst relative difference:
+  double compare(const std::string &name, const circuit &circ,
+    const std::vector<double> &frequencies)
+  {
+    rational_function compiled = compile_circuit(circ);
+    std::shared_ptr<frozen_circuit> frozen = circ.freeze();
+
+    std::vector<std::complex<double>> direct(frequencies.size());
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i{}; i < frequencies.size(); ++i) {
+      direct[i] = circ.evaluate(frequencies[i]);
+    }
+    double direct_time = seconds_since(start);
+
+    std::vector<std::complex<double>> fitted(frequencies.size());
+    start = std::chrono::steady_clock::now();
+    for (size_t i{}; i < frequencies.size(); ++i) {
+      fitted[i] = compiled.evaluate(frequencies[i]);
+    }
+    double compiled_time = seconds_since(start);
+
+    double worst_error{};
+    for (size_t i{}; i < frequencies.size(); ++i) {
+      double scale = std::abs(direct[i]);
+      worst_error = std::max({worst_error,
+        std::abs(fitted[i] - direct[i]) / scale,
+        std::abs(frozen->evaluate(frequencies[i]) - direct[i]) / scale});
+    }
+
+    std::cout << name << ": order " << compiled.get_order()
+      << ", evaluate() " << direct_time << " s, compiled "
+      << compiled_time << " s, worst relative difference "
+      << worst_error << '\n';
+    return worst_error;
+  }
+}
+
+//------------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+  size_t sweeps = (argc > 1) ? std::stoul(argv[1]) : 2000;
+
+  // Avoids landing exactly on a pole of the LC circuit:
+  std::vector<double> frequencies(sweeps);
+  for (size_t i{}; i < sweeps; ++i) {
+    frequencies[i] = 10.3 * std::pow(1e5, double(i) / sweeps);
+  }
+
+  std::mt19937_64 rng{42};
+  double worst_error = compare("LC only", make_lc_circuit(), frequencies);
+  worst_error = std::max(worst_error,
+    compare("RLC mix", make_rlc_circuit(rng), frequencies));
+
+  return (worst_error < 1e-9) ? 0 : 1;
+}
@@ -0,0 +1,309 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Time and peak memory of every evaluation path on generated circuits:
+//
+//   g++ -std=c++20 -O2 -pthread -I. benchmarks/scaling_benchmark.cpp
+//     $(ls *.cpp | grep -v main.cpp) -o scaling_benchmark   (one line)
+//   ./scaling_benchmark [max size] [seconds per run] [seed] [shapes...]
+//
+// Sizes go up in powers of ten from 10 to max size (default 10^6, 10^7 needs
+// several GB). Each run is a separate process, so peak RSS is that run's
+// alone, and is killed once over the time limit (larger sizes of that path
+// are then skipped for the shape). Time is for the path only, not for
+// generating the circuit it works on.
+//------------------------------------------------------------------------------
+
+#include "generator.hpp"
+#include "flat_circuit.hpp"
+#include "nodal.hpp"
+#include "fault.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace circuits;
+
+//------------------------------------------------------------------------------
+
+namespace
+{
+  // Exit codes of a run:
+  const int run_ok = 0;
+  const int run_not_applicable = 3;
+  const int run_failed = 4;
+
+  const char *const paths[] = {"generate", "add_component", "set_impedance",
+    "copy", "print_components", "print_diagram", "flat_circuit", "nodal",
+    "faults"};
+
+  const int frequency_count = 10;
+
+  double seconds_since(const std::chrono::steady_clock::time_point &start)
+  {
+    return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  }
+
+//------------------------------------------------------------------------------
+
+  // Adds the components of circ between nodes from and to (each parallel run
+  // between two nodes, series components one after another):
+  void expand_nodal(const circuit &circ, nodal_circuit &nodal,
+    const size_t &from, const size_t &to)
+  {
+    const auto &comps = circ.get_components();
+    size_t node = from;
+
+    auto attach = [&](const std::shared_ptr<component> &comp,
+      const size_t &a, const size_t &b) {
+      if (auto sub = std::dynamic_pointer_cast<circuit>(comp)) {
+        expand_nodal(*sub, nodal, a, b);
+      } else {
+        nodal.add_element(a, b, comp);
+      }
+    };
+
+    for (size_t i{}; i < comps.size();) {
+      char conn = comps[i]->get_connection_type();
+      size_t j{i};
+      while (j < comps.size() && comps[j]->get_connection_type() == conn) {
+        ++j;
+      }
+      bool last_run = (j == comps.size());
+
+      if (conn == 'p') {
+        size_t next = last_run ? to : nodal.add_node();
+        for (size_t k{i}; k < j; ++k) {
+          attach(comps[k], node, next);
+        }
+        node = next;
+
+      } else {
+        for (size_t k{i}; k < j; ++k) {
+          size_t next = (last_run && k + 1 == j) ? to : nodal.add_node();
+          attach(comps[k], node, next);
+          node = next;
+        }
+      }
+
+      i = j;
+    }
+  }
+
+//------------------------------------------------------------------------------
+
+  // Runs one path (in the child process), returning its time:
+  double run_path(const std::string &path, const circuit_shape &shape,
+    const size_t &size, const uint64_t &seed)
+  {
+    if (path == "add_component") {
+      auto start = std::chrono::steady_clock::now();
+      circuit circ = generate_circuit_incrementally(shape, size, seed);
+      return seconds_since(start);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    circuit circ = generate_circuit(shape, size, seed);
+    double generate_time = seconds_since(start);
+
+    if (path == "generate") {
+      return generate_time;
+    }
+
+    start = std::chrono::steady_clock::now();
+
+    if (path == "set_impedance") {
+      for (int i{}; i < frequency_count; ++i) {
+        circ.set_frequency(100.0 * (i + 1));
+      }
+      return seconds_since(start) / frequency_count;
+
+    } else if (path == "copy") {
+      circuit copy{circ};
+      return seconds_since(start);
+
+    } else if (path == "print_components") {
+      circ.print_components();
+      std::cout.flush();
+      return seconds_since(start);
+
+    } else if (path == "print_diagram") {
+      circ.print_diagram();
+      std::cout.flush();
+      return seconds_since(start);
+
+    } else if (path == "flat_circuit") {
+      // Conversion once, then evaluation as for set_impedance:
+      flat_circuit flat{circ};
+      for (int i{}; i < frequency_count; ++i) {
+        flat.set_frequency(100.0 * (i + 1));
+      }
+      return seconds_since(start);
+
+    } else if (path == "nodal") {
+      // Conversion and analysis once, then evaluation:
+      nodal_circuit nodal{2, 0, 1};
+      expand_nodal(circ, nodal, 0, 1);
+      for (int i{}; i < frequency_count; ++i) {
+        nodal.get_impedance(100.0 * (i + 1));
+      }
+      return seconds_since(start);
+
+    } else if (path == "faults") {
+      // Every open and short at one frequency:
+      simulate_faults(circ, 1e3);
+      return seconds_since(start);
+    }
+
+    throw std::invalid_argument{"Unknown path " + path + "."};
+  }
+
+  struct run_result
+  {
+    // ok, n/a, failed or timeout:
+    std::string status;
+    double seconds = 0;
+    double peak_mb = 0;
+  };
+
+  // Forks a process for the run so its peak RSS and time limit are its own:
+  run_result run_isolated(const std::string &path, const circuit_shape &shape,
+    const size_t &size, const uint64_t &seed, const unsigned &limit)
+  {
+    int channel[2];
+    if (pipe(channel) != 0) {
+      throw std::runtime_error{"Could not create pipe."};
+    }
+
+    std::cout.flush();
+    pid_t child = fork();
+
+    if (child < 0) {
+      throw std::runtime_error{"Could not fork."};
+    }
+
+    if (child == 0) {
+      close(channel[0]);
+
+      // Printing paths write to stdout, which shouldn't fill the report:
+      int null_fd = open("/dev/null", O_WRONLY);
+      dup2(null_fd, STDOUT_FILENO);
+      alarm(limit);
+
+      int code = run_ok;
+      double seconds{};
+      try {
+        seconds = run_path(path, shape, size, seed);
+      }
+      catch (const std::invalid_argument &) {
+        code = run_not_applicable;
+      }
+      catch (...) {
+        code = run_failed;
+      }
+
+      ssize_t written = write(channel[1], &seconds, sizeof(seconds));
+      _exit((written == sizeof(seconds)) ? code : run_failed);
+    }
+
+    close(channel[1]);
+    double seconds{};
+    ssize_t got = read(channel[0], &seconds, sizeof(seconds));
+    close(channel[0]);
+
+    int status{};
+    struct rusage usage{};
+    wait4(child, &status, 0, &usage);
+
+    run_result result;
+    result.peak_mb = usage.ru_maxrss / 1024.0;
+    result.seconds = seconds;
+
+    if (WIFSIGNALED(status)) {
+      result.status = (WTERMSIG(status) == SIGALRM) ? "timeout" : "failed";
+    } else if (got != sizeof(seconds) || WEXITSTATUS(status) == run_failed) {
+      result.status = "failed";
+    } else if (WEXITSTATUS(status) == run_not_applicable) {
+      result.status = "n/a";
+    } else {
+      result.status = "ok";
+    }
+
+    return result;
+  }
+}
+
+//------------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+  size_t max_size = (argc > 1) ? std::stoul(argv[1]) : 1000000;
+  unsigned limit = (argc > 2) ? std::stoul(argv[2]) : 20;
+  uint64_t seed = (argc > 3) ? std::stoull(argv[3]) : 1;
+
+  std::vector<circuit_shape> shapes;
+  for (int i{4}; i < argc; ++i) {
+    shapes.push_back(parse_shape_name(argv[i]));
+  }
+  if (shapes.empty()) {
+    shapes = {circuit_shape::series_chain, circuit_shape::parallel_bank,
+      circuit_shape::alternating, circuit_shape::deep_nesting,
+      circuit_shape::random_mix};
+  }
+
+  std::cout << std::left << std::setw(15) << "shape" << std::setw(10)
+    << "size" << std::setw(18) << "path" << std::setw(14) << "seconds"
+    << std::setw(14) << "peak RSS MB" << "status" << std::endl;
+
+  bool any_failed = false;
+
+  for (const auto &shape : shapes) {
+    // Paths that ran out of time at a smaller size:
+    std::map<std::string, bool> given_up;
+
+    for (size_t size{10}; size <= max_size; size *= 10) {
+      for (const auto &path : paths) {
+        std::cout << std::setw(15) << get_shape_name(shape) << std::setw(10)
+          << size << std::setw(18) << path;
+
+        if (given_up[path]) {
+          std::cout << std::setw(14) << "-" << std::setw(14) << "-"
+            << "skipped" << std::endl;
+          continue;
+        }
+
+        run_result result = run_isolated(path, shape, size, seed, limit);
+
+        if (result.status == "ok") {
+          std::cout << std::setw(14) << std::setprecision(4)
+            << std::scientific << result.seconds;
+        } else {
+          std::cout << std::setw(14) << "-";
+        }
+
+        std::cout << std::setw(14) << std::setprecision(1) << std::fixed
+          << result.peak_mb << result.status << std::endl;
+
+        given_up[path] = (result.status == "timeout");
+        any_failed = any_failed || (result.status == "failed");
+      }
+    }
+  }
+
+  return any_failed ? 1 : 0;
+}
@@ -0,0 +1,178 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Yield estimates against plain Monte Carlo through evaluate():
+//
+//   g++ -std=c++20 -O2 -pthread -I. benchmarks/yield_benchmark.cpp
+//     $(ls *.cpp | grep -v main.cpp) -o yield_benchmark   (one line)
+//   ./yield_benchmark [reference samples]
+//------------------------------------------------------------------------------
+
+#include "sampling.hpp"
+#include "generator.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+using namespace circuits;
+
+//------------------------------------------------------------------------------
+
+namespace
+{
+  // Components in depth first order (tolerance indices), to set values on:
+  void list_parts(const circuit &circ, std::vector<component *> &parts)
+  {
+    for (const auto &comp : circ.get_components()) {
+      parts.push_back(comp.get());
+      if (auto sub = dynamic_cast<const circuit *>(comp.get())) {
+        list_parts(*sub, parts);
+      }
+    }
+  }
+
+  bool meets_limits(const circuit &circ,
+    const std::vector<impedance_limits> &limits)
+  {
+    for (const auto &l : limits) {
+      std::complex<double> z = circ.evaluate(l.frequency);
+      if (std::abs(z) < l.min_magnitude || std::abs(z) > l.max_magnitude
+        || std::arg(z) < l.min_phase || std::arg(z) > l.max_phase) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Fraction of count pseudo random points passing, each set on a copy of
+  // the circuit and evaluated directly:
+  double reference_yield(const circuit &circ,
+    const std::vector<component_tolerance> &tolerances,
+    const std::vector<impedance_limits> &limits, const size_t &count)
+  {
+    circuit copy{circ};
+    std::vector<component *> parts;
+    list_parts(copy, parts);
+
+    std::vector<double> nominal;
+    for (const auto &tol : tolerances) {
+      nominal.push_back(parts[tol.component]->get_value());
+    }
+
+    std::vector<double> points = generate_samples(
+      sampling_mode::pseudo_random, count, tolerances.size(), 12345);
+
+    size_t passed{};
+    for (size_t i{}; i < count; ++i) {
+      for (size_t k{}; k < tolerances.size(); ++k) {
+        double u = points[i * tolerances.size() + k];
+        parts[tolerances[k].component]->set_value(nominal[k]
+          * (1.0 + tolerances[k].relative * (2.0 * u - 1.0)));
+      }
+      passed += meets_limits(copy, limits);
+    }
+
+    return double(passed) / count;
+  }
+
+  double seconds_since(const std::chrono::steady_clock::time_point &start)
+  {
+    return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  }
+}
+
+//------------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+  size_t count = (argc > 1) ? std::stoul(argv[1]) : 1 << 17;
+  bool passed = true;
+
+  circuit circ = generate_circuit(circuit_shape::random_mix, 300, 9);
+  std::vector<component *> parts;
+  list_parts(circ, parts);
+
+  std::vector<component_tolerance> tolerances;
+  for (size_t i{}; i < parts.size() && tolerances.size() < 16; i += 7) {
+    if (parts[i]->get_kind() != component_kind::circuit) {
+      tolerances.push_back(component_tolerance{i, 0.1});
+    }
+  }
+
+  // Magnitude limits at two frequencies, over the inner part of what the
+  // tolerances can reach (so some points fail):
+  std::vector<impedance_limits> limits;
+  std::vector<impedance_limits> wide_limits;
+  for (double freq : {1.3e3, 27e3}) {
+    impedance_bound bound = bound_impedance(circ, tolerances, freq);
+    double nominal = std::abs(circ.evaluate(freq));
+    double spread = bound.max_magnitude - bound.min_magnitude;
+
+    impedance_limits l{freq};
+    l.min_magnitude = nominal - 0.15 * spread;
+    l.max_magnitude = nominal + 0.15 * spread;
+    limits.push_back(l);
+
+    // Every point is inside the bound, so passes these:
+    impedance_limits wide{freq, bound.min_magnitude, bound.max_magnitude,
+      bound.min_phase, bound.max_phase};
+    wide_limits.push_back(wide);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  double reference = reference_yield(circ, tolerances, limits, count);
+  double reference_time = seconds_since(start);
+  double reference_error = std::sqrt(reference * (1 - reference) / count);
+
+  std::cout << tolerances.size() << " tolerances of " << parts.size()
+    << " components, evaluate() reference " << reference << " +/- "
+    << reference_error << " (" << count << " points, " << reference_time
+    << " s)" << '\n';
+
+  for (auto mode : {sampling_mode::pseudo_random,
+    sampling_mode::latin_hypercube, sampling_mode::sobol,
+    sampling_mode::halton}) {
+    yield_options options;
+    options.mode = mode;
+    options.seed = 7;
+    options.target_half_width = 2e-3;
+    options.threads = 1;
+
+    start = std::chrono::steady_clock::now();
+    yield_estimate single = estimate_yield(circ, tolerances, limits, options);
+    double yield_time = seconds_since(start);
+
+    options.threads = 4;
+    yield_estimate threaded = estimate_yield(circ, tolerances, limits,
+      options);
+    bool same = single.yield == threaded.yield
+      && single.samples == threaded.samples
+      && single.standard_error == threaded.standard_error;
+
+    // Within 4 standard errors of the reference (both estimates are
+    // random, but seeded, so this passes or fails the same every run):
+    double difference = std::abs(single.yield - reference);
+    bool close = difference <= 4 * std::hypot(single.standard_error,
+      reference_error);
+
+    yield_estimate wide = estimate_yield(circ, tolerances, wide_limits,
+      options);
+    bool all_pass = (wide.yield == 1.0);
+
+    passed = passed && same && close && all_pass;
+
+    std::cout << get_sampling_name(mode) << ": yield " << single.yield
+      << " +/- " << single.standard_error << " (" << single.samples
+      << " points, " << yield_time << " s), difference " << difference
+      << (close ? "" : ", too far from reference")
+      << (same ? "" : ", 1 and 4 threads differ")
+      << (all_pass ? "" : ", points outside the corner bound fail") << '\n';
+  }
+
+  return passed ? 0 : 1;
+}
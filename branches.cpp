@@ -0,0 +1,89 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Voltage, current and power of every component:
+//------------------------------------------------------------------------------
+
+#include "branches.hpp"
+#include "folded_program.hpp"
+#include "impedance_tree.hpp"
+#include "parallel.hpp"
+
+using namespace circuits;
+
+//------------------------------------------------------------------------------
+// Helper functions (only used in this file):
+//------------------------------------------------------------------------------
+
+namespace
+{
+  template <class F> void propagate_source(const circuit &circ,
+    const double &freq, F write)
+  {
+    impedance_tree tree = build_impedance_tree(circ, freq);
+
+    std::complex<double> current = circ.get_voltage() / tree.total;
+    propagate_current(circ, tree, current, write);
+  }
+}
+
+//------------------------------------------------------------------------------
+
+std::vector<branch_state> circuits::find_branch_states(const circuit &circ,
+  const double &freq)
+{
+  std::vector<branch_state> states;
+
+  propagate_source(circ, freq, [&](const size_t &, const component *part,
+    const std::complex<double> &voltage, const std::complex<double> &current) {
+    states.push_back(branch_state{part, voltage, current,
+      voltage * std::conj(current)});
+  });
+
+  return states;
+}
+
+//------------------------------------------------------------------------------
+
+branch_sweep circuits::sweep_branch_states(const circuit &circ,
+  const std::vector<double> &frequencies, const size_t &threads)
+{
+  branch_sweep sweep;
+  sweep.frequencies = frequencies;
+
+  // Same order at every frequency, so listed once:
+  list_components(circ, sweep.components);
+
+  size_t rows = frequencies.size();
+  size_t count = sweep.components.size();
+  sweep.voltage_real.resize(rows * count);
+  sweep.voltage_imag.resize(rows * count);
+  sweep.current_real.resize(rows * count);
+  sweep.current_imag.resize(rows * count);
+  sweep.real_power.resize(rows * count);
+  sweep.reactive_power.resize(rows * count);
+
+  parallel_for(rows, [&](const size_t &f) {
+    size_t row = f * count;
+
+    propagate_source(circ, frequencies[f], [&](const size_t &i,
+      const component *, const std::complex<double> &voltage,
+      const std::complex<double> &current) {
+      std::complex<double> power = voltage * std::conj(current);
+
+      sweep.voltage_real[row + i] = voltage.real();
+      sweep.voltage_imag[row + i] = voltage.imag();
+      sweep.current_real[row + i] = current.real();
+      sweep.current_imag[row + i] = current.imag();
+      sweep.real_power[row + i] = power.real();
+      sweep.reactive_power[row + i] = power.imag();
+    });
+  }, threads);
+
+  return sweep;
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,69 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Voltage, current and power of every component:
+//------------------------------------------------------------------------------
+
+#ifndef branches_hpp
+#define branches_hpp
+
+#include "circuit.hpp"
+
+//------------------------------------------------------------------------------
+// The source (the circuit's voltage, RMS, at phase 0) drives I = V / Z
+// through the circuit. Going down the same series / parallel runs as
+// set_impedance(), a series run passes its current to every component
+// (v = i z), and a parallel run puts its voltage (v = i Z_run) across every
+// component (i = v / z), nested circuits the same with their own current.
+// One pass after finding every impedance, so O(n) per frequency.
+//
+// Power is S = v conj(i): real part dissipated (W), imaginary part reactive
+// (VAR). Impedances must be finite and non zero for the split to be defined.
+//------------------------------------------------------------------------------
+
+namespace circuits
+{
+  struct branch_state
+  {
+    const component *part;
+    std::complex<double> voltage;
+    std::complex<double> current;
+    std::complex<double> power;
+  };
+
+  // Results of a sweep as separate arrays, one row of components per
+  // frequency (row f, component i at [f * components.size() + i]):
+  struct branch_sweep
+  {
+    // Every component in depth first order (as fault_table):
+    std::vector<const component *> components;
+    std::vector<double> frequencies;
+
+    std::vector<double> voltage_real;
+    std::vector<double> voltage_imag;
+    std::vector<double> current_real;
+    std::vector<double> current_imag;
+
+    // Dissipated (W) and reactive (VAR) power:
+    std::vector<double> real_power;
+    std::vector<double> reactive_power;
+  };
+
+//------------------------------------------------------------------------------
+
+  // Every component at freq (Hz), depth first order, circuit unchanged:
+  std::vector<branch_state> find_branch_states(const circuit &circ,
+    const double &freq);
+
+  // Every component at each frequency, rows written straight into the
+  // arrays, frequencies split across threads (0 = one per core):
+  branch_sweep sweep_branch_states(const circuit &circ,
+    const std::vector<double> &frequencies, const size_t &threads = 0);
+}
+
+//------------------------------------------------------------------------------
+#endif
+//------------------------------------------------------------------------------
@@ -22,8 +22,7 @@ std::unique_ptr<component> capacitor::clone() const
 // Default constructor:
 capacitor::capacitor()
 {
-  type = "capacitor";
-  symbol = 'C';
+  kind = component_kind::capacitor;
   capacitance = 0;
   set_impedance();
 }
@@ -43,8 +42,7 @@ capacitor::capacitor(const double &cap)
     throw std::out_of_range{"Capacitance must be below 1 kF."};
   }
 
-  type = "capacitor";
-  symbol = 'C';
+  kind = component_kind::capacitor;
   capacitance = cap;
   set_impedance();
 }
@@ -54,8 +52,7 @@ capacitor::capacitor(const double &cap)
 // Copy constructor:
 capacitor::capacitor(const capacitor &capac)
 {
-  type = capac.type;
-  symbol = capac.symbol;
+  kind = capac.kind;
   impedance = capac.impedance;
   frequency = capac.frequency;
   capacitance = capac.capacitance;
@@ -67,15 +64,13 @@ capacitor::capacitor(const capacitor &capac)
 capacitor::capacitor(capacitor &&capac)
 {
   // Steal the data:
-  type = capac.type;
-  symbol = capac.symbol;
+  kind = capac.kind;
   impedance = capac.impedance;
   frequency = capac.frequency;
   capacitance = capac.capacitance;
 
   // Empty 'old' capacitor data:
-  capac.type = "empty";
-  capac.symbol = 'N';
+  capac.kind = component_kind::empty;
   capac.impedance = 0;
   capac.frequency = 0;
   capac.capacitance = 0;
@@ -90,10 +85,19 @@ capacitor::~capacitor() {}
 // Access Functions:
 //------------------------------------------------------------------------------
 
+std::complex<double> capacitor::evaluate(const double &freq) const
+{
+  if (freq < 0.0) {
+    throw std::out_of_range{"Cannot have negative frequency."};
+  }
+
+  double omega = (2 * M_PI * freq);
+  return std::complex<double>{0.0, (-1.0 / (omega * capacitance))};
+}
+
 void capacitor::set_impedance()
 {
-  double omega = (2 * M_PI * frequency);
-  impedance = std::complex<double>{0.0, (-1.0 / (omega * capacitance))};
+  impedance = evaluate(frequency);
 }
 
 //------------------------------------------------------------------------------
@@ -154,18 +158,19 @@ double capacitor::get_frequency() const
   return frequency;
 }
 
+// Z = -j / (2 pi f C), so dZ/df = j / (2 pi f^2 C):
+std::complex<double> capacitor::get_impedance_derivative() const
+{
+  return std::complex<double>{
+    0.0, (1.0 / (2 * M_PI * pow(frequency, 2) * capacitance))};
+}
+
 //------------------------------------------------------------------------------
 
-void capacitor::print_info() const
+void capacitor::write_info(circuits::report_writer &out) const
 {
-  if (capacitance <= 1e-2 || capacitance >= 1e3) {
-    std::cout << std::scientific;
-
-  } else {
-    std::cout << std::fixed;
-  }
-  std::cout << "Capacitor:" << std::endl
-  << "    Capacitance, C = " << capacitance << " F." << std::endl;
+  out << "Capacitor:" << '\n'
+  << "    Capacitance, C = " << capacitance << " F." << '\n';
 }
 
 
@@ -182,8 +187,7 @@ std::unique_ptr<component> real_capacitor::clone() const
 // Default constructor:
 real_capacitor::real_capacitor()
 {
-  type = "real capacitor";
-  symbol = 'c';
+  kind = component_kind::real_capacitor;
   capacitance = 0;
   resistance = 0;
   inductance = 0;
@@ -226,8 +230,7 @@ real_capacitor::real_capacitor(
 
 //------------------------------------------------------------------------------
 
-  type = "real capacitor";
-  symbol = 'c';
+  kind = component_kind::real_capacitor;
   capacitance = cap;
   resistance = res;
   inductance = ind;
@@ -239,8 +242,7 @@ real_capacitor::real_capacitor(
 // Copy constructor:
 real_capacitor::real_capacitor(const real_capacitor &capac)
 {
-  type = capac.type;
-  symbol = capac.symbol;
+  kind = capac.kind;
   impedance = capac.impedance;
   frequency = capac.frequency;
   capacitance = capac.capacitance;
@@ -254,8 +256,7 @@ real_capacitor::real_capacitor(const real_capacitor &capac)
 real_capacitor::real_capacitor(real_capacitor &&capac)
 {
   // Steal the data:
-  type = capac.type;
-  symbol = capac.symbol;
+  kind = capac.kind;
   impedance = capac.impedance;
   frequency = capac.frequency;
   capacitance = capac.capacitance;
@@ -263,8 +264,7 @@ real_capacitor::real_capacitor(real_capacitor &&capac)
   inductance = capac.inductance;
 
   // Empty 'old' real_capacitor data:
-  capac.type = "empty";
-  capac.symbol = 'N';
+  capac.kind = component_kind::empty;
   capac.impedance = 0;
   capac.frequency = 0;
   capac.capacitance = 0;
@@ -281,49 +281,62 @@ real_capacitor::~real_capacitor() {}
 // Access Functions:
 //------------------------------------------------------------------------------
 
-void real_capacitor::set_impedance()
+std::complex<double> real_capacitor::evaluate(const double &freq) const
 {
+  if (freq < 0.0) {
+    throw std::out_of_range{"Cannot have negative frequency."};
+  }
+
   // Break up into smaller calcs:
-  double omega = (2 * M_PI * frequency);
+  double omega = (2 * M_PI * freq);
   double fraction = (1 / (omega * capacitance));
   double imag_part = (omega * inductance) - fraction;
 
-  impedance = std::complex<double>{resistance, imag_part};
+  return std::complex<double>{resistance, imag_part};
+}
+
+void real_capacitor::set_impedance()
+{
+  impedance = evaluate(frequency);
 }
 
 //------------------------------------------------------------------------------
 
-void real_capacitor::print_info() const
+// Z = R + j(2 pi f L - 1 / (2 pi f C)), so only the reactance changes:
+std::complex<double> real_capacitor::get_impedance_derivative() const
 {
-  std::cout << "Non-ideal capacitor:" << std::endl;
+  double imag_part = (2 * M_PI * inductance)
+    + (1.0 / (2 * M_PI * pow(frequency, 2) * capacitance));
 
-  // Converts to scientific notation:
-  if (resistance <= 1e-2 || resistance >= 1e3) {
-    std::cout << std::scientific;
+  return std::complex<double>{0.0, imag_part};
+}
 
-  } else {
-    std::cout << std::fixed;
-  }
+//------------------------------------------------------------------------------
 
-  std::cout << "    Resistance, R = " << resistance << " Ohms," << std::endl;
+double real_capacitor::get_resistance() const
+{
+  return resistance;
+}
 
-  if (inductance <= 1e-2 || inductance >= 1e3) {
-    std::cout << std::scientific;
+double real_capacitor::get_inductance() const
+{
+  return inductance;
+}
 
-  } else {
-    std::cout << std::fixed;
-  }
+//------------------------------------------------------------------------------
 
-  std::cout << "    Inductance, L = " << inductance << " H," << std::endl;
+void real_capacitor::write_info(circuits::report_writer &out) const
+{
+  out << "Non-ideal capacitor:" << '\n';
 
-  if (capacitance <= 1e-2 || capacitance >= 1e3) {
-    std::cout << std::scientific;
 
-  } else {
-    std::cout << std::fixed;
-  }
+  out << "    Resistance, R = " << resistance << " Ohms," << '\n';
+
+
+  out << "    Inductance, L = " << inductance << " H," << '\n';
+
 
-  std::cout << "    Capacitance, C = " << capacitance << " F." << std::endl;
+  out << "    Capacitance, C = " << capacitance << " F." << '\n';
 }
 
 //------------------------------------------------------------------------------
\ No newline at end of file
@@ -11,6 +11,10 @@
 #include "resistors.hpp"
 #include "capacitors.hpp"
 #include "inductors.hpp"
+#include "reduced_model.hpp"
+#include "frozen_circuit.hpp"
+#include "measured_component.hpp"
+#include "rational_function.hpp"
 
 //------------------------------------------------------------------------------
 // Constructors and destructors:
@@ -25,8 +29,7 @@ std::unique_ptr<component> circuit::clone() const
 // Default constructor:
 circuit::circuit()
 {
-  type = "circuit";
-  symbol = '~';
+  kind = component_kind::circuit;
   frequency = 0;
   voltage = 0;
 }
@@ -44,23 +47,52 @@ circuit::circuit(const double &freq, const double &volt)
     throw std::out_of_range{"Cannot have negative voltage."};
   }
 
-  type = "circuit";
-  symbol = '~';
+  kind = component_kind::circuit;
   frequency = freq;
   voltage = volt;
 }
 
+circuit::circuit(const double &freq, const double &volt,
+  std::vector<std::shared_ptr<component>> &&comps)
+  : circuit{freq, volt}
+{
+  for (const auto &comp : comps) {
+    check_connection(comp->get_connection_type());
+  }
+
+  circuit_comps.reserve(comps.size());
+  for (auto &comp : comps) {
+    // Only walk sub circuits that aren't already at this frequency:
+    if (comp->get_frequency() != frequency) {
+      comp->set_frequency(frequency);
+    }
+    push_component(comp);
+  }
+  comps.clear();
+}
+
 //------------------------------------------------------------------------------
 
 // Copy constructor:
 circuit::circuit(const circuit &circ)
 {
-  type = circ.type;
-  symbol = circ.symbol;
+  kind = circ.kind;
   impedance = circ.impedance;
   frequency = circ.frequency;
   voltage = circ.voltage;
-  circuit_comps = circ.circuit_comps;
+  closed_total = circ.closed_total;
+  last_sum = circ.last_sum;
+  last_type = circ.last_type;
+
+  // Clone each component so the copy doesn't share them:
+  for (const auto &comp : circ.circuit_comps) {
+    std::shared_ptr<component> comp_copy = comp->clone();
+
+    // Component copy constructors don't carry the connection data:
+    comp_copy->set_connection_type(comp->get_connection_type());
+    comp_copy->set_nested_bool(comp->get_nested_bool());
+    circuit_comps.push_back(comp_copy);
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -69,30 +101,46 @@ circuit::circuit(const circuit &circ)
 circuit::circuit(circuit &&circ)
 {
   // Steal the data:
-  type = circ.type;
-  symbol = circ.symbol;
+  kind = circ.kind;
   impedance = circ.impedance;
   frequency = circ.frequency;
   voltage = circ.voltage;
+  closed_total = circ.closed_total;
+  last_sum = circ.last_sum;
+  last_type = circ.last_type;
   circuit_comps = circ.circuit_comps;
 
   // Empty 'old' capacitor data:
-  circ.type = "empty";
-  circ.symbol = 'N';
+  circ.kind = component_kind::empty;
   circ.impedance = 0;
   circ.frequency = 0;
   circ.voltage = 0;
+  circ.closed_total = 0;
+  circ.last_sum = 0;
+  circ.last_type = 0;
 
   for (auto &comp : circ.circuit_comps) {
     comp.reset();
   }
 
+  // An open transaction follows the data:
+  open_transaction = circ.open_transaction;
+  circ.open_transaction = nullptr;
+  if (open_transaction != nullptr) {
+    open_transaction->circ = this;
+  }
+
 }
 
 //------------------------------------------------------------------------------
 
-// Destructor:
-circuit::~circuit(){}
+// Destructor (leaves an open transaction with nothing to undo):
+circuit::~circuit()
+{
+  if (open_transaction != nullptr) {
+    open_transaction->circ = nullptr;
+  }
+}
 
 //------------------------------------------------------------------------------
 // Calculate Total Impedance of Circuit:
@@ -131,76 +179,108 @@ std::complex<double> circuit::calc_parallel_impedance(
 //------------------------------------------------------------------------------
 
 // Function calculates the total impedance of the circuit:
+// (runs are added up in order, the same as adding the components one by one)
 void circuit::set_impedance()
 {
-  // Will contain the sub circuit impedances - i.e. series components:
-  std::vector<std::shared_ptr<std::complex<double>>> circuit_impedance;
-
-  // Will hold the temporary series / parallel sub circuits:
-  std::vector<std::shared_ptr<component>> series_sub_circ;
-  std::vector<std::shared_ptr<component>> parallel_sub_circ;
+  impedance = 0;
+  closed_total = 0;
+  last_sum = 0;
+  last_type = 0;
 
   for (const auto &comp : circuit_comps) {
+    add_impedance(*comp);
+  }
+}
 
-    if (comp->get_connection_type() == 's') {
+//------------------------------------------------------------------------------
 
-      // Keeps adding until it reaches a parallel component:
-      series_sub_circ.push_back(comp);
+// Adds comp's impedance to the last run, or closes it and starts a new one:
+void circuit::add_impedance(const component &comp)
+{
+  char conn = comp.get_connection_type();
+  if (conn != 's' && conn != 'p') {
+    return;
+  }
 
-      // Previous chain consisted of a parallel components:
-      if (parallel_sub_circ.size() != 0) {
+  if (conn != last_type) {
+    if (last_type == 'p') {
+      closed_total += (1.0 / last_sum);
+    } else if (last_type == 's') {
+      closed_total += last_sum;
+    }
+    last_sum = 0;
+    last_type = conn;
+  }
 
-        // End of a parallel loop, so add up this section and append:
-        std::complex<double> para_sub_impedance
-        = calc_parallel_impedance(parallel_sub_circ);
+  if (conn == 'p') {
+    last_sum += (1.0 / comp.get_impedance());
+    impedance = closed_total + (1.0 / last_sum);
+  } else {
+    last_sum += comp.get_impedance();
+    impedance = closed_total + last_sum;
+  }
+}
 
-        circuit_impedance.push_back(
-          std::make_shared<std::complex<double>> (para_sub_impedance) );
-        parallel_sub_circ.clear();
-      }
+// Appends comp, leaving the impedance to commit() in a transaction:
+void circuit::push_component(const std::shared_ptr<component> &comp)
+{
+  circuit_comps.push_back(comp);
 
-    } else if (comp->get_connection_type() == 'p') {
+  if (open_transaction != nullptr) {
+    open_transaction->edits.push_back({circuit_comps.size() - 1, nullptr});
+  } else {
+    add_impedance(*comp);
+  }
+}
 
-      // Add to parallel sub circuit vector:
-      parallel_sub_circ.push_back(comp);
+void circuit::check_connection(const char &conn)
+{
+  if (conn != 's' && conn != 'p') {
+    throw std::invalid_argument{"Components must be in series or parallel."};
+  }
+}
 
-      // Previous chain consisted of a series components:
-      if (series_sub_circ.size() != 0) {
-      
-        // End of a series chain, so add up this chain and append:
-        std::complex<double> series_sub_impedance
-        = calc_series_impedance(series_sub_circ);
+//------------------------------------------------------------------------------
 
-        circuit_impedance.push_back(
-          std::make_shared<std::complex<double>> (series_sub_impedance) );
-        series_sub_circ.clear();
-      }
-    }
+// Same series / parallel runs as set_impedance(), summed as they go:
+std::complex<double> circuit::evaluate(const double &freq) const
+{
+  if (freq < 0.0) {
+    throw std::out_of_range{"Cannot have negative frequency."};
   }
 
-  // Add remaining series component impedances up:
-  if (series_sub_circ.size() != 0) {
+  std::complex<double> circ_impedance{};
+  std::complex<double> run_sum{};
+  char run_type{};
+
+  for (const auto &comp : circuit_comps) {
+    char conn = comp->get_connection_type();
+
+    // End of a run, so add up this section:
+    if (conn != run_type) {
+      if (run_type == 'p') {
+        circ_impedance += (1.0 / run_sum);
+      } else if (run_type == 's') {
+        circ_impedance += run_sum;
+      }
+      run_sum = 0.0;
+      run_type = conn;
+    }
 
-    std::complex<double> series_sub_impedance
-    = calc_series_impedance(series_sub_circ);
-    circuit_impedance.push_back(
-      std::make_shared<std::complex<double>> (series_sub_impedance) );
-  
-  // Add remaining parallel component impedances up:
-  } else if (parallel_sub_circ.size() != 0) {
-      std::complex<double> para_sub_impedance
-      = calc_parallel_impedance(parallel_sub_circ);
-      circuit_impedance.push_back(
-        std::make_shared<std::complex<double>> (para_sub_impedance) );
+    if (conn == 'p') {
+      run_sum += (1.0 / comp->evaluate(freq));
+    } else {
+      run_sum += comp->evaluate(freq);
+    }
   }
 
-  std::complex<double> circ_impedance{};
-  // Now have a vector full of "reduced series" impedances, so just sum these:
-  for (const auto &impedance_value : circuit_impedance) {
-    circ_impedance += *impedance_value;
+  if (run_type == 'p') {
+    circ_impedance += (1.0 / run_sum);
+  } else if (run_type == 's') {
+    circ_impedance += run_sum;
   }
 
-  impedance = circ_impedance;
+  return circ_impedance;
 }
 
 //------------------------------------------------------------------------------
@@ -213,12 +293,18 @@ void circuit::set_value(const double &freq)
     throw std::out_of_range{"Cannot have negative frequency."};
   }
 
-  // Sets all components to frequency of circuit:
+  frequency = freq;
+
+  // Components are set once, on commit:
+  if (open_transaction != nullptr) {
+    return;
+  }
+
+  // Sets all components to (new) frequency of circuit:
   for (const auto &comp : circuit_comps) {
     comp->set_frequency(frequency);
   }
 
-  frequency = freq;
   set_impedance();
 }
 
@@ -233,12 +319,18 @@ void circuit::set_frequency(const double &freq)
     throw std::out_of_range{"Cannot have negative frequency."};
   }
 
-  // Sets all components to frequency of circuit:
+  frequency = freq;
+
+  // Components are set once, on commit:
+  if (open_transaction != nullptr) {
+    return;
+  }
+
+  // Sets all components to (new) frequency of circuit:
   for (const auto &comp : circuit_comps) {
     comp->set_frequency(frequency);
   }
 
-  frequency = freq;
   set_impedance();
 }
 
@@ -247,6 +339,51 @@ double circuit::get_frequency() const
   return frequency;
 }
 
+//------------------------------------------------------------------------------
+
+// Series: dZ/df = sum(dz/df), parallel: dZ/df = -(dY/df) / Y^2 (Y = sum(1/z)):
+std::complex<double> circuit::get_impedance_derivative() const
+{
+  std::complex<double> d_impedance{};
+
+  // Running sums for the current parallel chain:
+  std::complex<double> admittance_sum{};
+  std::complex<double> d_admittance_sum{};
+  bool in_parallel = false;
+
+  for (const auto &comp : circuit_comps) {
+
+    if (comp->get_connection_type() == 's') {
+
+      // End of a parallel chain, so reduce it and add:
+      if (in_parallel) {
+        d_impedance -= d_admittance_sum / (admittance_sum * admittance_sum);
+        admittance_sum = 0;
+        d_admittance_sum = 0;
+        in_parallel = false;
+      }
+
+      d_impedance += comp->get_impedance_derivative();
+
+    } else if (comp->get_connection_type() == 'p') {
+
+      // dy/df = -(dz/df) / z^2:
+      std::complex<double> comp_impedance = comp->get_impedance();
+      admittance_sum += (1.0 / comp_impedance);
+      d_admittance_sum -= comp->get_impedance_derivative()
+        / (comp_impedance * comp_impedance);
+      in_parallel = true;
+    }
+  }
+
+  // Final chain consisted of parallel components:
+  if (in_parallel) {
+    d_impedance -= d_admittance_sum / (admittance_sum * admittance_sum);
+  }
+
+  return d_impedance;
+}
+
 void circuit::set_voltage(const double &volt)
 {
   if (volt < 0.0) {
@@ -266,89 +403,62 @@ double circuit::get_size() const
   return circuit_comps.size();
 }
 
+const std::vector<std::shared_ptr<component>> &circuit::get_components() const
+{
+  return circuit_comps;
+}
+
 //------------------------------------------------------------------------------
 // Printing info:
 //------------------------------------------------------------------------------
 
-void circuit::print_info() const
+void circuit::write_info(circuits::report_writer &out) const
 {
-  std::cout << std::endl
-  << "Circuit information: " << std::endl;
+  out << '\n'
+  << "Circuit information: " << '\n';
 
-  if (frequency <= 1e-2 || frequency >= 1e3) {
-    std::cout << std::scientific;
-  } else {
-    std::cout << std::fixed;
-  }
-  std::cout << "    Frequency, f = " << frequency << " Hz," << std::endl;
+  out << "    Frequency, f = " << frequency << " Hz," << '\n';
 
-  if (voltage <= 1e-2 || voltage >= 1e3) {
-    std::cout << std::scientific;
-  } else {
-    std::cout << std::fixed;
-  }
-  std::cout << "    Voltage, V = " << voltage << " V."  << std::endl;
+  out << "    Voltage, V = " << voltage << " V."  << '\n';
 
   // For cases of circuits containing no components yet:
   if (get_size() == 0) {
-    std::cout << std::endl
-    << "You need to add components to this circuit to view " << std::endl
-    << "data such as the total impedance and current." << std::endl;
+    out << '\n'
+    << "You need to add components to this circuit to view " << '\n'
+    << "data such as the total impedance and current." << '\n';
 
   } else {
 
-    std::cout << std::endl
-    << "Total impedance of circuit:" << std::endl;
-
-    if (get_magnitude() <= 1e-2 || get_magnitude() >= 1e3) {
-      std::cout << std::scientific;
-    } else {
-      std::cout << std::fixed;
-    }
-    std::cout << "    Magnitude = " 
-    << get_magnitude() << " Ohms," << std::endl;
-
-    if (get_phase() <= 1e-2 || get_phase() >= 1e3) {
-      std::cout << std::scientific;
+    out << '\n'
+    << "Total impedance of circuit:" << '\n';
 
-    } else {
-        std::cout << std::fixed;
-    }
+    out << "    Magnitude = " 
+    << get_magnitude() << " Ohms," << '\n';
 
     if (get_phase() == 0) {
-      std::cout << "    and phase = 0 radians." << std::endl;
+      out << "    and phase = 0 radians." << '\n';
 
     } else {
-    std::cout << "    and phase = " 
-    << get_phase() << " radians." << std::endl;
+    out << "    and phase = " 
+    << get_phase() << " radians." << '\n';
     }
 
-    std::cout << std::endl;
+    out << '\n';
 
     // Current, I = V / Z:
     double current = (voltage / get_magnitude() );
 
-    if (current <= 1e-2 || current >= 1e3) {
-      std::cout << std::scientific;
-    } else {
-      std::cout << std::fixed;
-    }
-    std::cout << "Total current, I = " << current << " A, ";
+    out << "Total current, I = " << current << " A, ";
     
     if (get_phase() != 0) {
-      std::cout << "with phase difference" << std::endl;
-      if (get_phase() <= 1e-2 || get_phase() >= 1e3) {
-        std::cout << std::scientific;
-      } else {
-          std::cout << std::fixed;
-      }
+      out << "with phase difference" << '\n';
 
-      std::cout << "between the voltage of " 
-      << get_phase() << " radians." << std::endl;
+      out << "between the voltage of " 
+      << get_phase() << " radians." << '\n';
 
     } else {
-      std::cout << std::endl;
-      std::cout << "in phase with the voltage." << std::endl;
+      out << '\n';
+      out << "in phase with the voltage." << '\n';
     }
   }
 }
@@ -358,9 +468,11 @@ void circuit::print_info() const
 // Prints out the components stored in the circuit:
 void circuit::print_components() const
 {
-  std::cout << std::endl
-  << "Here is this list of components in this circuit in order:" << std::endl;
-  std::cout << std::endl;
+  report_writer out{std::cout};
+
+  out << '\n'
+  << "Here is this list of components in this circuit in order:" << '\n';
+  out << '\n';
 
   for (int i{}; i < circuit_comps.size(); ++i) {
 
@@ -382,35 +494,23 @@ void circuit::print_components() const
       nested = "";
     }
 
-    std::cout << "Component " << (i + 1) << " is in " 
+    out << "Component " << (i + 1) << " is in " 
     << nested << connection << " - ";
-    circuit_comps[i]->print_info();
+    circuit_comps[i]->write_info(out);
 
     // Prints mag and phase for each comp:
     double magnitude =  circuit_comps[i]->get_magnitude();
     double phase =  circuit_comps[i]->get_phase();
 
-    if (magnitude <= 1e-2 || magnitude >= 1e3) {
-      std::cout << std::scientific;
-    } else {
-      std::cout << std::fixed;
-    }
-    std::cout << "    Magnitude = " 
-    << magnitude << " Ohms," << std::endl;
-
-    if (phase <= 1e-2 || phase >= 1e3) {
-      std::cout << std::scientific;
-
-    } else {
-        std::cout << std::fixed;
-    }
+    out << "    Magnitude = " 
+    << magnitude << " Ohms," << '\n';
 
     if (phase == 0) {
-      std::cout << "    and phase = 0 radians." << std::endl;
+      out << "    and phase = 0 radians." << '\n';
 
     } else {
-    std::cout << "    and phase = " 
-    << phase << " radians." << std::endl;
+    out << "    and phase = " 
+    << phase << " radians." << '\n';
     }
   }
 }
@@ -421,15 +521,17 @@ void circuit::print_components() const
 // (uses similar method to set_impedance function)
 void circuit::print_diagram() const
 {
+  report_writer out{std::cout};
+
   // Info for smybols:
-  std::cout << std::endl;
-  std::cout << "Note: UPPERCASE = ideal / lowercase = non-ideal." << std::endl;
+  out << '\n';
+  out << "Note: UPPERCASE = ideal / lowercase = non-ideal." << '\n';
 
   // Initial section of circuit:
-  std::cout << std::endl
-  << " O" << std::endl
-  << " |" << std::endl
-  << "(~)" << std::endl;
+  out << '\n'
+  << " O" << '\n'
+  << " |" << '\n'
+  << "(~)" << '\n';
 
   // Will hold the temporary parallel sub circuits:
   std::vector<std::shared_ptr<component>> parallel_sub_circ;
@@ -442,12 +544,12 @@ void circuit::print_diagram() const
       if (parallel_sub_circ.size() != 0) {
         parallel_sub_circ.clear();
         // Ensures correct indent:
-        std::cout << std::endl;
+        out << '\n';
       }
 
-      std::cout
-      << " |" << std::endl
-      << "[" << comp->get_symbol() << "]" << std::endl;
+      out
+      << " |" << '\n'
+      << "[" << comp->get_symbol() << "]" << '\n';
 
     } else if (comp->get_connection_type() == 'p') {
 
@@ -455,14 +557,14 @@ void circuit::print_diagram() const
       if (parallel_sub_circ.size() == 0) {
       
       // End of a series chain, so indent for first para comp:
-      //std::cout << std::endl;
-      std::cout
-      << " |" << std::endl
+      //out << '\n';
+      out
+      << " |" << '\n'
       << " o--[" << comp->get_symbol() << "]";
 
       } else {
         // Continue parallel section:
-        std::cout << "--[" << comp->get_symbol() << "]";
+        out << "--[" << comp->get_symbol() << "]";
       }
 
       // Also add to parallel sub circuit vector:
@@ -474,13 +576,13 @@ void circuit::print_diagram() const
   if (parallel_sub_circ.size() != 0) {
     parallel_sub_circ.clear();
     // Ensures correct indent:
-    std::cout << std::endl;
+    out << '\n';
   }
 
   // End of circuit:
-  std::cout
-  << " |" << std::endl
-  << " O" << std::endl;
+  out
+  << " |" << '\n'
+  << " O" << '\n';
 }
 
 //------------------------------------------------------------------------------
@@ -506,14 +608,191 @@ template void circuit::add_component<real_capacitor>(
 template void circuit::add_component<real_inductor>(
   std::shared_ptr<real_inductor> &real_induc, const char &conn, const bool &nest);
 
+template void circuit::add_component<reduced_model>(
+  std::shared_ptr<reduced_model> &model, const char &conn, const bool &nest);
+
+template void circuit::add_component<frozen_circuit>(
+  std::shared_ptr<frozen_circuit> &frozen, const char &conn, const bool &nest);
+
+template void circuit::add_component<measured_component>(
+  std::shared_ptr<measured_component> &measured, const char &conn,
+  const bool &nest);
+
+// Sub circuits (cloned as a whole, see copy constructor):
+template void circuit::add_component<circuit>(
+  std::shared_ptr<circuit> &circ, const char &conn, const bool &nest);
+
 //------------------------------------------------------------------------------
 
 // Removes a component from the circuit based on its index:
 void circuit::remove_component(const size_t &index)
 {
+  std::shared_ptr<component> removed = circuit_comps[index];
   circuit_comps.erase(circuit_comps.begin() + index);
 
+  if (open_transaction != nullptr) {
+    open_transaction->edits.push_back({index, removed});
+    open_transaction->first_removed = std::min(open_transaction->first_removed,
+      index);
+    return;
+  }
+
   set_impedance();
 }
 
+//------------------------------------------------------------------------------
+// Freezing Circuits:
+//------------------------------------------------------------------------------
+
+std::shared_ptr<frozen_circuit> circuit::freeze() const
+{
+  return std::make_shared<frozen_circuit>(compile_circuit(*this), get_size());
+}
+
+//------------------------------------------------------------------------------
+
+std::shared_ptr<frozen_circuit> circuit::freeze(
+  const double &f_min, const double &f_max, const size_t &samples) const
+{
+  if (f_min <= 0.0) {
+    throw std::out_of_range{"Minimum frequency must be above 0 Hz."};
+  }
+
+  if (f_max <= f_min) {
+    throw std::out_of_range{"Maximum frequency must be above the minimum."};
+  }
+
+  if (samples < 2) {
+    throw std::out_of_range{"Need at least 2 frequency samples."};
+  }
+
+  frozen_table table;
+  table.log_f_min = std::log(f_min);
+  table.log_step = std::log(f_max / f_min) / (samples - 1);
+  table.impedances.reserve(samples);
+  table.log_slopes.reserve(samples);
+
+  // dZ/d(ln f) by central difference, so only evaluate() is used and the
+  // circuit is left as it was:
+  const double log_delta = 1e-5;
+
+  for (size_t i{}; i < samples; ++i) {
+    double log_f = table.log_f_min + (table.log_step * i);
+    table.impedances.push_back(evaluate(std::exp(log_f)));
+    table.log_slopes.push_back((evaluate(std::exp(log_f + log_delta))
+      - evaluate(std::exp(log_f - log_delta))) / (2.0 * log_delta));
+  }
+
+  return std::make_shared<frozen_circuit>(table, get_size());
+}
+
+//------------------------------------------------------------------------------
+// Edit transactions:
+//------------------------------------------------------------------------------
+
+circuit::transaction::transaction(circuit &circ) : circ{&circ}
+{
+  if (circ.open_transaction != nullptr) {
+    throw std::runtime_error{"Circuit already has an open transaction."};
+  }
+
+  frequency = circ.frequency;
+  voltage = circ.voltage;
+  impedance = circ.impedance;
+  closed_total = circ.closed_total;
+  last_sum = circ.last_sum;
+  last_type = circ.last_type;
+  size = circ.circuit_comps.size();
+  first_removed = size;
+
+  circ.open_transaction = this;
+}
+
+circuit::transaction::~transaction()
+{
+  if (circ != nullptr) {
+    rollback();
+  }
+}
+
+bool circuit::transaction::is_open() const
+{
+  return circ != nullptr;
+}
+
+void circuit::transaction::close()
+{
+  if (circ == nullptr) {
+    throw std::runtime_error{"Transaction is no longer open."};
+  }
+
+  circ->open_transaction = nullptr;
+}
+
+//------------------------------------------------------------------------------
+
+void circuit::transaction::commit()
+{
+  close();
+  circuit &c = *circ;
+  circ = nullptr;
+  edits.clear();
+
+  // Components added while another frequency was set are brought back to
+  // the circuit's (only those not already at it are changed):
+  auto set_frequencies = [&](const size_t &from) {
+    for (size_t i{from}; i < c.circuit_comps.size(); ++i) {
+      component &comp = *c.circuit_comps[i];
+      if (comp.get_frequency() != c.frequency) {
+        comp.set_frequency(c.frequency);
+      }
+    }
+  };
+
+  // Original components untouched and at the same frequency, so carry on
+  // from their runs:
+  if (c.frequency == frequency && first_removed >= size) {
+    set_frequencies(size);
+
+    c.impedance = impedance;
+    c.closed_total = closed_total;
+    c.last_sum = last_sum;
+    c.last_type = last_type;
+
+    for (size_t i{size}; i < c.circuit_comps.size(); ++i) {
+      c.add_impedance(*c.circuit_comps[i]);
+    }
+
+  } else {
+    set_frequencies(0);
+    c.set_impedance();
+  }
+}
+
+// Undoes the edits newest first (no component was changed, so the saved
+// impedance is still right):
+void circuit::transaction::rollback()
+{
+  close();
+  circuit &c = *circ;
+  circ = nullptr;
+
+  for (auto edit = edits.rbegin(); edit != edits.rend(); ++edit) {
+    if (edit->removed == nullptr) {
+      c.circuit_comps.pop_back();
+    } else {
+      c.circuit_comps.insert(c.circuit_comps.begin() + edit->index,
+        edit->removed);
+    }
+  }
+  edits.clear();
+
+  c.frequency = frequency;
+  c.voltage = voltage;
+  c.impedance = impedance;
+  c.closed_total = closed_total;
+  c.last_sum = last_sum;
+  c.last_type = last_type;
+}
+
 //------------------------------------------------------------------------------
\ No newline at end of file
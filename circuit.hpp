@@ -12,6 +12,11 @@
 
 #include "base_component.hpp"
 
+#include <stdexcept>
+#include <utility>
+
+class frozen_circuit;
+
 //------------------------------------------------------------------------------
 
 namespace circuits
@@ -24,6 +29,28 @@ namespace circuits
     // Stores all components in a given circuit:
     std::vector<std::shared_ptr<component>> circuit_comps;
 
+    // Impedance of the runs before the last one, and the last run's sum
+    // (z or 1/z), so appending a component doesn't walk circuit_comps:
+    std::complex<double> closed_total{};
+    std::complex<double> last_sum{};
+    char last_type{};
+
+    // Adds a component's impedance on to the end of the runs:
+    void add_impedance(const component &comp);
+
+  public:
+    class transaction;
+
+  private:
+    // Open transaction on this circuit (null if none):
+    transaction *open_transaction = nullptr;
+
+    // Appends a component, updating the impedance or recording the edit:
+    void push_component(const std::shared_ptr<component> &comp);
+
+    // Throws unless conn is series ('s') or parallel ('p'):
+    static void check_connection(const char &conn);
+
   public:
     // For cloning shared_ptr of circuit component:
     std::unique_ptr<component> clone() const;
@@ -34,6 +61,11 @@ namespace circuits
     // Parameterised constructor:
     circuit(const double &freq, const double &volt);
 
+    // Parameterised constructor taking ownership of components that already
+    // have their connection type set (not cloned, impedance found once):
+    circuit(const double &freq, const double &volt,
+      std::vector<std::shared_ptr<component>> &&comps);
+
     // Copy constructor for deep copying:
     circuit(const circuit &circ);
 
@@ -48,6 +80,10 @@ namespace circuits
     // Calcs total impedance, need to calc each time a comp is added / removed:
     void set_impedance();
 
+    // Impedance at freq (Hz) from each component's evaluate(), the circuit
+    // and its components keep their own frequency / impedance:
+    std::complex<double> evaluate(const double &freq) const;
+
     std::complex<double> calc_series_impedance(
       const std::vector<std::shared_ptr<component>> &series_sub_circ) const;
 
@@ -61,16 +97,22 @@ namespace circuits
     void set_frequency(const double &freq);
     double get_frequency() const;
 
+    // Combines dZ/df of each component using the same series / parallel runs:
+    std::complex<double> get_impedance_derivative() const;
+
     void set_voltage(const double &volt);
     double get_voltage() const;
 
     // Returns number of components in vector:
     double get_size() const;
 
+    // Read only access to the components (used by analysis code):
+    const std::vector<std::shared_ptr<component>> &get_components() const;
+
 //------------------------------------------------------------------------------
 
-    // Prints total impedance, freq, volt details:
-    void print_info() const;
+    // Writes total impedance, freq, volt details (print_info() prints them):
+    void write_info(circuits::report_writer &out) const;
 
     // Prints components in the circuit:
     void print_components() const;
@@ -81,11 +123,88 @@ namespace circuits
 //------------------------------------------------------------------------------
 
     // Template to add components to circuit in series or parallel:
+    // (comp is cloned, the impedance is updated rather than recalculated)
     template <class T> void add_component(
       std::shared_ptr<T> &comp, const char &conn, const bool &nest);
 
+    // Constructs a T in the circuit from args (no clone), returning it:
+    template <class T, class... Args> T &emplace_component(
+      const char &conn, const bool &nest, Args &&...args);
+
+    // Appends copies of components that already have their connection type
+    // set, e.g. from a vector of shared_ptr (forward iterators, checks them
+    // all first, so nothing is added if one is invalid):
+    template <class Iterator> void add_components(
+      Iterator first, Iterator last);
+
     // To remove a given component from circuit_comps:
     void remove_component(const size_t &index);
+
+//------------------------------------------------------------------------------
+
+    // Precomputed single component versions of this circuit, so a parent
+    // doesn't walk circuit_comps on every evaluation:
+
+    // Compiled rational function (exact, any frequency):
+    std::shared_ptr<frozen_circuit> freeze() const;
+
+    // Impedance table (log spaced, f_min to f_max) with interpolation:
+    std::shared_ptr<frozen_circuit> freeze(
+      const double &f_min, const double &f_max, const size_t &samples) const;
+  };
+
+//------------------------------------------------------------------------------
+// Edit transactions:
+//------------------------------------------------------------------------------
+
+  // While open, adds / removes / frequency and voltage changes made through
+  // the circuit are recorded and nothing is recalculated (get_impedance() is
+  // stale until commit). commit() then finds the impedance once: continuing
+  // the runs if components were only appended, else one pass over the
+  // circuit. Ending without commit() undoes every edit.
+  class circuit::transaction
+  {
+  private:
+    circuit *circ;
+
+    // Undo log (removed is null for an append):
+    struct edit
+    {
+      size_t index;
+      std::shared_ptr<component> removed;
+    };
+    std::vector<edit> edits;
+
+    // Circuit state when opened:
+    double frequency;
+    double voltage;
+    std::complex<double> impedance;
+    std::complex<double> closed_total;
+    std::complex<double> last_sum;
+    char last_type;
+    size_t size;
+
+    // First index of the original components that was removed:
+    size_t first_removed;
+
+    friend class circuit;
+
+    void close();
+
+  public:
+    // Throws std::runtime_error if circ already has one open:
+    transaction(circuit &circ);
+
+    // Rolls back if still open:
+    ~transaction();
+
+    transaction(const transaction &) = delete;
+    transaction &operator=(const transaction &) = delete;
+
+    void commit();
+    void rollback();
+
+    bool is_open() const;
   };
 }
 
@@ -100,14 +219,54 @@ template <class T> void circuit::add_component(
   std::shared_ptr<T> &comp,
   const char &conn, const bool &nest)
 {
-  circuit_comps.push_back(comp->clone() );
+  check_connection(conn);
+
+  std::shared_ptr<component> comp_copy = comp->clone();
 
   // Set the member data for this component:
-  circuit_comps.back()->set_connection_type(conn);
-  circuit_comps.back()->set_nested_bool(nest);
-  circuit_comps.back()->set_frequency(frequency);
+  comp_copy->set_connection_type(conn);
+  comp_copy->set_nested_bool(nest);
+  comp_copy->set_frequency(frequency);
 
-  set_impedance();
+  push_component(comp_copy);
+}
+
+// Construct the component in place, then add as above:
+template <class T, class... Args> T &circuit::emplace_component(
+  const char &conn, const bool &nest, Args &&...args)
+{
+  check_connection(conn);
+
+  auto comp = std::make_shared<T>(std::forward<Args>(args)...);
+  comp->set_connection_type(conn);
+  comp->set_nested_bool(nest);
+  comp->set_frequency(frequency);
+
+  push_component(comp);
+  return *comp;
+}
+
+// Add many components, each one only updating the impedance:
+template <class Iterator> void circuit::add_components(
+  Iterator first, Iterator last)
+{
+  for (Iterator it = first; it != last; ++it) {
+    check_connection((*it)->get_connection_type());
+  }
+
+  for (Iterator it = first; it != last; ++it) {
+    std::shared_ptr<component> comp_copy = (*it)->clone();
+
+    // Component copy constructors don't carry the connection data:
+    comp_copy->set_connection_type((*it)->get_connection_type());
+    comp_copy->set_nested_bool((*it)->get_nested_bool());
+
+    // Only walk sub circuits that aren't already at this frequency:
+    if (comp_copy->get_frequency() != frequency) {
+      comp_copy->set_frequency(frequency);
+    }
+    push_component(comp_copy);
+  }
 }
 
 //------------------------------------------------------------------------------
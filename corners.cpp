@@ -0,0 +1,825 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Worst case tolerance corners (affine bounds, branch and bound):
+//------------------------------------------------------------------------------
+
+#include "corners.hpp"
+#include "folded_program.hpp"
+#include "parallel.hpp"
+
+#include <array>
+#include <span>
+#include <limits>
+#include <unordered_map>
+
+using namespace circuits;
+
+//------------------------------------------------------------------------------
+// Helper functions (only used in this file):
+//------------------------------------------------------------------------------
+
+namespace
+{
+  const double unbounded = std::numeric_limits<double>::infinity();
+
+  // center + sum of terms[k] e_k (every e_k in [-1, 1], one per toleranced
+  // part) + anything within radius. Terms outside [first, last) are 0 (parts
+  // are numbered in program order, so a sub circuit's are together):
+  struct affine_form
+  {
+    std::complex<double> center;
+    std::vector<std::complex<double>> terms;
+    double radius;
+
+    size_t first = 0;
+    size_t last = 0;
+  };
+
+  std::span<std::complex<double>> get_terms(affine_form &form)
+  {
+    return std::span{form.terms}.subspan(form.first, form.last - form.first);
+  }
+
+  std::span<const std::complex<double>> get_terms(const affine_form &form)
+  {
+    return std::span{form.terms}.subspan(form.first, form.last - form.first);
+  }
+
+  void set_point(affine_form &form, const std::complex<double> &z)
+  {
+    form.center = z;
+    for (auto &term : get_terms(form)) {
+      term = 0.0;
+    }
+    form.radius = 0.0;
+    form.first = 0;
+    form.last = 0;
+  }
+
+  void add(affine_form &form, const affine_form &other)
+  {
+    form.center += other.center;
+    form.radius += other.radius;
+    if (other.first == other.last) {
+      return;
+    }
+
+    for (size_t k{other.first}; k < other.last; ++k) {
+      form.terms[k] += other.terms[k];
+    }
+    if (form.first == form.last) {
+      form.first = other.first;
+      form.last = other.last;
+    } else {
+      form.first = std::min(form.first, other.first);
+      form.last = std::max(form.last, other.last);
+    }
+  }
+
+  // Largest distance from the center:
+  double get_spread(const affine_form &form)
+  {
+    double spread = form.radius;
+    for (const auto &term : get_terms(form)) {
+      spread += std::abs(term);
+    }
+    return spread;
+  }
+
+  // 1 / (c + d) = 1/c - d / c^2 + d^2 / (c^2 (c + d)), the last part (at
+  // most s^2 / (|c|^2 (|c| - s)) for |d| <= s) going into the radius:
+  void invert(affine_form &form)
+  {
+    double spread = get_spread(form);
+    if (spread == 0.0) {
+      form.center = 1.0 / form.center;
+      return;
+    }
+
+    double size = std::abs(form.center);
+    if (!(spread < size)) {
+      set_point(form, 0.0);
+      form.radius = unbounded;
+      return;
+    }
+
+    // One term (the usual case, a single part in a run) follows the arc
+    // 1 / (c + e g) exactly: the chord through its ends, moved half way
+    // to the arc's middle, is within
+    // |g|^2 / |c^2 - g^2| (1 / 2|c| + |g| / (|c| (|c| - |g|))),
+    // about half the general remainder. The radius r moves 1/z by at most
+    // r / ((|c| - |g|) (|c| - |g| - r)):
+    if (form.last - form.first == 1) {
+      std::complex<double> &term = form.terms[form.first];
+      double length = std::abs(term);
+      double closest = size - length;
+
+      std::complex<double> difference = (form.center * form.center)
+        - (term * term);
+      std::complex<double> chord_center = form.center / difference;
+      std::complex<double> sag = -(term * term) / (form.center * difference);
+
+      form.radius = ((length * length) / std::abs(difference))
+        * ((0.5 / size) + (length / (size * closest)))
+        + (form.radius / (closest * (closest - form.radius)));
+      form.center = chord_center + (0.5 * sag);
+      term = -term / difference;
+      return;
+    }
+
+    std::complex<double> inverse = 1.0 / form.center;
+    std::complex<double> slope = -inverse * inverse;
+    for (auto &term : get_terms(form)) {
+      term *= slope;
+    }
+
+    double size_squared = size * size;
+    form.radius = (form.radius / size_squared)
+      + ((spread * spread) / (size_squared * (size - spread)));
+    form.center = inverse;
+  }
+
+//------------------------------------------------------------------------------
+
+  // Form of one part over the main value's range [low, high], its own term
+  // first (ideal parts move along a straight line, so are exact):
+  affine_form segment(const std::complex<double> &a,
+    const std::complex<double> &b)
+  {
+    return affine_form{0.5 * (a + b), {0.5 * (b - a)}, 0.0, 0, 1};
+  }
+
+  affine_form point(const std::complex<double> &z)
+  {
+    return affine_form{z, {0.0}, 0.0};
+  }
+
+  // (R + jwL) in parallel with C, as flat_parallel_rlc():
+  affine_form parallel_rlc(affine_form series, const double &capacitance,
+    const double &omega)
+  {
+    invert(series);
+    add(series, point(std::complex<double>{0.0, omega * capacitance}));
+    invert(series);
+    return series;
+  }
+
+  affine_form range_form(const flat_resistor &, const double &low,
+    const double &high, const double &)
+  {
+    return segment(low, high);
+  }
+
+  affine_form range_form(const flat_capacitor &, const double &low,
+    const double &high, const double &omega)
+  {
+    return segment(std::complex<double>{0.0, -1.0 / (omega * low)},
+      std::complex<double>{0.0, -1.0 / (omega * high)});
+  }
+
+  affine_form range_form(const flat_inductor &, const double &low,
+    const double &high, const double &omega)
+  {
+    return segment(std::complex<double>{0.0, omega * low},
+      std::complex<double>{0.0, omega * high});
+  }
+
+  affine_form range_form(const flat_real_resistor &part, const double &low,
+    const double &high, const double &omega)
+  {
+    affine_form series = segment(low, high);
+    add(series, point(std::complex<double>{0.0, omega * part.inductance}));
+    return parallel_rlc(series, part.capacitance, omega);
+  }
+
+  affine_form range_form(const flat_real_capacitor &part, const double &low,
+    const double &high, const double &omega)
+  {
+    affine_form form = segment(
+      std::complex<double>{0.0, -1.0 / (omega * low)},
+      std::complex<double>{0.0, -1.0 / (omega * high)});
+    add(form, point(std::complex<double>{part.resistance,
+      omega * part.inductance}));
+    return form;
+  }
+
+  affine_form range_form(const flat_real_inductor &part, const double &low,
+    const double &high, const double &omega)
+  {
+    affine_form series = segment(std::complex<double>{0.0, omega * low},
+      std::complex<double>{0.0, omega * high});
+    add(series, point(part.resistance));
+    return parallel_rlc(series, part.capacitance, omega);
+  }
+
+//------------------------------------------------------------------------------
+
+  // State of a toleranced part in a search node:
+  enum part_state : uint8_t {at_nominal, at_low, at_high, in_range};
+
+  // A toleranced part's impedance at nominal, low and high, and its forms
+  // over the range (of z, and of 1/z for a parallel run):
+  struct part_forms
+  {
+    std::array<std::complex<double>, 3> points;
+
+    std::complex<double> center;
+    std::complex<double> term;
+    double radius;
+
+    std::complex<double> inverse_center;
+    std::complex<double> inverse_term;
+    double inverse_radius;
+  };
+
+  const size_t no_slot = std::numeric_limits<size_t>::max();
+
+  // Sums of one circuit level (see folded_program.hpp):
+  void reset(level_sums<affine_form> &level, const size_t &count)
+  {
+    level.closed.terms.resize(count);
+    level.sum.terms.resize(count);
+    set_point(level.closed, 0.0);
+    set_point(level.sum, 0.0);
+    level.run_type = 0;
+  }
+
+  struct compiled_circuit
+  {
+    std::vector<folded_step> program;
+
+    // By slot, and the tolerance each slot is:
+    std::vector<part_forms> parts;
+    std::vector<size_t> tolerance_of;
+  };
+
+  // Scratch space of one thread:
+  struct workspace
+  {
+    std::vector<level_sums<affine_form>> levels{1};
+    affine_form part;
+  };
+
+  // Form of the circuit with each toleranced part in states[slot]:
+  const affine_form &evaluate_states(const compiled_circuit &compiled,
+    const std::vector<uint8_t> &states, workspace &space)
+  {
+    std::vector<level_sums<affine_form>> &levels = space.levels;
+    affine_form &part = space.part;
+    size_t count = compiled.parts.size();
+    size_t depth{};
+    reset(levels[0], count);
+    part.terms.resize(count);
+
+    for (const auto &s : compiled.program) {
+      switch (s.type) {
+        case folded_step_type::fixed:
+          start_run(levels[depth], s.conn);
+          levels[depth].sum.center += s.term;
+          continue;
+
+        case folded_step_type::part: {
+          const size_t &slot = s.index;
+          const part_forms &forms = compiled.parts[slot];
+          set_point(part, 0.0);
+          if (states[slot] != in_range) {
+            part.center = forms.points[states[slot]];
+            break;
+          }
+
+          part.first = slot;
+          part.last = slot + 1;
+          if (s.conn != 'p') {
+            part.center = forms.center;
+            part.terms[slot] = forms.term;
+            part.radius = forms.radius;
+            break;
+          }
+
+          // Already inverted:
+          part.center = forms.inverse_center;
+          part.terms[slot] = forms.inverse_term;
+          part.radius = forms.inverse_radius;
+          start_run(levels[depth], s.conn);
+          add(levels[depth].sum, part);
+          continue;
+        }
+
+        case folded_step_type::begin:
+          ++depth;
+          if (depth == levels.size()) {
+            levels.emplace_back();
+          }
+          reset(levels[depth], count);
+          continue;
+
+        // The sub circuit's total is then added to its parent as a part:
+        case folded_step_type::end:
+          close_run(levels[depth]);
+          std::swap(part, levels[depth].closed);
+          --depth;
+          break;
+      }
+
+      start_run(levels[depth], s.conn);
+      if (s.conn == 'p') {
+        invert(part);
+      }
+      add(levels[depth].sum, part);
+    }
+
+    close_run(levels[0]);
+    return levels[0].closed;
+  }
+
+//------------------------------------------------------------------------------
+
+  // Largest of Re(e^-ja (z + sign x sum |Re(e^-ja terms[k])| e^ja)) over all
+  // angles a: with sign 1 the largest |w| over the zonotope (center plus
+  // terms), with sign -1 its distance from 0 (if > 0). Between the angles
+  // where a term's sign flips it is Re(e^-ja S) for a fixed S:
+  double largest_support(const affine_form &form, const double &sign)
+  {
+    std::vector<double> angles;
+    for (const auto &term : get_terms(form)) {
+      if (term != 0.0) {
+        double angle = std::remainder(std::arg(term) + (0.5 * M_PI),
+          2 * M_PI);
+        angles.push_back(angle);
+        angles.push_back(std::remainder(angle + M_PI, 2 * M_PI));
+      }
+    }
+    if (angles.empty()) {
+      return std::abs(form.center);
+    }
+
+    std::sort(angles.begin(), angles.end());
+    angles.push_back(angles.front() + (2 * M_PI));
+
+    // Re(e^-ja z):
+    auto along = [](const std::complex<double> &z,
+      const std::complex<double> &direction) {
+      return (z.real() * direction.real()) + (z.imag() * direction.imag());
+    };
+
+    double best = -unbounded;
+    for (size_t i{}; i + 1 < angles.size(); ++i) {
+      double start = angles[i];
+      double end = angles[i + 1];
+      std::complex<double> middle = std::polar(1.0, 0.5 * (start + end));
+
+      std::complex<double> total = form.center;
+      for (const auto &term : get_terms(form)) {
+        double projection = along(term, middle);
+        total += (projection * sign >= 0.0) ? term : -term;
+      }
+
+      // Largest on the arc at arg(total) if inside it, else at an end:
+      double offset = std::remainder(std::arg(total) - start, 2 * M_PI);
+      if (offset < 0.0) {
+        offset += 2 * M_PI;
+      }
+      if (offset <= end - start) {
+        best = std::max(best, std::abs(total));
+      } else {
+        best = std::max({best, along(total, std::polar(1.0, start)),
+          along(total, std::polar(1.0, end))});
+      }
+    }
+    return best;
+  }
+
+  // Largest of Im(e^-ja w) over the form (<= 0 if every w has
+  // arg <= a, when it holds no 0):
+  double largest_rise(const affine_form &form, const double &angle)
+  {
+    std::complex<double> turn = std::polar(1.0, -angle);
+    double rise = (form.center * turn).imag() + form.radius;
+    for (const auto &term : get_terms(form)) {
+      rise += std::abs((term * turn).imag());
+    }
+    return rise;
+  }
+
+  // Largest of -Im(e^-ja w), <= 0 if every w has arg >= a:
+  double largest_fall(const affine_form &form, const double &angle)
+  {
+    std::complex<double> turn = std::polar(1.0, -angle);
+    double fall = -(form.center * turn).imag() + form.radius;
+    for (const auto &term : get_terms(form)) {
+      fall += std::abs((term * turn).imag());
+    }
+    return fall;
+  }
+
+  impedance_bound make_bound(const affine_form &form)
+  {
+    impedance_bound bound;
+    bound.center = form.center;
+    bound.radius = get_spread(form);
+    bound.min_magnitude = 0.0;
+    bound.max_magnitude = unbounded;
+    bound.min_phase = -M_PI;
+    bound.max_phase = M_PI;
+
+    if (!std::isfinite(bound.radius) || !std::isfinite(std::abs(form.center))) {
+      return bound;
+    }
+
+    bound.max_magnitude = largest_support(form, 1.0) + form.radius;
+    double distance = largest_support(form, -1.0) - form.radius;
+    bound.min_magnitude = std::max(0.0, distance);
+
+    // Phase only bounded away from 0 (found by bisection, keeping the side
+    // that is proven):
+    if (!(distance > 0.0)) {
+      return bound;
+    }
+
+    double phase = std::arg(form.center);
+    double below = phase;
+    double above = phase + (0.5 * M_PI);
+    if (largest_rise(form, above) > 0.0) {
+      return bound;
+    }
+    if (largest_rise(form, below) <= 0.0) {
+      above = below;
+    }
+    for (int i{}; i < 60 && above - below > 1e-15; ++i) {
+      double middle = 0.5 * (below + above);
+      (largest_rise(form, middle) <= 0.0 ? above : below) = middle;
+    }
+    double max_phase = above;
+
+    below = phase - (0.5 * M_PI);
+    above = phase;
+    if (largest_fall(form, below) > 0.0) {
+      return bound;
+    }
+    if (largest_fall(form, above) <= 0.0) {
+      below = above;
+    }
+    for (int i{}; i < 60 && above - below > 1e-15; ++i) {
+      double middle = 0.5 * (below + above);
+      (largest_fall(form, middle) <= 0.0 ? below : above) = middle;
+    }
+    double min_phase = below;
+
+    // Only within (-pi, pi] (no wrap around):
+    if (min_phase > -M_PI && max_phase <= M_PI) {
+      bound.min_phase = min_phase;
+      bound.max_phase = max_phase;
+    }
+    return bound;
+  }
+
+  compiled_circuit compile_tolerances(const circuit &circ,
+    const std::vector<component_tolerance> &tolerances, const double &freq)
+  {
+    if (!(freq > 0.0)) {
+      throw std::out_of_range{"Corner analysis needs a positive frequency."};
+    }
+
+    std::unordered_map<const component *, size_t> tolerance_index;
+    std::vector<const component *> toleranced = check_tolerances(circ,
+      tolerances, tolerance_index);
+
+    std::vector<part_forms> parts;
+    compiled_circuit compiled;
+    double omega = 2 * M_PI * freq;
+
+    for (size_t k{}; k < tolerances.size(); ++k) {
+      const component &comp = *toleranced[k];
+      double value = comp.get_value();
+      double low_value = value * (1.0 - tolerances[k].relative);
+      double high_value = value * (1.0 + tolerances[k].relative);
+
+      // Impedance at each end of the range:
+      std::unique_ptr<component> check = comp.clone();
+      check->set_value(low_value);
+      std::complex<double> low_z = check->evaluate(freq);
+      check->set_value(high_value);
+      std::complex<double> high_z = check->evaluate(freq);
+
+      affine_form range = std::visit([&](const auto &part) {
+        return range_form(part, low_value, high_value, omega);
+      }, make_flat_component(comp));
+
+      // An ideal part's 1/z stays on its own line, so is a segment too:
+      affine_form inverse_range = range;
+      if (comp.get_kind() == component_kind::resistor
+        || comp.get_kind() == component_kind::capacitor
+        || comp.get_kind() == component_kind::inductor) {
+        inverse_range = segment(1.0 / low_z, 1.0 / high_z);
+      } else {
+        invert(inverse_range);
+      }
+
+      parts.push_back(part_forms{{comp.evaluate(freq), low_z, high_z},
+        range.center, range.terms[0], range.radius, inverse_range.center,
+        inverse_range.terms[0], inverse_range.radius});
+    }
+
+    compile_folded(circ, tolerance_index, freq, compiled.program);
+
+    // Parts get slots in the order they're found (so a sub circuit's are
+    // together), slot_of / tolerance_of mapping between slots and
+    // tolerances:
+    std::vector<size_t> slot_of(tolerances.size(), no_slot);
+    for (auto &s : compiled.program) {
+      if (s.type != folded_step_type::part) {
+        continue;
+      }
+
+      size_t &slot = slot_of[s.index];
+      if (slot == no_slot) {
+        slot = compiled.tolerance_of.size();
+        compiled.tolerance_of.push_back(s.index);
+      }
+      s.index = slot;
+    }
+
+    for (const auto &k : compiled.tolerance_of) {
+      compiled.parts.push_back(parts[k]);
+    }
+    return compiled;
+  }
+
+//------------------------------------------------------------------------------
+
+  enum class objective {max_magnitude, min_magnitude, max_phase, min_phase};
+
+  // Highest score possible within the bound (each search maximises):
+  double best_score(const impedance_bound &bound, const objective &goal)
+  {
+    switch (goal) {
+      case objective::max_magnitude:
+        return bound.max_magnitude;
+      case objective::min_magnitude:
+        return -bound.min_magnitude;
+      case objective::max_phase:
+        return bound.max_phase;
+      default:
+        return -bound.min_phase;
+    }
+  }
+
+  // A branch has to beat the best corner by more than this to be searched
+  // (corners within it of each other are left as ties, which can't be
+  // told apart from rounding anyway):
+  const double magnitude_tolerance = 1e-9;
+  const double phase_tolerance = 1e-9;
+
+  double get_slack(const double &best, const objective &goal)
+  {
+    if (goal == objective::max_magnitude || goal == objective::min_magnitude) {
+      return magnitude_tolerance * std::abs(best);
+    }
+    return phase_tolerance;
+  }
+
+  // Score of a single impedance (as best_score() of its bound):
+  double score(const std::complex<double> &z, const objective &goal)
+  {
+    switch (goal) {
+      case objective::max_magnitude:
+        return std::abs(z);
+      case objective::min_magnitude:
+        return -std::abs(z);
+      case objective::max_phase:
+        return std::arg(z);
+      default:
+        return -std::arg(z);
+    }
+  }
+
+  class corner_search
+  {
+  private:
+    const compiled_circuit &compiled;
+    objective goal;
+    size_t node_limit;
+
+    // Slots with the most spread first, and the state tried first for each:
+    std::vector<size_t> order;
+    std::vector<uint8_t> preferred;
+
+    std::mutex best_mutex;
+    std::atomic<double> best_value;
+    std::vector<bool> best_high;
+    std::complex<double> best_impedance;
+
+    // Scores may be NaN (e.g. a short in parallel), those never win:
+    void offer(const std::vector<uint8_t> &states,
+      const std::complex<double> &z)
+    {
+      double value = score(z, goal);
+      if (!(value >= best_value.load())) {
+        return;
+      }
+
+      // In the order of the tolerances:
+      std::vector<bool> high_parts(states.size());
+      for (size_t slot{}; slot < states.size(); ++slot) {
+        high_parts[compiled.tolerance_of[slot]] = (states[slot] == at_high);
+      }
+
+      std::lock_guard<std::mutex> lock{best_mutex};
+      double best = best_value.load();
+      if (value > best || (value == best && high_parts < best_high)) {
+        best_high = std::move(high_parts);
+        best_impedance = z;
+        best_value.store(value);
+      }
+    }
+
+    // Evaluates a node, returns false if it can be dropped (bounds are
+    // counted, leaves offered):
+    bool visit(const std::vector<uint8_t> &states, const size_t &depth,
+      workspace &space)
+    {
+      if (stopped.load()) {
+        return false;
+      }
+
+      const affine_form &form = evaluate_states(compiled, states, space);
+
+      if (depth == order.size()) {
+        ++corners;
+        offer(states, form.center);
+        return false;
+      }
+
+      if (bounds.fetch_add(1) >= node_limit && node_limit != 0) {
+        stopped.store(true);
+        return false;
+      }
+
+      double best = best_value.load();
+      return !(best_score(make_bound(form), goal) <= best
+        + get_slack(best, goal));
+    }
+
+    // Depth first below a node, preferred state first (stopping at depth
+    // split, the nodes there going to jobs, if jobs is given):
+    void branch(std::vector<uint8_t> &states, const size_t &depth,
+      workspace &space, const size_t &split = 0,
+      std::vector<std::vector<uint8_t>> *jobs = nullptr)
+    {
+      if (jobs != nullptr && depth == split) {
+        jobs->push_back(states);
+        return;
+      }
+      if (!visit(states, depth, space)) {
+        return;
+      }
+
+      size_t slot = order[depth];
+      uint8_t first = preferred[slot];
+      uint8_t second = static_cast<uint8_t>(at_low + at_high - first);
+      for (uint8_t state : {first, second}) {
+        states[slot] = state;
+        branch(states, depth + 1, space, split, jobs);
+      }
+      states[slot] = in_range;
+    }
+
+  public:
+    std::atomic<size_t> corners{0};
+    std::atomic<size_t> bounds{0};
+    std::atomic<bool> stopped{false};
+
+    corner_search(const compiled_circuit &compiled, const objective &goal,
+      const size_t &node_limit)
+      : compiled{compiled}, goal{goal}, node_limit{node_limit},
+        best_value{-unbounded}
+    {
+      // Sign of each part's effect moved alone (the others at nominal):
+      size_t count = compiled.parts.size();
+      std::vector<uint8_t> states(count, at_nominal);
+      workspace space;
+      preferred.resize(count);
+
+      for (size_t k{}; k < count; ++k) {
+        states[k] = at_low;
+        double low_score = score(
+          evaluate_states(compiled, states, space).center, goal);
+        states[k] = at_high;
+        double high_score = score(
+          evaluate_states(compiled, states, space).center, goal);
+        states[k] = at_nominal;
+
+        preferred[k] = (high_score > low_score) ? at_high : at_low;
+      }
+
+      // Fixing the parts that move the total most first shrinks the bounds
+      // fastest (a part mostly turning the phase still widens the |Z|
+      // bound through the second order remainder, so this beats ordering
+      // by the objective's own sensitivity):
+      states.assign(count, in_range);
+      const affine_form &root = evaluate_states(compiled, states, space);
+      std::vector<double> spread(count);
+      for (size_t k{root.first}; k < root.last; ++k) {
+        spread[k] = std::abs(root.terms[k]);
+      }
+
+      for (size_t k{}; k < count; ++k) {
+        order.push_back(k);
+      }
+      std::stable_sort(order.begin(), order.end(),
+        [&](const size_t &a, const size_t &b) {
+          return spread[a] > spread[b];
+        });
+    }
+
+    void run(const size_t &threads)
+    {
+      size_t count = order.size();
+      workspace space;
+
+      // Corner the signs point to:
+      std::vector<uint8_t> states(preferred);
+      ++corners;
+      offer(states, evaluate_states(compiled, states, space).center);
+
+      // The first levels are searched here, the nodes left below them
+      // being the jobs split across threads:
+      size_t split{};
+      while (split < count && (size_t{1} << split) < (8 * threads)) {
+        ++split;
+      }
+
+      std::vector<std::vector<uint8_t>> jobs;
+      states.assign(count, in_range);
+      branch(states, 0, space, split, &jobs);
+
+      parallel_for(jobs.size(), [&](const size_t &job) {
+        workspace job_space;
+        branch(jobs[job], split, job_space);
+      }, threads);
+    }
+
+    tolerance_corner get_corner() const
+    {
+      return tolerance_corner{best_high, best_impedance};
+    }
+  };
+}
+
+//------------------------------------------------------------------------------
+
+impedance_bound circuits::bound_impedance(const circuit &circ,
+  const std::vector<component_tolerance> &tolerances, const double &freq)
+{
+  compiled_circuit compiled = compile_tolerances(circ, tolerances, freq);
+
+  std::vector<uint8_t> states(compiled.parts.size(), in_range);
+  workspace space;
+  return make_bound(evaluate_states(compiled, states, space));
+}
+
+//------------------------------------------------------------------------------
+
+corner_analysis circuits::find_worst_corners(const circuit &circ,
+  const std::vector<component_tolerance> &tolerances, const double &freq,
+  const size_t &node_limit, const size_t &threads)
+{
+  compiled_circuit compiled = compile_tolerances(circ, tolerances, freq);
+
+  corner_analysis analysis;
+  analysis.frequency = freq;
+  analysis.corners = 0;
+  analysis.bounds = 0;
+  analysis.complete = true;
+
+  std::vector<uint8_t> states(compiled.parts.size(), in_range);
+  workspace space;
+  analysis.bound = make_bound(evaluate_states(compiled, states, space));
+
+  size_t workers = (threads == 0) ? get_thread_count() : threads;
+
+  auto search = [&](const objective &goal) {
+    corner_search searcher{compiled, goal, node_limit};
+    searcher.run(workers);
+
+    analysis.corners += searcher.corners.load();
+    analysis.bounds += searcher.bounds.load();
+    if (searcher.stopped.load()) {
+      analysis.complete = false;
+    }
+    return searcher.get_corner();
+  };
+
+  analysis.max_magnitude = search(objective::max_magnitude);
+  analysis.min_magnitude = search(objective::min_magnitude);
+  analysis.max_phase = search(objective::max_phase);
+  analysis.min_phase = search(objective::min_phase);
+
+  return analysis;
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,110 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Worst case tolerance corners (affine bounds, branch and bound):
+//------------------------------------------------------------------------------
+
+#ifndef corners_hpp
+#define corners_hpp
+
+#include "circuit.hpp"
+
+//------------------------------------------------------------------------------
+// The cheap pass evaluates the circuit in complex affine arithmetic: each
+// toleranced part is its nominal impedance plus a term times its own noise
+// symbol in [-1, 1], sums are exact and reciprocals keep the linear part with
+// a disk holding the rest, so the result (a zonotope plus a disk) holds the
+// impedance at every combination of values, corners included. Ideal parts in
+// parallel runs are carried as exact admittance segments.
+//
+// The corner search is branch and bound over that: parts are fixed high or
+// low one at a time, largest effect first, and a branch is dropped as soon as
+// the bound over its remaining parts can't beat the best corner so far by
+// more than a relative 1e-9 (magnitude) / 1e-9 rad (phase). The sensitivity
+// signs give the first corner tried (for a circuit monotonic in each part
+// that is already the answer, the search only has to prove it), and the
+// first few levels of the search are split across threads.
+//
+// Both work on a copy of the circuit compiled once at the frequency: parts
+// without a tolerance (and nested circuits with none inside) are folded to
+// fixed values, leaving a handful of steps per node.
+//------------------------------------------------------------------------------
+
+namespace circuits
+{
+  // A component, by depth first index (the order of fault_table), whose
+  // value (the one set_value() changes) lies within +/- relative of its own:
+  struct component_tolerance
+  {
+    size_t component;
+    double relative;
+  };
+
+  // A disk holding every impedance reachable within the tolerances, and the
+  // ranges of magnitude and phase (radians) of the affine bound:
+  // (the radius is infinite if a reciprocal took in 0)
+  struct impedance_bound
+  {
+    std::complex<double> center;
+    double radius;
+
+    double min_magnitude;
+    double max_magnitude;
+    double min_phase;
+    double max_phase;
+  };
+
+  struct tolerance_corner
+  {
+    // For each tolerance (in the order given), true if at the top of its
+    // range, false if at the bottom:
+    std::vector<bool> high;
+
+    std::complex<double> impedance;
+  };
+
+  struct corner_analysis
+  {
+    double frequency;
+
+    // Over the whole tolerance box (not just the corners):
+    impedance_bound bound;
+
+    tolerance_corner max_magnitude;
+    tolerance_corner min_magnitude;
+    tolerance_corner max_phase;
+    tolerance_corner min_phase;
+
+    // Corners evaluated and bounds found, over all four searches:
+    size_t corners;
+    size_t bounds;
+
+    // False if a search stopped at the node limit (the corners are then the
+    // best found, not proven extremes):
+    bool complete;
+  };
+
+//------------------------------------------------------------------------------
+
+  // Disk bound at freq (Hz, must be positive). Only resistors, capacitors and
+  // inductors (ideal or not) can have a tolerance, each one at most, and the
+  // ends of every range go through that component's own range checks:
+  impedance_bound bound_impedance(const circuit &circ,
+    const std::vector<component_tolerance> &tolerances, const double &freq);
+
+  // Corners with the largest / smallest magnitude and phase at freq. Each
+  // search stops after node_limit bounds (0 = no limit), and the branches
+  // below the first few levels are split across threads (0 = one per core).
+  // Each corner found is within the tolerance above of the true extreme;
+  // exact ties go to the corner first in order (low before high):
+  corner_analysis find_worst_corners(const circuit &circ,
+    const std::vector<component_tolerance> &tolerances, const double &freq,
+    const size_t &node_limit = 0, const size_t &threads = 0);
+}
+
+//------------------------------------------------------------------------------
+#endif
+//------------------------------------------------------------------------------
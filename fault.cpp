@@ -0,0 +1,191 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Single fault simulation (each component opened / shorted in turn):
+//------------------------------------------------------------------------------
+
+#include "fault.hpp"
+#include "impedance_tree.hpp"
+#include "parallel.hpp"
+
+#include <limits>
+
+using namespace circuits;
+
+//------------------------------------------------------------------------------
+// Helper functions (only used in this file):
+//------------------------------------------------------------------------------
+
+namespace
+{
+  const std::complex<double> open_impedance{
+    std::numeric_limits<double>::infinity(), 0.0};
+
+  // Z = (a z + b) / (c z + d), only the ratios matter so it is kept scaled
+  // to a largest entry of 1 (deep nesting would otherwise overflow):
+  struct bilinear_map
+  {
+    std::complex<double> a{1.0};
+    std::complex<double> b{};
+    std::complex<double> c{};
+    std::complex<double> d{1.0};
+
+    std::complex<double> at_open() const
+    {
+      return (c == 0.0) ? open_impedance : (a / c);
+    }
+
+    std::complex<double> at_short() const
+    {
+      return (d == 0.0) ? open_impedance : (b / d);
+    }
+  };
+
+  double largest_part(const std::complex<double> &z)
+  {
+    return std::max(std::abs(z.real()), std::abs(z.imag()));
+  }
+
+  // outer(inner(z)):
+  bilinear_map compose(const bilinear_map &outer, const bilinear_map &inner)
+  {
+    bilinear_map map;
+    map.a = (outer.a * inner.a) + (outer.b * inner.c);
+    map.b = (outer.a * inner.b) + (outer.b * inner.d);
+    map.c = (outer.c * inner.a) + (outer.d * inner.c);
+    map.d = (outer.c * inner.b) + (outer.d * inner.d);
+
+    double scale = std::max({largest_part(map.a), largest_part(map.b),
+      largest_part(map.c), largest_part(map.d)});
+
+    if (scale > 0.0 && std::isfinite(scale)) {
+      map.a /= scale;
+      map.b /= scale;
+      map.c /= scale;
+      map.d /= scale;
+    }
+
+    return map;
+  }
+
+//------------------------------------------------------------------------------
+
+  // lift takes this circuit's impedance to the top level circuit's:
+  void fault_pass(const circuit &circ, const impedance_tree &node,
+    const bilinear_map &lift, fault_table &table)
+  {
+    const auto &comps = circ.get_components();
+    const auto &z = node.impedances;
+    size_t n = comps.size();
+
+    // Run sums (z or 1/z) of the components before / after each one in its
+    // own run:
+    std::vector<std::complex<double>> before(n);
+    std::vector<std::complex<double>> after(n);
+
+    // Run totals, and the sum of those before / after each run:
+    std::vector<size_t> run_of(n);
+    std::vector<std::complex<double>> run_totals;
+
+    for (size_t i{}; i < n;) {
+      char conn = comps[i]->get_connection_type();
+      size_t j{i};
+      while (j < n && comps[j]->get_connection_type() == conn) {
+        ++j;
+      }
+
+      std::complex<double> sum{};
+      for (size_t k{i}; k < j; ++k) {
+        before[k] = sum;
+        sum += (conn == 'p') ? (1.0 / z[k]) : z[k];
+        run_of[k] = run_totals.size();
+      }
+
+      sum = 0.0;
+      for (size_t k{j}; k-- > i;) {
+        after[k] = sum;
+        sum += (conn == 'p') ? (1.0 / z[k]) : z[k];
+      }
+
+      run_totals.push_back((conn == 'p') ? (1.0 / sum) : sum);
+      i = j;
+    }
+
+    std::vector<std::complex<double>> runs_before(run_totals.size() + 1);
+    std::vector<std::complex<double>> runs_after(run_totals.size() + 1);
+    for (size_t r{}; r < run_totals.size(); ++r) {
+      runs_before[r + 1] = runs_before[r] + run_totals[r];
+    }
+    for (size_t r{run_totals.size()}; r-- > 0;) {
+      runs_after[r] = runs_after[r + 1] + run_totals[r];
+    }
+
+    size_t child{};
+    for (size_t i{}; i < n; ++i) {
+      // Everything outside this component's run:
+      std::complex<double> rest = runs_before[run_of[i]]
+        + runs_after[run_of[i] + 1];
+
+      // Series: Z = rest + others + z
+      // Parallel: Z = rest + 1 / (others + 1/z)
+      bilinear_map local;
+      if (comps[i]->get_connection_type() == 'p') {
+        std::complex<double> others = before[i] + after[i];
+        local.a = (rest * others) + 1.0;
+        local.b = rest;
+        local.c = others;
+        local.d = 1.0;
+      } else {
+        local.b = rest + before[i] + after[i];
+      }
+
+      bilinear_map map = compose(lift, local);
+
+      table.components.push_back(comps[i].get());
+      table.open.push_back(map.at_open());
+      table.shorted.push_back(map.at_short());
+
+      if (auto sub = dynamic_cast<const circuit *>(comps[i].get())) {
+        fault_pass(*sub, node.children[child], map, table);
+        ++child;
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+
+fault_table circuits::simulate_faults(const circuit &circ,
+  const double &freq)
+{
+  impedance_tree root = build_impedance_tree(circ, freq);
+
+  fault_table table;
+  table.frequency = freq;
+  table.components.reserve(root.count);
+  table.open.reserve(root.count);
+  table.shorted.reserve(root.count);
+
+  fault_pass(circ, root, bilinear_map{}, table);
+
+  return table;
+}
+
+//------------------------------------------------------------------------------
+
+std::vector<fault_table> circuits::simulate_faults(const circuit &circ,
+  const std::vector<double> &frequencies, const size_t &threads)
+{
+  std::vector<fault_table> tables(frequencies.size());
+
+  parallel_for(frequencies.size(), [&](const size_t &i) {
+    tables[i] = simulate_faults(circ, frequencies[i]);
+  }, threads);
+
+  return tables;
+}
+
+//------------------------------------------------------------------------------
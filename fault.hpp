@@ -0,0 +1,53 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Single fault simulation (each component opened / shorted in turn):
+//------------------------------------------------------------------------------
+
+#ifndef fault_hpp
+#define fault_hpp
+
+#include "circuit.hpp"
+
+//------------------------------------------------------------------------------
+// The circuit impedance is a bilinear function of any one component's
+// impedance z: Z = (a z + b) / (c z + d). Within a circuit a, b, c, d come
+// from prefix / suffix sums over the series / parallel runs (the same runs as
+// set_impedance()), and through nested circuits they compose as 2x2 matrices.
+// So after one pass to find every impedance, each open (z -> infinity) and
+// short (z = 0) costs O(1), and all of them O(n), nested components included.
+//------------------------------------------------------------------------------
+
+namespace circuits
+{
+  struct fault_table
+  {
+    double frequency;
+
+    // Every component in depth first order (a nested circuit comes just
+    // before its own components, which are faulted too):
+    std::vector<const component *> components;
+
+    // Circuit impedance with each component open / shorted in turn (Ohms,
+    // infinite real part if the fault leaves the circuit open):
+    std::vector<std::complex<double>> open;
+    std::vector<std::complex<double>> shorted;
+  };
+
+//------------------------------------------------------------------------------
+
+  // All single faults at freq (Hz), the circuit isn't changed:
+  fault_table simulate_faults(const circuit &circ, const double &freq);
+
+  // All single faults at each frequency, frequencies are split across
+  // threads (0 = one per core), all sharing the circuit (through evaluate()):
+  std::vector<fault_table> simulate_faults(const circuit &circ,
+    const std::vector<double> &frequencies, const size_t &threads = 0);
+}
+
+//------------------------------------------------------------------------------
+#endif
+//------------------------------------------------------------------------------
@@ -0,0 +1,186 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Circuit of the six basic component types without virtual calls:
+//------------------------------------------------------------------------------
+
+#include "flat_circuit.hpp"
+#include "resistors.hpp"
+#include "capacitors.hpp"
+#include "inductors.hpp"
+
+using namespace circuits;
+
+namespace
+{
+  // Impedance of a run from its sum:
+  std::complex<double> run_total(const bool &parallel,
+    const std::complex<double> &sum)
+  {
+    return parallel ? (1.0 / sum) : sum;
+  }
+}
+
+//------------------------------------------------------------------------------
+
+flat_component circuits::make_flat_component(const component &comp)
+{
+  switch (comp.get_symbol()) {
+    case 'R':
+      return flat_resistor{comp.get_value()};
+    case 'C':
+      return flat_capacitor{comp.get_value()};
+    case 'L':
+      return flat_inductor{comp.get_value()};
+
+    case 'r': {
+      const auto &part = dynamic_cast<const real_resistor&>(comp);
+      return flat_real_resistor{part.get_value(), part.get_inductance(),
+        part.get_capacitance()};
+    }
+    case 'c': {
+      const auto &part = dynamic_cast<const real_capacitor&>(comp);
+      return flat_real_capacitor{part.get_resistance(), part.get_inductance(),
+        part.get_value()};
+    }
+    case 'l': {
+      const auto &part = dynamic_cast<const real_inductor&>(comp);
+      return flat_real_inductor{part.get_resistance(), part.get_value(),
+        part.get_capacitance()};
+    }
+  }
+
+  throw std::invalid_argument{"Only resistors, capacitors and inductors "
+    "can be flattened (found " + comp.get_type() + ")."};
+}
+
+//------------------------------------------------------------------------------
+// Constructors:
+//------------------------------------------------------------------------------
+
+// Default constructor:
+flat_circuit::flat_circuit() {}
+
+flat_circuit::flat_circuit(const circuit &circ)
+{
+  set_frequency(circ.get_frequency());
+
+  for (const auto &comp : circ.get_components()) {
+    add_component(make_flat_component(*comp), comp->get_connection_type());
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void flat_circuit::add_component(const flat_component &part, const char &conn)
+{
+  if (conn != 's' && conn != 'p') {
+    throw std::invalid_argument{"Connection type must be either s/p."};
+  }
+
+  uint32_t position = size++;
+
+  // Appends to the batch for this type (picked at compile time per type):
+  std::visit([&](const auto &value) {
+    using part_type = std::decay_t<decltype(value)>;
+    auto &batch = std::get<type_batch<part_type>>(batches);
+
+    batch.parts.push_back(value);
+    batch.positions.push_back(position);
+  }, part);
+
+  double omega = (2 * M_PI * frequency);
+  std::complex<double> part_impedance = std::visit([&](const auto &value) {
+    return flat_impedance(value, omega);
+  }, part);
+  part_impedances.push_back(part_impedance);
+
+  // Starts a new run when the connection type changes:
+  bool parallel = (conn == 'p');
+  if (runs.empty() || runs.back().parallel != parallel) {
+    if (!runs.empty()) {
+      closed_total += run_total(runs.back().parallel, last_sum);
+    }
+    last_sum = 0.0;
+    runs.push_back(run{position, position + 1, parallel});
+  } else {
+    runs.back().end = position + 1;
+  }
+
+  last_sum += parallel ? (1.0 / part_impedance) : part_impedance;
+  impedance = closed_total + run_total(parallel, last_sum);
+}
+
+//------------------------------------------------------------------------------
+// Evaluation:
+//------------------------------------------------------------------------------
+
+void flat_circuit::set_impedance()
+{
+  double omega = (2 * M_PI * frequency);
+
+  // One loop per type, no dispatch inside the loops:
+  std::apply([&](const auto &...batch) {
+    ([&]() {
+      for (size_t i{}; i < batch.parts.size(); ++i) {
+        part_impedances[batch.positions[i]]
+          = flat_impedance(batch.parts[i], omega);
+      }
+    }(), ...);
+  }, batches);
+
+  closed_total = 0.0;
+  last_sum = 0.0;
+
+  for (size_t r{}; r < runs.size(); ++r) {
+    std::complex<double> sum{};
+
+    if (runs[r].parallel) {
+      // (1 / Total Z) = 1/z1 + 1/z2 + 1/z3 + ...:
+      for (uint32_t i{runs[r].begin}; i < runs[r].end; ++i) {
+        sum += (1.0 / part_impedances[i]);
+      }
+    } else {
+      for (uint32_t i{runs[r].begin}; i < runs[r].end; ++i) {
+        sum += part_impedances[i];
+      }
+    }
+
+    if (r + 1 < runs.size()) {
+      closed_total += run_total(runs[r].parallel, sum);
+    } else {
+      last_sum = sum;
+    }
+  }
+
+  impedance = runs.empty() ? std::complex<double>{}
+    : closed_total + run_total(runs.back().parallel, last_sum);
+}
+
+void flat_circuit::set_frequency(const double &freq)
+{
+  if (freq < 0.0) {
+    throw std::out_of_range{"Cannot have negative frequency."};
+  }
+
+  frequency = freq;
+  set_impedance();
+}
+
+double flat_circuit::get_frequency() const
+{
+  return frequency;
+}
+
+std::complex<double> flat_circuit::get_impedance() const
+{
+  return impedance;
+}
+
+size_t flat_circuit::get_size() const
+{
+  return size;
+}
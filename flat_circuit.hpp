@@ -0,0 +1,193 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Circuit of the six basic component types without virtual calls:
+//------------------------------------------------------------------------------
+
+#ifndef flat_circuit_hpp
+#define flat_circuit_hpp
+
+#include "circuit.hpp"
+
+#include <cstdint>
+#include <tuple>
+#include <variant>
+
+//------------------------------------------------------------------------------
+// Components are plain values (no vtable, type string or heap allocation),
+// stored in one array per type. Evaluating a frequency runs one tight loop per
+// type (all resistors, then all capacitors, ...), then combines the series /
+// parallel runs in the same order as circuit::set_impedance (results agree
+// with the virtual path to rounding).
+//------------------------------------------------------------------------------
+
+namespace circuits
+{
+  struct flat_resistor
+  {
+    double resistance;
+  };
+
+  struct flat_capacitor
+  {
+    double capacitance;
+  };
+
+  struct flat_inductor
+  {
+    double inductance;
+  };
+
+  // Non-ideal types, same models as the component classes:
+  struct flat_real_resistor
+  {
+    double resistance;
+    double inductance;
+    double capacitance;
+  };
+
+  struct flat_real_capacitor
+  {
+    double resistance;
+    double inductance;
+    double capacitance;
+  };
+
+  struct flat_real_inductor
+  {
+    double resistance;
+    double inductance;
+    double capacitance;
+  };
+
+  using flat_component = std::variant<flat_resistor, flat_capacitor,
+    flat_inductor, flat_real_resistor, flat_real_capacitor,
+    flat_real_inductor>;
+
+//------------------------------------------------------------------------------
+
+  // Impedance of each type at angular frequency omega (rad/s):
+  inline std::complex<double> flat_impedance(
+    const flat_resistor &part, const double &)
+  {
+    return std::complex<double>{part.resistance, 0.0};
+  }
+
+  inline std::complex<double> flat_impedance(
+    const flat_capacitor &part, const double &omega)
+  {
+    return std::complex<double>{0.0, (-1.0 / (omega * part.capacitance))};
+  }
+
+  inline std::complex<double> flat_impedance(
+    const flat_inductor &part, const double &omega)
+  {
+    return std::complex<double>{0.0, (omega * part.inductance)};
+  }
+
+  // (R + jwL) in parallel with C:
+  inline std::complex<double> flat_parallel_rlc(const double &resistance,
+    const double &inductance, const double &capacitance, const double &omega)
+  {
+    double real_a = (1 - (omega * omega * capacitance * inductance));
+    double real_b = (omega * resistance * capacitance);
+    double denominator = (real_a * real_a) + (real_b * real_b);
+
+    double imag_numerator = (omega * inductance)
+      - (omega * omega * omega * capacitance * inductance * inductance)
+      - (omega * capacitance * resistance * resistance);
+
+    return std::complex<double>{
+      resistance / denominator, imag_numerator / denominator};
+  }
+
+  inline std::complex<double> flat_impedance(
+    const flat_real_resistor &part, const double &omega)
+  {
+    return flat_parallel_rlc(
+      part.resistance, part.inductance, part.capacitance, omega);
+  }
+
+  inline std::complex<double> flat_impedance(
+    const flat_real_capacitor &part, const double &omega)
+  {
+    return std::complex<double>{part.resistance,
+      (omega * part.inductance) - (1 / (omega * part.capacitance))};
+  }
+
+  inline std::complex<double> flat_impedance(
+    const flat_real_inductor &part, const double &omega)
+  {
+    return flat_parallel_rlc(
+      part.resistance, part.inductance, part.capacitance, omega);
+  }
+
+  // Converts one of the six component classes (by symbol R, C, L, r, c, l):
+  flat_component make_flat_component(const component &comp);
+
+//------------------------------------------------------------------------------
+
+  class flat_circuit
+  {
+  private:
+    // All components of one type and where they sit in the circuit:
+    template <class T> struct type_batch
+    {
+      std::vector<T> parts;
+      std::vector<uint32_t> positions;
+    };
+
+    std::tuple<type_batch<flat_resistor>, type_batch<flat_capacitor>,
+      type_batch<flat_inductor>, type_batch<flat_real_resistor>,
+      type_batch<flat_real_capacitor>, type_batch<flat_real_inductor>>
+      batches;
+
+    // Consecutive components with the same connection type:
+    struct run
+    {
+      uint32_t begin;
+      uint32_t end;
+      bool parallel;
+    };
+    std::vector<run> runs;
+
+    uint32_t size = 0;
+    double frequency = 0;
+    std::complex<double> impedance{};
+
+    // Impedance of each component at the current frequency:
+    std::vector<std::complex<double>> part_impedances;
+
+    // Total of every run but the last, and the last run's sum (of z, or
+    // of 1 / z if parallel), so adding a component is O(1):
+    std::complex<double> closed_total{};
+    std::complex<double> last_sum{};
+
+    void set_impedance();
+
+  public:
+    // Default constructor (empty, zero frequency):
+    flat_circuit();
+
+    // Converts a circuit of basic components (throws std::invalid_argument
+    // for any other component, e.g. sub circuits or measured data):
+    explicit flat_circuit(const circuit &circ);
+
+    // Adds a component in series ('s') or parallel ('p'):
+    void add_component(const flat_component &part, const char &conn);
+
+    void set_frequency(const double &freq);
+    double get_frequency() const;
+
+    std::complex<double> get_impedance() const;
+
+    size_t get_size() const;
+  };
+}
+
+//------------------------------------------------------------------------------
+#endif
+//------------------------------------------------------------------------------
@@ -0,0 +1,131 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Circuits compiled at one frequency to a short program of steps:
+//------------------------------------------------------------------------------
+
+#include "folded_program.hpp"
+
+#include <stdexcept>
+
+using namespace circuits;
+
+//------------------------------------------------------------------------------
+
+void circuits::list_components(const circuit &circ,
+  std::vector<const component *> &comps)
+{
+  for (const auto &comp : circ.get_components()) {
+    comps.push_back(comp.get());
+    if (auto sub = dynamic_cast<const circuit *>(comp.get())) {
+      list_components(*sub, comps);
+    }
+  }
+}
+
+std::vector<const component *> circuits::check_tolerances(
+  const circuit &circ, const std::vector<component_tolerance> &tolerances,
+  std::unordered_map<const component *, size_t> &tolerance_index)
+{
+  std::vector<const component *> comps;
+  list_components(circ, comps);
+
+  std::vector<const component *> toleranced;
+  for (size_t k{}; k < tolerances.size(); ++k) {
+    const auto &tol = tolerances[k];
+    if (tol.component >= comps.size()) {
+      throw std::out_of_range{"Toleranced component "
+        + std::to_string(tol.component) + " doesn't exist (circuit has "
+        + std::to_string(comps.size()) + ")."};
+    }
+    if (!(tol.relative >= 0.0 && tol.relative < 1.0)) {
+      throw std::out_of_range{"Tolerance must be at least 0 and less "
+        "than 1."};
+    }
+
+    const component &comp = *comps[tol.component];
+    switch (comp.get_kind()) {
+      case component_kind::resistor:
+      case component_kind::capacitor:
+      case component_kind::inductor:
+      case component_kind::real_resistor:
+      case component_kind::real_capacitor:
+      case component_kind::real_inductor:
+        break;
+
+      default:
+        throw std::invalid_argument{"Only resistors, capacitors and "
+          "inductors can have a tolerance (found " + comp.get_type() + ")."};
+    }
+    if (!tolerance_index.emplace(&comp, k).second) {
+      throw std::invalid_argument{"A component can only have one "
+        "tolerance."};
+    }
+
+    // Same checks as setting the value on the component:
+    double value = comp.get_value();
+    std::unique_ptr<component> check = comp.clone();
+    check->set_value(value * (1.0 - tol.relative));
+    check->set_value(value * (1.0 + tol.relative));
+
+    toleranced.push_back(&comp);
+  }
+
+  return toleranced;
+}
+
+//------------------------------------------------------------------------------
+
+void circuits::add_fixed(std::vector<folded_step> &program, const char &conn,
+  const std::complex<double> &z)
+{
+  std::complex<double> term = (conn == 'p') ? (1.0 / z) : z;
+
+  if (!program.empty() && program.back().type == folded_step_type::fixed
+    && program.back().conn == conn) {
+    program.back().term += term;
+  } else {
+    program.push_back(folded_step{folded_step_type::fixed, conn, 0, term});
+  }
+}
+
+bool circuits::compile_folded(const circuit &circ,
+  const std::unordered_map<const component *, size_t> &varied,
+  const double &freq, std::vector<folded_step> &program)
+{
+  bool varies{};
+
+  for (const auto &comp : circ.get_components()) {
+    char conn = comp->get_connection_type();
+
+    auto found = varied.find(comp.get());
+    if (found != varied.end()) {
+      program.push_back(folded_step{folded_step_type::part, conn,
+        found->second, {}});
+      varies = true;
+      continue;
+    }
+
+    if (comp->get_kind() == component_kind::circuit) {
+      size_t start = program.size();
+      program.push_back(folded_step{folded_step_type::begin, conn, 0, {}});
+
+      if (compile_folded(static_cast<const circuit &>(*comp), varied, freq,
+        program)) {
+        program.push_back(folded_step{folded_step_type::end, conn, 0, {}});
+        varies = true;
+        continue;
+      }
+      program.resize(start);
+    }
+
+    add_fixed(program, conn, comp->evaluate(freq));
+  }
+
+  return varies;
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,180 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Circuits compiled at one frequency to a short program of steps (shared by
+// corner analysis, yield sampling and grid sweeps):
+//------------------------------------------------------------------------------
+
+#ifndef folded_program_hpp
+#define folded_program_hpp
+
+#include "circuit.hpp"
+#include "corners.hpp"
+#include "flat_circuit.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+
+//------------------------------------------------------------------------------
+// Only the parts being varied (toleranced, sampled) are left as steps. Every
+// other component, and every nested circuit with no varied part inside, is
+// folded to a fixed term of its run (neighbours in the same run merged), so
+// each evaluation runs a handful of steps however large the circuit is. The
+// runs are summed in the same order as circuit::evaluate().
+//------------------------------------------------------------------------------
+
+namespace circuits
+{
+  // Every component in depth first order (a nested circuit just before its
+  // own components, the order of fault_table):
+  void list_components(const circuit &circ,
+    std::vector<const component *> &comps);
+
+  // Each tolerance's component (in the same order), indexing them by
+  // component in tolerance_index. Throws std::out_of_range for a missing
+  // component or a tolerance outside [0, 1), std::invalid_argument for a
+  // part with no value or a second tolerance on one part, or whatever the
+  // component's own set_value() throws at either end of its range:
+  std::vector<const component *> check_tolerances(const circuit &circ,
+    const std::vector<component_tolerance> &tolerances,
+    std::unordered_map<const component *, size_t> &tolerance_index);
+
+//------------------------------------------------------------------------------
+
+  // The value set_value() changes on each type:
+  inline void set_flat_value(flat_resistor &part, const double &value)
+  {
+    part.resistance = value;
+  }
+  inline void set_flat_value(flat_capacitor &part, const double &value)
+  {
+    part.capacitance = value;
+  }
+  inline void set_flat_value(flat_inductor &part, const double &value)
+  {
+    part.inductance = value;
+  }
+  inline void set_flat_value(flat_real_resistor &part, const double &value)
+  {
+    part.resistance = value;
+  }
+  inline void set_flat_value(flat_real_capacitor &part, const double &value)
+  {
+    part.capacitance = value;
+  }
+  inline void set_flat_value(flat_real_inductor &part, const double &value)
+  {
+    part.inductance = value;
+  }
+
+  inline double get_flat_value(const flat_resistor &part)
+  {
+    return part.resistance;
+  }
+  inline double get_flat_value(const flat_capacitor &part)
+  {
+    return part.capacitance;
+  }
+  inline double get_flat_value(const flat_inductor &part)
+  {
+    return part.inductance;
+  }
+  inline double get_flat_value(const flat_real_resistor &part)
+  {
+    return part.resistance;
+  }
+  inline double get_flat_value(const flat_real_capacitor &part)
+  {
+    return part.capacitance;
+  }
+  inline double get_flat_value(const flat_real_inductor &part)
+  {
+    return part.inductance;
+  }
+
+//------------------------------------------------------------------------------
+
+  enum class folded_step_type : uint8_t {fixed, part, begin, end};
+
+  struct folded_step
+  {
+    folded_step_type type;
+
+    // Connection type in its circuit (for begin / end, of the sub circuit):
+    char conn;
+
+    // Varied part (if part), its index in the map given to compile:
+    size_t index;
+
+    // Fixed parts, already as added to their run (z, or 1/z if parallel),
+    // neighbours in the same run merged:
+    std::complex<double> term;
+  };
+
+  // Appends z to the program's last step if that is a fixed step of the same
+  // run, else starts a new one:
+  void add_fixed(std::vector<folded_step> &program, const char &conn,
+    const std::complex<double> &z);
+
+  // Appends circ at freq to the program, a part step for each component in
+  // varied. Returns true if circ holds any varied part (if not, its steps
+  // are left for the caller to fold):
+  bool compile_folded(const circuit &circ,
+    const std::unordered_map<const component *, size_t> &varied,
+    const double &freq, std::vector<folded_step> &program);
+
+//------------------------------------------------------------------------------
+
+  // Sums of one circuit level while running a program (as in
+  // circuit::evaluate()). T is an impedance, or anything with set_point(),
+  // add() and invert() found for it (corner analysis uses affine forms):
+  template <class T> struct level_sums
+  {
+    T closed;
+    T sum;
+    char run_type;
+  };
+
+  inline void set_point(std::complex<double> &z,
+    const std::complex<double> &value)
+  {
+    z = value;
+  }
+
+  inline void add(std::complex<double> &z, const std::complex<double> &other)
+  {
+    z += other;
+  }
+
+  inline void invert(std::complex<double> &z)
+  {
+    z = 1.0 / z;
+  }
+
+  // Adds the open run to the closed total:
+  template <class T> void close_run(level_sums<T> &level)
+  {
+    if (level.run_type == 'p') {
+      invert(level.sum);
+    }
+    if (level.run_type != 0) {
+      add(level.closed, level.sum);
+    }
+  }
+
+  template <class T> void start_run(level_sums<T> &level, const char &conn)
+  {
+    if (conn != level.run_type) {
+      close_run(level);
+      set_point(level.sum, 0.0);
+      level.run_type = conn;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+#endif
+//------------------------------------------------------------------------------
@@ -0,0 +1,187 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Buffered text output for printing results:
+//------------------------------------------------------------------------------
+
+#include "format.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+using namespace circuits;
+
+namespace
+{
+  // Buffer left behind by the last writer on this thread:
+  thread_local std::string spare_buffer;
+
+  // Longest number written (sign, digits, point, exponent) at precision p is
+  // well under 32 + p chars, except fixed values near 1e3 which are short:
+  size_t max_number_length(const int &precision)
+  {
+    return 32 + static_cast<size_t>(std::max(precision, 0));
+  }
+}
+
+//------------------------------------------------------------------------------
+
+char *circuits::format_number(char *first, char *last, const double &value,
+  const int &precision)
+{
+  std::chars_format format = (value <= 1e-2 || value >= 1e3)
+    ? std::chars_format::scientific : std::chars_format::fixed;
+
+  return std::to_chars(first, last, value, format, precision).ptr;
+}
+
+//------------------------------------------------------------------------------
+
+report_writer::report_writer(std::ostream &stream, const flush_policy &flush)
+  : out{stream}, policy{flush}
+{
+  precision = static_cast<int>(out.precision());
+
+  buffer.swap(spare_buffer);
+  if (buffer.size() < block_size) {
+    buffer.resize(block_size);
+  }
+}
+
+report_writer::~report_writer()
+{
+  try {
+    finish();
+  }
+  // Stream errors are the stream's business (as with iostream):
+  catch (...) {}
+
+  spare_buffer.swap(buffer);
+}
+
+//------------------------------------------------------------------------------
+
+void report_writer::write_buffer()
+{
+  if (used != 0) {
+    out.write(buffer.data(), used);
+    used = 0;
+  }
+}
+
+void report_writer::finish()
+{
+  write_buffer();
+
+  if (policy != flush_policy::none) {
+    out.flush();
+  }
+}
+
+void report_writer::flush()
+{
+  write_buffer();
+  out.flush();
+}
+
+char *report_writer::reserve(const size_t &length)
+{
+  if (used + length > buffer.size()) {
+    write_buffer();
+  }
+  return buffer.data() + used;
+}
+
+void report_writer::end_of_line()
+{
+  if (policy == flush_policy::each_line) {
+    flush();
+  }
+}
+
+//------------------------------------------------------------------------------
+
+report_writer &report_writer::operator<<(const std::string_view &text)
+{
+  // Longer than a whole block, so skip the copy:
+  if (text.size() > buffer.size()) {
+    write_buffer();
+    out.write(text.data(), text.size());
+
+  } else {
+    std::memcpy(reserve(text.size()), text.data(), text.size());
+    used += text.size();
+  }
+
+  if (policy == flush_policy::each_line
+    && text.find('\n') != std::string_view::npos) {
+    end_of_line();
+  }
+  return *this;
+}
+
+report_writer &report_writer::operator<<(const char *text)
+{
+  return *this << std::string_view{text};
+}
+
+report_writer &report_writer::operator<<(const std::string &text)
+{
+  return *this << std::string_view{text};
+}
+
+report_writer &report_writer::operator<<(const char &character)
+{
+  *reserve(1) = character;
+  ++used;
+
+  if (character == '\n') {
+    end_of_line();
+  }
+  return *this;
+}
+
+//------------------------------------------------------------------------------
+
+report_writer &report_writer::operator<<(const double &value)
+{
+  size_t length = max_number_length(precision);
+
+  // Fixed notation of a huge value can't happen (>= 1e3 is scientific):
+  char *first = reserve(length);
+  used = format_number(first, first + length, value, precision)
+    - buffer.data();
+
+  return *this;
+}
+
+report_writer &report_writer::operator<<(const scientific_number &number)
+{
+  size_t length = max_number_length(precision);
+
+  char *first = reserve(length);
+  used = std::to_chars(first, first + length, number.value,
+    std::chars_format::scientific, precision).ptr - buffer.data();
+
+  return *this;
+}
+
+report_writer &report_writer::write_integer(const long long &value)
+{
+  char *first = reserve(24);
+  used = std::to_chars(first, first + 24, value).ptr - buffer.data();
+
+  return *this;
+}
+
+report_writer &report_writer::write_integer(const unsigned long long &value)
+{
+  char *first = reserve(24);
+  used = std::to_chars(first, first + 24, value).ptr - buffer.data();
+
+  return *this;
+}
@@ -0,0 +1,120 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Buffered text output for printing results (used by all print functions):
+//------------------------------------------------------------------------------
+
+#ifndef format_hpp
+#define format_hpp
+
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+//------------------------------------------------------------------------------
+
+namespace circuits
+{
+  // When the writer flushes the stream it writes to:
+  enum class flush_policy
+  {
+    // Only hands text to the stream (when the buffer fills / at the end):
+    none,
+
+    // Also flushes the stream at the end (what print functions use):
+    on_finish,
+
+    // Flushes after every line (for logs someone is watching):
+    each_line
+  };
+
+  // Number always written in scientific notation:
+  struct scientific_number
+  {
+    double value;
+  };
+
+  inline scientific_number as_scientific(const double &value)
+  {
+    return scientific_number{value};
+  }
+
+  // Writes value as the print functions always have, scientific notation if
+  // value <= 1e-2 or value >= 1e3, fixed otherwise (returns the new end):
+  char *format_number(char *first, char *last, const double &value,
+    const int &precision);
+
+//------------------------------------------------------------------------------
+
+  class report_writer
+  {
+  private:
+    std::ostream &out;
+    flush_policy policy;
+
+    // Digits after the point (taken from the stream, as iostream used):
+    int precision;
+
+    // Reused between writers on the same thread:
+    std::string buffer;
+    size_t used = 0;
+
+    // Makes room for length more chars (writing out what's there if needed):
+    char *reserve(const size_t &length);
+
+    void write_buffer();
+    void end_of_line();
+
+  public:
+    // Buffer size (text is handed to the stream in blocks of this size):
+    static const size_t block_size = 1 << 16;
+
+    report_writer(std::ostream &stream,
+      const flush_policy &flush = flush_policy::on_finish);
+
+    // Calls finish():
+    ~report_writer();
+
+    report_writer(const report_writer &) = delete;
+    report_writer &operator=(const report_writer &) = delete;
+
+    // Hands everything to the stream, flushing it if the policy says so:
+    void finish();
+
+    // Hands everything to the stream and flushes it now:
+    void flush();
+
+//------------------------------------------------------------------------------
+
+    report_writer &operator<<(const std::string_view &text);
+    report_writer &operator<<(const char *text);
+    report_writer &operator<<(const std::string &text);
+    report_writer &operator<<(const char &character);
+
+    // Scientific / fixed as described for format_number():
+    report_writer &operator<<(const double &value);
+    report_writer &operator<<(const scientific_number &number);
+
+    template <class T, std::enable_if_t<std::is_integral_v<T>
+      && !std::is_same_v<T, char> && !std::is_same_v<T, bool>, int> = 0>
+    report_writer &operator<<(const T &value)
+    {
+      if constexpr (std::is_signed_v<T>) {
+        return write_integer(static_cast<long long>(value));
+      } else {
+        return write_integer(static_cast<unsigned long long>(value));
+      }
+    }
+
+    report_writer &write_integer(const long long &value);
+    report_writer &write_integer(const unsigned long long &value);
+  };
+}
+
+//------------------------------------------------------------------------------
+#endif
+//------------------------------------------------------------------------------
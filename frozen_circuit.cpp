@@ -0,0 +1,266 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Frozen (precomputed) circuit, used as a single component:
+//------------------------------------------------------------------------------
+
+#include "frozen_circuit.hpp"
+
+#include <limits>
+
+//------------------------------------------------------------------------------
+// Frozen Circuit Class:
+//------------------------------------------------------------------------------
+
+// For cloning unique_ptr of component:
+std::unique_ptr<component> frozen_circuit::clone() const
+{
+  return std::make_unique<frozen_circuit>(*this);
+}
+
+// Default constructor (rational form of Z = 0):
+frozen_circuit::frozen_circuit()
+{
+  kind = component_kind::frozen_circuit;
+  frequency = 0;
+  component_count = 0;
+  rational = std::make_shared<const circuits::rational_function>();
+  set_impedance();
+}
+
+//------------------------------------------------------------------------------
+
+// Parameterised constructors:
+frozen_circuit::frozen_circuit(const circuits::rational_function &compiled,
+  const size_t &comp_count)
+{
+  kind = component_kind::frozen_circuit;
+  frequency = 0;
+  component_count = comp_count;
+  rational = std::make_shared<const circuits::rational_function>(compiled);
+  set_impedance();
+}
+
+frozen_circuit::frozen_circuit(const frozen_table &samples,
+  const size_t &comp_count)
+{
+  if (samples.impedances.size() < 2
+    || samples.log_slopes.size() != samples.impedances.size()) {
+    throw std::invalid_argument{"Frozen table needs at least 2 points."};
+  }
+
+  if (samples.log_step <= 0.0) {
+    throw std::out_of_range{"Frozen table must have increasing frequency."};
+  }
+
+  kind = component_kind::frozen_circuit;
+  component_count = comp_count;
+  table = std::make_shared<const frozen_table>(samples);
+  frequency = std::exp(samples.log_f_min);
+  set_impedance();
+}
+
+//------------------------------------------------------------------------------
+
+// Copy constructor:
+frozen_circuit::frozen_circuit(const frozen_circuit &frozen)
+{
+  kind = frozen.kind;
+  impedance = frozen.impedance;
+  frequency = frozen.frequency;
+  component_count = frozen.component_count;
+  rational = frozen.rational;
+  table = frozen.table;
+}
+
+//------------------------------------------------------------------------------
+
+// Move constructor:
+frozen_circuit::frozen_circuit(frozen_circuit &&frozen)
+{
+  // Steal the data:
+  kind = frozen.kind;
+  impedance = frozen.impedance;
+  frequency = frozen.frequency;
+  component_count = frozen.component_count;
+  rational = std::move(frozen.rational);
+  table = std::move(frozen.table);
+
+  // Empty 'old' frozen_circuit data:
+  frozen.kind = component_kind::empty;
+  frozen.impedance = 0;
+  frozen.frequency = 0;
+  frozen.component_count = 0;
+}
+
+//------------------------------------------------------------------------------
+
+// Destructor:
+frozen_circuit::~frozen_circuit() {}
+
+//------------------------------------------------------------------------------
+// Table interpolation:
+//------------------------------------------------------------------------------
+
+void frozen_circuit::interpolate(const double &freq, std::complex<double> &z,
+  std::complex<double> &dz_df) const
+{
+  size_t last = table->impedances.size() - 1;
+  double u = (freq > 0.0)
+    ? (std::log(freq) - table->log_f_min) / table->log_step : 0.0;
+
+  // Outside the table the end values are held (with no slope):
+  if (u <= 0.0 || u >= last) {
+    z = (u <= 0.0) ? table->impedances.front() : table->impedances.back();
+    dz_df = 0;
+    return;
+  }
+
+  size_t i = static_cast<size_t>(u);
+  if (i == last) {
+    i = last - 1;
+  }
+  double t = u - i;
+
+  // Slopes per interval (rather than per unit ln f):
+  std::complex<double> z0 = table->impedances[i];
+  std::complex<double> z1 = table->impedances[i + 1];
+  std::complex<double> m0 = table->log_slopes[i] * table->log_step;
+  std::complex<double> m1 = table->log_slopes[i + 1] * table->log_step;
+
+  double t2 = t * t;
+  double t3 = t2 * t;
+
+  z = ((2 * t3 - 3 * t2 + 1) * z0) + ((t3 - 2 * t2 + t) * m0)
+    + ((-2 * t3 + 3 * t2) * z1) + ((t3 - t2) * m1);
+
+  // dZ/df = dZ/dt / (log_step f):
+  std::complex<double> dz_dt = ((6 * t2 - 6 * t) * z0)
+    + ((3 * t2 - 4 * t + 1) * m0) + ((-6 * t2 + 6 * t) * z1)
+    + ((3 * t2 - 2 * t) * m1);
+
+  dz_df = dz_dt / (table->log_step * freq);
+}
+
+//------------------------------------------------------------------------------
+// Access Functions:
+//------------------------------------------------------------------------------
+
+std::complex<double> frozen_circuit::evaluate(const double &freq) const
+{
+  if (freq < 0.0) {
+    throw std::out_of_range{"Cannot have negative frequency."};
+  }
+
+  if (table) {
+    std::complex<double> z;
+    std::complex<double> slope;
+    interpolate(freq, z, slope);
+    return z;
+  }
+  return rational->evaluate(freq);
+}
+
+void frozen_circuit::set_impedance()
+{
+  impedance = evaluate(frequency);
+}
+
+//------------------------------------------------------------------------------
+
+void frozen_circuit::set_value(const double &freq)
+{
+  set_frequency(freq);
+}
+
+double frozen_circuit::get_value() const
+{
+  return frequency;
+}
+
+void frozen_circuit::set_frequency(const double &freq)
+{
+  if (freq < 0.0) {
+    throw std::out_of_range{"Cannot have negative frequency."};
+  }
+
+  frequency = freq;
+  set_impedance();
+}
+
+double frozen_circuit::get_frequency() const
+{
+  return frequency;
+}
+
+std::complex<double> frozen_circuit::get_impedance_derivative() const
+{
+  if (table) {
+    std::complex<double> z, slope;
+    interpolate(frequency, z, slope);
+    return slope;
+  }
+
+  return rational->evaluate_derivative(frequency);
+}
+
+//------------------------------------------------------------------------------
+
+bool frozen_circuit::is_table() const
+{
+  return static_cast<bool>(table);
+}
+
+const circuits::rational_function &frozen_circuit::get_rational_function()
+  const
+{
+  if (table) {
+    throw std::runtime_error{"A frozen table has no rational form."};
+  }
+
+  return *rational;
+}
+
+double frozen_circuit::get_min_frequency() const
+{
+  return table ? std::exp(table->log_f_min) : 0.0;
+}
+
+double frozen_circuit::get_max_frequency() const
+{
+  if (!table) {
+    return std::numeric_limits<double>::infinity();
+  }
+
+  size_t last = table->impedances.size() - 1;
+  return std::exp(table->log_f_min + (table->log_step * last));
+}
+
+//------------------------------------------------------------------------------
+
+void frozen_circuit::write_info(circuits::report_writer &out) const
+{
+  out << "Frozen circuit:" << '\n'
+  << "    Replaces " << component_count << " components," << '\n';
+
+  if (!table) {
+    out << "    Rational function of order "
+    << rational->get_order() << "." << '\n';
+    return;
+  }
+
+  out << "    Table of " << table->impedances.size() << " points,"
+  << '\n';
+
+  double f_min = get_min_frequency();
+  double f_max = get_max_frequency();
+
+  out << "    Valid from " << f_min << " Hz";
+
+  out << " to " << f_max << " Hz." << '\n';
+}
+
+//------------------------------------------------------------------------------
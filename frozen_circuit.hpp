@@ -0,0 +1,93 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Frozen (precomputed) circuit, used as a single component:
+//------------------------------------------------------------------------------
+
+#ifndef frozen_circuit_hpp
+#define frozen_circuit_hpp
+
+#include "circuit.hpp"
+#include "rational_function.hpp"
+
+//------------------------------------------------------------------------------
+// Frozen Circuit Class:
+//------------------------------------------------------------------------------
+
+// Impedance table on a log spaced grid, Z and dZ/d(ln f) at each point:
+struct frozen_table
+{
+  double log_f_min;
+  double log_step;
+  std::vector<std::complex<double>> impedances;
+  std::vector<std::complex<double>> log_slopes;
+};
+
+// Either a compiled rational function (exact) or a table (interpolated):
+// (data is immutable, so copies of a frozen circuit share it)
+class frozen_circuit : public component
+{
+private:
+  std::shared_ptr<const circuits::rational_function> rational;
+  std::shared_ptr<const frozen_table> table;
+
+  // Original circuit size, for information only:
+  size_t component_count;
+
+  // Cubic Hermite interpolation in ln f (clamped to the table ends):
+  void interpolate(const double &freq, std::complex<double> &z,
+    std::complex<double> &dz_df) const;
+
+public:
+  // For cloning unique_ptr of frozen circuit component:
+  std::unique_ptr<component> clone() const;
+
+  // Default constructor:
+  frozen_circuit();
+
+  // Parameterised constructors:
+  frozen_circuit(const circuits::rational_function &compiled,
+    const size_t &comp_count);
+  frozen_circuit(const frozen_table &samples, const size_t &comp_count);
+
+  // Copy constructor (shares the frozen data):
+  frozen_circuit(const frozen_circuit &frozen);
+
+  // Move constructor (note double &&):
+  frozen_circuit(frozen_circuit &&frozen);
+
+  // Destructor:
+  ~frozen_circuit();
+
+//------------------------------------------------------------------------------
+
+  std::complex<double> evaluate(const double &freq) const;
+  void set_impedance();
+
+  // Value of a frozen circuit is its frequency (like circuit):
+  void set_value(const double &freq);
+  double get_value() const;
+
+  void set_frequency(const double &freq);
+  double get_frequency() const;
+
+  std::complex<double> get_impedance_derivative() const;
+
+  bool is_table() const;
+
+  // Compiled form (throws std::runtime_error for a table):
+  const circuits::rational_function &get_rational_function() const;
+
+  // Table range (Hz), 0 to infinity for the rational form:
+  double get_min_frequency() const;
+  double get_max_frequency() const;
+
+  void write_info(circuits::report_writer &out) const;
+};
+
+//------------------------------------------------------------------------------
+#endif
+//------------------------------------------------------------------------------
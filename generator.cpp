@@ -0,0 +1,229 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Synthetic circuits for stress testing (same seed gives the same circuit):
+//------------------------------------------------------------------------------
+
+#include "generator.hpp"
+#include "resistors.hpp"
+#include "capacitors.hpp"
+#include "inductors.hpp"
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+
+using namespace circuits;
+
+//------------------------------------------------------------------------------
+// Helper functions (only used in this file):
+//------------------------------------------------------------------------------
+
+namespace
+{
+  const circuit_shape all_shapes[] = {circuit_shape::series_chain,
+    circuit_shape::parallel_bank, circuit_shape::alternating,
+    circuit_shape::deep_nesting, circuit_shape::random_mix};
+
+  // Values within the range checks of each component type:
+  class part_maker
+  {
+  private:
+    std::mt19937_64 rng;
+    std::uniform_real_distribution<double> scale{0.5, 2.0};
+
+  public:
+    part_maker(const uint64_t &seed) : rng{seed} {}
+
+    std::mt19937_64 &get_rng()
+    {
+      return rng;
+    }
+
+    // type is 0 - 5 for R, C, L, r, c, l:
+    std::shared_ptr<component> make(const int &type)
+    {
+      double res = 100 * scale(rng);
+      double cap = 1e-6 * scale(rng);
+      double ind = 1e-3 * scale(rng);
+
+      switch (type) {
+        case 0: return std::make_shared<resistor>(res);
+        case 1: return std::make_shared<capacitor>(cap);
+        case 2: return std::make_shared<inductor>(ind);
+        case 3: return std::make_shared<real_resistor>(res, 1e-9, 1e-12);
+        case 4: return std::make_shared<real_capacitor>(0.1, 1e-9, cap);
+        default: return std::make_shared<real_inductor>(0.5, ind, 1e-12);
+      }
+    }
+
+    std::shared_ptr<component> make_any()
+    {
+      return make(std::uniform_int_distribution<int>{0, 5}(rng));
+    }
+  };
+
+  std::shared_ptr<component> make_nested(const double &freq,
+    std::vector<std::shared_ptr<component>> &&parts)
+  {
+    auto sub = std::make_shared<circuit>(freq, 0.0, std::move(parts));
+    sub->set_nested_bool(true);
+    return sub;
+  }
+
+  // Top level components of the circuit, connection types set:
+  std::vector<std::shared_ptr<component>> generate_parts(
+    const circuit_shape &shape, const size_t &size, const uint64_t &seed,
+    const double &freq)
+  {
+    part_maker maker{seed};
+    std::mt19937_64 &rng = maker.get_rng();
+
+    std::vector<std::shared_ptr<component>> parts;
+    parts.reserve(size);
+
+    auto add = [&](const std::shared_ptr<component> &comp, const char &conn) {
+      comp->set_connection_type(conn);
+      parts.push_back(comp);
+    };
+
+    switch (shape) {
+      case circuit_shape::series_chain:
+      case circuit_shape::parallel_bank: {
+        char conn = (shape == circuit_shape::series_chain) ? 's' : 'p';
+        for (size_t i{}; i < size; ++i) {
+          add(maker.make_any(), conn);
+        }
+        break;
+      }
+
+      case circuit_shape::alternating: {
+        std::uniform_int_distribution<size_t> run_length{1, 8};
+        char conn = 's';
+
+        while (parts.size() < size) {
+          size_t run = std::min(run_length(rng), size - parts.size());
+          for (size_t i{}; i < run; ++i) {
+            add(maker.make_any(), conn);
+          }
+          conn = (conn == 's') ? 'p' : 's';
+        }
+        break;
+      }
+
+      // Built from the innermost level out:
+      case circuit_shape::deep_nesting: {
+        size_t depth = std::clamp<size_t>(size / 4, 1, max_nesting_depth);
+        std::shared_ptr<component> inner;
+
+        for (size_t level = depth; level-- > 0;) {
+          size_t count = (size * (level + 1)) / depth - (size * level) / depth;
+          char conn = (level % 2 == 0) ? 's' : 'p';
+
+          std::vector<std::shared_ptr<component>> level_parts;
+          for (size_t i{}; i < count; ++i) {
+            auto comp = maker.make_any();
+            comp->set_connection_type(conn);
+            level_parts.push_back(comp);
+          }
+
+          if (inner) {
+            inner->set_connection_type(conn);
+            level_parts.push_back(inner);
+          }
+
+          if (level == 0) {
+            parts = std::move(level_parts);
+          } else {
+            inner = make_nested(freq, std::move(level_parts));
+          }
+        }
+        break;
+      }
+
+      case circuit_shape::random_mix: {
+        std::bernoulli_distribution switch_connection{0.3};
+        std::bernoulli_distribution nest{0.01};
+        std::uniform_int_distribution<size_t> nested_size{2, 8};
+        char conn = 's';
+
+        size_t made{};
+        while (made < size) {
+          if (switch_connection(rng)) {
+            conn = (conn == 's') ? 'p' : 's';
+          }
+
+          if (size - made >= 8 && nest(rng)) {
+            size_t count = nested_size(rng);
+            char inner_conn = (conn == 's') ? 'p' : 's';
+
+            std::vector<std::shared_ptr<component>> inner_parts;
+            for (size_t i{}; i < count; ++i) {
+              auto comp = maker.make_any();
+              comp->set_connection_type(inner_conn);
+              inner_parts.push_back(comp);
+            }
+
+            add(make_nested(freq, std::move(inner_parts)), conn);
+            made += count;
+
+          } else {
+            add(maker.make_any(), conn);
+            ++made;
+          }
+        }
+        break;
+      }
+    }
+
+    return parts;
+  }
+}
+
+//------------------------------------------------------------------------------
+
+std::string circuits::get_shape_name(const circuit_shape &shape)
+{
+  switch (shape) {
+    case circuit_shape::series_chain: return "series_chain";
+    case circuit_shape::parallel_bank: return "parallel_bank";
+    case circuit_shape::alternating: return "alternating";
+    case circuit_shape::deep_nesting: return "deep_nesting";
+    case circuit_shape::random_mix: return "random_mix";
+  }
+  return "unknown";
+}
+
+circuit_shape circuits::parse_shape_name(const std::string &name)
+{
+  for (const auto &shape : all_shapes) {
+    if (get_shape_name(shape) == name) {
+      return shape;
+    }
+  }
+  throw std::invalid_argument{"Unknown circuit shape " + name + "."};
+}
+
+//------------------------------------------------------------------------------
+
+circuit circuits::generate_circuit(const circuit_shape &shape,
+  const size_t &size, const uint64_t &seed, const double &freq)
+{
+  return circuit{freq, 1.0, generate_parts(shape, size, seed, freq)};
+}
+
+circuit circuits::generate_circuit_incrementally(const circuit_shape &shape,
+  const size_t &size, const uint64_t &seed, const double &freq)
+{
+  circuit circ{freq, 1.0};
+
+  for (auto &comp : generate_parts(shape, size, seed, freq)) {
+    circ.add_component(comp, comp->get_connection_type(),
+      comp->get_nested_bool());
+  }
+
+  return circ;
+}
@@ -0,0 +1,64 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Synthetic circuits for stress testing (same seed gives the same circuit):
+//------------------------------------------------------------------------------
+
+#ifndef generator_hpp
+#define generator_hpp
+
+#include "circuit.hpp"
+
+#include <cstdint>
+#include <string>
+
+//------------------------------------------------------------------------------
+
+namespace circuits
+{
+  enum class circuit_shape
+  {
+    // All components in series:
+    series_chain,
+
+    // All components in one parallel run:
+    parallel_bank,
+
+    // Series and parallel runs taking turns (runs of 1 to 8):
+    alternating,
+
+    // Each level is a few components and a nested circuit holding the next
+    // level (depth is capped at max_nesting_depth, levels get wider instead):
+    deep_nesting,
+
+    // Any of the six component types, random connections, with the odd
+    // small nested circuit:
+    random_mix
+  };
+
+  // Nesting is recursive, so deeper would risk the stack:
+  const size_t max_nesting_depth = 2000;
+
+  // Name used in reports / on the command line, e.g. "series_chain":
+  std::string get_shape_name(const circuit_shape &shape);
+
+  // Throws std::invalid_argument for an unknown name:
+  circuit_shape parse_shape_name(const std::string &name);
+
+  // Circuit of size components (counting those in nested circuits), built in
+  // one go, so impedance is found once:
+  circuit generate_circuit(const circuit_shape &shape, const size_t &size,
+    const uint64_t &seed, const double &freq = 1e3);
+
+  // Same components, but added one at a time through add_component():
+  // (top level only, nested circuits are still built in one go)
+  circuit generate_circuit_incrementally(const circuit_shape &shape,
+    const size_t &size, const uint64_t &seed, const double &freq = 1e3);
+}
+
+//------------------------------------------------------------------------------
+#endif
+//------------------------------------------------------------------------------
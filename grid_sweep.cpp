@@ -0,0 +1,541 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Impedance over a grid of component values x frequency:
+//------------------------------------------------------------------------------
+
+#include "grid_sweep.hpp"
+#include "folded_program.hpp"
+#include "parallel.hpp"
+
+#include <array>
+
+using namespace circuits;
+
+//------------------------------------------------------------------------------
+// Helper functions (only used in this file):
+//------------------------------------------------------------------------------
+
+namespace
+{
+  // Grid points evaluated together:
+  const size_t tile_size = 32;
+
+  using lanes = std::array<double, tile_size>;
+
+  enum class step_type : uint8_t {part, other, begin, end};
+
+  struct step
+  {
+    step_type type;
+
+    // Connection type in its circuit (for begin / end, of the sub circuit):
+    char conn;
+
+    // Swept axis (-1 if not swept):
+    int axis = -1;
+
+    // Value factor at each temperature (empty if the value doesn't drift):
+    std::vector<double> factors;
+
+    flat_component part;
+
+    // Component this step came from (evaluated directly if other):
+    const component *source;
+  };
+
+  // Adds circ's components to the program in depth first order, with the
+  // step of each component (begin for a sub circuit) in index_steps:
+  void compile(const circuit &circ, std::vector<step> &program,
+    std::vector<size_t> &index_steps)
+  {
+    for (const auto &comp : circ.get_components()) {
+      char conn = comp->get_connection_type();
+      index_steps.push_back(program.size());
+
+      switch (comp->get_kind()) {
+        case component_kind::resistor:
+        case component_kind::capacitor:
+        case component_kind::inductor:
+        case component_kind::real_resistor:
+        case component_kind::real_capacitor:
+        case component_kind::real_inductor:
+          program.push_back(step{step_type::part, conn, -1, {},
+            make_flat_component(*comp), comp.get()});
+          break;
+
+        case component_kind::circuit:
+          program.push_back(step{step_type::begin, conn, -1, {}, {},
+            comp.get()});
+          compile(static_cast<const circuit &>(*comp), program, index_steps);
+          program.push_back(step{step_type::end, conn, -1, {}, {},
+            comp.get()});
+          break;
+
+        default:
+          program.push_back(step{step_type::other, conn, -1, {}, {},
+            comp.get()});
+      }
+    }
+  }
+
+//------------------------------------------------------------------------------
+
+  // Inputs of one tile (unused lanes repeat the last point):
+  struct tile_input
+  {
+    lanes frequencies;
+    lanes omegas;
+
+    // Value of each axis at each point:
+    std::vector<lanes> axis_values;
+
+    // Temperature (index) of each point:
+    std::array<size_t, tile_size> temperatures;
+
+    // Every point at frequencies[0] (parts that don't change from point to
+    // point are then evaluated once per tile):
+    bool one_frequency;
+  };
+
+  // Sums of one circuit level. Contributions the same in every lane are
+  // kept apart as one value (only the parts of a sum that vary are per lane):
+  struct lane_sums
+  {
+    lanes closed_re;
+    lanes closed_im;
+    lanes sum_re;
+    lanes sum_im;
+
+    std::complex<double> closed_uniform;
+    std::complex<double> sum_uniform;
+    bool closed_varies;
+    bool sum_varies;
+
+    char run_type;
+  };
+
+  // 1 / z (written out, as in the lane loops):
+  std::complex<double> inverse(const std::complex<double> &z)
+  {
+    double norm = (z.real() * z.real()) + (z.imag() * z.imag());
+    return std::complex<double>{z.real() / norm, -z.imag() / norm};
+  }
+
+  void reset(lane_sums &level)
+  {
+    level.closed_re.fill(0.0);
+    level.closed_im.fill(0.0);
+    level.sum_re.fill(0.0);
+    level.sum_im.fill(0.0);
+    level.closed_uniform = 0.0;
+    level.sum_uniform = 0.0;
+    level.closed_varies = false;
+    level.sum_varies = false;
+    level.run_type = 0;
+  }
+
+  // Adds the open run to the closed total (same as set_impedance()):
+  void close_run(lane_sums &level)
+  {
+    if (level.run_type == 'p') {
+      if (!level.sum_varies) {
+        level.closed_uniform += inverse(level.sum_uniform);
+        return;
+      }
+
+      for (size_t l{}; l < tile_size; ++l) {
+        double sum_re = level.sum_re[l] + level.sum_uniform.real();
+        double sum_im = level.sum_im[l] + level.sum_uniform.imag();
+        double norm = (sum_re * sum_re) + (sum_im * sum_im);
+        level.closed_re[l] += sum_re / norm;
+        level.closed_im[l] -= sum_im / norm;
+      }
+      level.closed_varies = true;
+    } else if (level.run_type == 's') {
+      level.closed_uniform += level.sum_uniform;
+      if (!level.sum_varies) {
+        return;
+      }
+
+      for (size_t l{}; l < tile_size; ++l) {
+        level.closed_re[l] += level.sum_re[l];
+        level.closed_im[l] += level.sum_im[l];
+      }
+      level.closed_varies = true;
+    }
+  }
+
+  void start_run(lane_sums &level, const char &conn)
+  {
+    if (conn == level.run_type) {
+      return;
+    }
+
+    close_run(level);
+    if (level.sum_varies) {
+      level.sum_re.fill(0.0);
+      level.sum_im.fill(0.0);
+    }
+    level.sum_uniform = 0.0;
+    level.sum_varies = false;
+    level.run_type = conn;
+  }
+
+  void add_to_run(lane_sums &level, const char &conn, const lanes &z_re,
+    const lanes &z_im)
+  {
+    start_run(level, conn);
+    level.sum_varies = true;
+
+    if (conn == 'p') {
+      for (size_t l{}; l < tile_size; ++l) {
+        double norm = (z_re[l] * z_re[l]) + (z_im[l] * z_im[l]);
+        level.sum_re[l] += z_re[l] / norm;
+        level.sum_im[l] -= z_im[l] / norm;
+      }
+    } else {
+      for (size_t l{}; l < tile_size; ++l) {
+        level.sum_re[l] += z_re[l];
+        level.sum_im[l] += z_im[l];
+      }
+    }
+  }
+
+  // Same for an impedance equal in every lane:
+  void add_to_run(lane_sums &level, const char &conn,
+    const std::complex<double> &z)
+  {
+    start_run(level, conn);
+    level.sum_uniform += (conn == 'p') ? inverse(z) : z;
+  }
+
+  // Closes the level, its total going to z_re / z_im (returns false), or to
+  // z if the same in every lane (returns true):
+  bool close_level(lane_sums &level, lanes &z_re, lanes &z_im,
+    std::complex<double> &z)
+  {
+    close_run(level);
+    if (!level.closed_varies) {
+      z = level.closed_uniform;
+      return true;
+    }
+
+    for (size_t l{}; l < tile_size; ++l) {
+      z_re[l] = level.closed_re[l] + level.closed_uniform.real();
+      z_im[l] = level.closed_im[l] + level.closed_uniform.imag();
+    }
+    return false;
+  }
+
+//------------------------------------------------------------------------------
+
+  // One loop per type, the value changing per lane if swept and / or drifting
+  // (the value is then the swept or own value x the temperature's factor).
+  // Returns true, with the impedance in z, if the same in every lane:
+  bool part_impedances(const step &s, const tile_input &input, lanes &z_re,
+    lanes &z_im, std::complex<double> &z)
+  {
+    const lanes *swept = (s.axis < 0) ? nullptr : &input.axis_values[s.axis];
+    bool drifts = !s.factors.empty();
+
+    if (swept == nullptr && !drifts && input.one_frequency) {
+      z = std::visit([&](const auto &value) {
+        return flat_impedance(value, input.omegas[0]);
+      }, s.part);
+      return true;
+    }
+
+    std::visit([&](const auto &value) {
+      using part_type = std::decay_t<decltype(value)>;
+
+      if (swept == nullptr && !drifts) {
+        for (size_t l{}; l < tile_size; ++l) {
+          std::complex<double> lane_z = flat_impedance(value, input.omegas[l]);
+          z_re[l] = lane_z.real();
+          z_im[l] = lane_z.imag();
+        }
+      } else {
+        part_type lane_part = value;
+        double own = get_flat_value(value);
+        for (size_t l{}; l < tile_size; ++l) {
+          double lane_value = (swept == nullptr) ? own : (*swept)[l];
+          if (drifts) {
+            lane_value *= s.factors[input.temperatures[l]];
+          }
+          set_flat_value(lane_part, lane_value);
+          std::complex<double> lane_z = flat_impedance(lane_part,
+            input.omegas[l]);
+          z_re[l] = lane_z.real();
+          z_im[l] = lane_z.imag();
+        }
+      }
+    }, s.part);
+
+    return false;
+  }
+
+  // One pass over the program for all lanes of a tile, lane l written to
+  // out[l x stride]:
+  void evaluate_tile(const std::vector<step> &program,
+    const tile_input &input, std::vector<lane_sums> &levels,
+    std::complex<double> *out, const size_t &count, const size_t &stride)
+  {
+    size_t depth{};
+    reset(levels[0]);
+
+    lanes z_re;
+    lanes z_im;
+    std::complex<double> z;
+
+    for (const auto &s : program) {
+      bool uniform{};
+
+      switch (s.type) {
+        case step_type::begin:
+          ++depth;
+          if (depth == levels.size()) {
+            levels.emplace_back();
+          }
+          reset(levels[depth]);
+          continue;
+
+        // The sub circuit's total is then added to its parent as a part:
+        case step_type::end:
+          uniform = close_level(levels[depth], z_re, z_im, z);
+          --depth;
+          break;
+
+        case step_type::part:
+          uniform = part_impedances(s, input, z_re, z_im, z);
+          break;
+
+        case step_type::other:
+          if (input.one_frequency) {
+            z = s.source->evaluate(input.frequencies[0]);
+            uniform = true;
+            break;
+          }
+          for (size_t l{}; l < tile_size; ++l) {
+            std::complex<double> lane_z = s.source->evaluate(
+              input.frequencies[l]);
+            z_re[l] = lane_z.real();
+            z_im[l] = lane_z.imag();
+          }
+          break;
+      }
+
+      if (uniform) {
+        add_to_run(levels[depth], s.conn, z);
+      } else {
+        add_to_run(levels[depth], s.conn, z_re, z_im);
+      }
+    }
+
+    if (close_level(levels[0], z_re, z_im, z)) {
+      z_re.fill(z.real());
+      z_im.fill(z.imag());
+    }
+    for (size_t l{}; l < count; ++l) {
+      out[l * stride] = std::complex<double>{z_re[l], z_im[l]};
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+
+const std::complex<double> &sweep_grid::at(
+  const std::vector<size_t> &indices) const
+{
+  if (indices.size() != shape.size()) {
+    throw std::invalid_argument{"Need one index per axis and a frequency "
+      "index."};
+  }
+
+  size_t position{};
+  for (size_t k{}; k < shape.size(); ++k) {
+    if (indices[k] >= shape[k]) {
+      throw std::out_of_range{"Grid index out of range."};
+    }
+    position = (position * shape[k]) + indices[k];
+  }
+
+  return impedances[position];
+}
+
+//------------------------------------------------------------------------------
+
+sweep_grid circuits::evaluate_grid(const circuit &circ,
+  const std::vector<sweep_axis> &axes,
+  const std::vector<double> &temperatures,
+  const std::vector<double> &frequencies, const size_t &threads)
+{
+  for (const auto &freq : frequencies) {
+    if (freq < 0.0) {
+      throw std::out_of_range{"Cannot have negative frequency."};
+    }
+  }
+  for (const auto &temperature : temperatures) {
+    if (!(temperature >= absolute_zero)) {
+      throw std::out_of_range{"Temperature must be above absolute zero "
+        "(-273.15 C)."};
+    }
+  }
+
+  std::vector<step> program;
+  std::vector<size_t> index_steps;
+  compile(circ, program, index_steps);
+
+  sweep_grid grid;
+  size_t points{1};
+
+  for (size_t k{}; k < axes.size(); ++k) {
+    if (axes[k].component >= index_steps.size()) {
+      throw std::out_of_range{"Swept component "
+        + std::to_string(axes[k].component) + " doesn't exist (circuit has "
+        + std::to_string(index_steps.size()) + ")."};
+    }
+
+    step &s = program[index_steps[axes[k].component]];
+    if (s.type != step_type::part) {
+      throw std::invalid_argument{"Only resistors, capacitors and inductors "
+        "can be swept (found " + s.source->get_type() + ")."};
+    }
+    if (s.axis >= 0) {
+      throw std::invalid_argument{"A component can only be swept once."};
+    }
+    s.axis = static_cast<int>(k);
+
+    // Same checks as setting the value on the component:
+    std::unique_ptr<component> check = s.source->clone();
+    for (const auto &value : axes[k].values) {
+      check->set_value(value);
+    }
+
+    grid.shape.push_back(axes[k].values.size());
+    points *= axes[k].values.size();
+  }
+
+  // Each drifting component's factor at each temperature, found once here
+  // (so more temperatures only add the per point multiply):
+  for (auto &s : program) {
+    if (s.type != step_type::part) {
+      continue;
+    }
+
+    temperature_coefficients tc = s.source->get_temperature_coefficients();
+    if (tc.is_zero()) {
+      continue;
+    }
+
+    for (const auto &temperature : temperatures) {
+      double factor = tc.get_factor(temperature);
+      if (!(factor > 0.0)) {
+        throw std::out_of_range{"Temperature coefficients of a "
+          + s.source->get_type() + " give a value <= 0 at "
+          + std::to_string(temperature) + " C."};
+      }
+      s.factors.push_back(factor);
+    }
+  }
+
+  grid.shape.push_back(temperatures.size());
+  grid.shape.push_back(frequencies.size());
+  points *= temperatures.size();
+  size_t total = points * frequencies.size();
+  grid.impedances.resize(total);
+
+  if (total == 0) {
+    return grid;
+  }
+
+  // Sets lane l to (axes, temperature) point number point, last axis
+  // changing fastest and the temperature faster still:
+  auto set_point = [&](tile_input &input, const size_t &l,
+    const size_t &point) {
+    input.temperatures[l] = point % temperatures.size();
+
+    size_t rest = point / temperatures.size();
+    for (size_t k = axes.size(); k-- > 0;) {
+      input.axis_values[k][l] = axes[k].values[rest % axes[k].values.size()];
+      rest /= axes[k].values.size();
+    }
+  };
+
+  // With enough (axes, temperature) points, a tile is one frequency and up
+  // to 32 of those points, so parts that neither drift nor are swept are
+  // evaluated once for the whole tile:
+  if (points >= tile_size) {
+    size_t chunks = (points + tile_size - 1) / tile_size;
+
+    parallel_for(chunks * frequencies.size(), [&](const size_t &tile) {
+      size_t f = tile / chunks;
+      size_t first = (tile % chunks) * tile_size;
+      size_t count = std::min(tile_size, points - first);
+
+      tile_input input;
+      input.one_frequency = true;
+      input.frequencies.fill(frequencies[f]);
+      input.omegas.fill(2 * M_PI * frequencies[f]);
+      input.axis_values.resize(axes.size());
+
+      for (size_t l{}; l < tile_size; ++l) {
+        set_point(input, l, first + std::min(l, count - 1));
+      }
+
+      std::vector<lane_sums> levels(1);
+      evaluate_tile(program, input, levels,
+        &grid.impedances[(first * frequencies.size()) + f], count,
+        frequencies.size());
+    }, threads);
+
+    return grid;
+  }
+
+  // Otherwise tiles are runs of the output (frequency changing fastest):
+  size_t tiles = (total + tile_size - 1) / tile_size;
+
+  parallel_for(tiles, [&](const size_t &tile) {
+    size_t first = tile * tile_size;
+    size_t count = std::min(tile_size, total - first);
+
+    tile_input input;
+    input.one_frequency = false;
+    input.axis_values.resize(axes.size());
+
+    for (size_t l{}; l < tile_size; ++l) {
+      size_t point = first + std::min(l, count - 1);
+
+      double freq = frequencies[point % frequencies.size()];
+      input.frequencies[l] = freq;
+      input.omegas[l] = 2 * M_PI * freq;
+
+      set_point(input, l, point / frequencies.size());
+    }
+
+    std::vector<lane_sums> levels(1);
+    evaluate_tile(program, input, levels, &grid.impedances[first], count, 1);
+  }, threads);
+
+  return grid;
+}
+
+//------------------------------------------------------------------------------
+
+// At the nominal temperature every factor is exactly 1, so this is the same
+// grid less its (single) temperature axis:
+sweep_grid circuits::evaluate_grid(const circuit &circ,
+  const std::vector<sweep_axis> &axes,
+  const std::vector<double> &frequencies, const size_t &threads)
+{
+  sweep_grid grid = evaluate_grid(circ, axes,
+    std::vector<double>{nominal_temperature}, frequencies, threads);
+
+  grid.shape.erase(grid.shape.end() - 2);
+  return grid;
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,83 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Impedance over a grid of component values x frequency:
+//------------------------------------------------------------------------------
+
+#ifndef grid_sweep_hpp
+#define grid_sweep_hpp
+
+#include "circuit.hpp"
+
+//------------------------------------------------------------------------------
+// The circuit is compiled once into a flat list of steps (basic components as
+// plain values, nested circuits as begin / end markers, anything else through
+// evaluate()). Grid points are then evaluated in tiles of 32: one pass over
+// the steps per tile, with an inner loop over the tile's points for each
+// step, so the steps are read once per 32 points and the inner loops
+// vectorise. Tiles are split across threads. The circuit itself is never
+// changed (results agree with evaluate() to rounding).
+//
+// Temperature drift (see base_component.hpp) is compiled in too: each
+// drifting component's factor at every temperature is found once, leaving a
+// multiply per point. With 32 or more (value, temperature) points a tile
+// holds one frequency, so parts that don't drift and aren't swept (and nested
+// circuits made only of those) are evaluated and summed once per tile rather
+// than once per point.
+//------------------------------------------------------------------------------
+
+namespace circuits
+{
+  // A swept component, by depth first index (the order of fault_table, a
+  // nested circuit counting before its own components), and the values to
+  // give it (the value set_value() changes, e.g. capacitance):
+  struct sweep_axis
+  {
+    size_t component;
+    std::vector<double> values;
+  };
+
+  // Lowest temperature (Celsius) allowed:
+  const double absolute_zero = -273.15;
+
+  // Dense results, frequency changing fastest, then temperature (if given),
+  // then the last axis, ...:
+  struct sweep_grid
+  {
+    // Number of values of each axis, then the number of temperatures (if
+    // given) and the number of frequencies:
+    std::vector<size_t> shape;
+
+    std::vector<std::complex<double>> impedances;
+
+    // One index per axis, then the temperature (if given) and frequency
+    // indices:
+    const std::complex<double> &at(const std::vector<size_t> &indices) const;
+  };
+
+//------------------------------------------------------------------------------
+
+  // Impedance at every combination of axis values and frequency (Hz), tiles
+  // split across threads (0 = one per core). Only resistors, capacitors and
+  // inductors (ideal or not) can be swept, each by one axis at most, and
+  // every value goes through that component's own range checks:
+  sweep_grid evaluate_grid(const circuit &circ,
+    const std::vector<sweep_axis> &axes,
+    const std::vector<double> &frequencies, const size_t &threads = 0);
+
+  // As above at every temperature (Celsius) too, each component's value
+  // scaled by its temperature coefficients (the swept value, if swept).
+  // Throws std::out_of_range if a temperature is below absolute zero or
+  // drifts a value to zero or less:
+  sweep_grid evaluate_grid(const circuit &circ,
+    const std::vector<sweep_axis> &axes,
+    const std::vector<double> &temperatures,
+    const std::vector<double> &frequencies, const size_t &threads = 0);
+}
+
+//------------------------------------------------------------------------------
+#endif
+//------------------------------------------------------------------------------
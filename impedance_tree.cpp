@@ -0,0 +1,89 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Impedance of every component of a circuit at one frequency:
+//------------------------------------------------------------------------------
+
+#include "impedance_tree.hpp"
+
+using namespace circuits;
+
+//------------------------------------------------------------------------------
+// Helper functions (only used in this file):
+//------------------------------------------------------------------------------
+
+namespace
+{
+  // Same runs and order as circuit::evaluate():
+  std::complex<double> sum_runs(
+    const std::vector<std::shared_ptr<component>> &comps,
+    const std::vector<std::complex<double>> &impedances)
+  {
+    std::complex<double> total{};
+    std::complex<double> run_sum{};
+    char run_type{};
+
+    for (size_t i{}; i < comps.size(); ++i) {
+      char conn = comps[i]->get_connection_type();
+
+      if (conn != run_type) {
+        if (run_type == 'p') {
+          total += (1.0 / run_sum);
+        } else if (run_type == 's') {
+          total += run_sum;
+        }
+        run_sum = 0.0;
+        run_type = conn;
+      }
+
+      run_sum += (conn == 'p') ? (1.0 / impedances[i]) : impedances[i];
+    }
+
+    if (run_type == 'p') {
+      total += (1.0 / run_sum);
+    } else if (run_type == 's') {
+      total += run_sum;
+    }
+
+    return total;
+  }
+
+  void fill_tree(const circuit &circ, const double &freq, impedance_tree &tree)
+  {
+    const auto &comps = circ.get_components();
+    tree.impedances.resize(comps.size());
+    tree.count = comps.size();
+
+    for (size_t i{}; i < comps.size(); ++i) {
+      if (auto sub = dynamic_cast<const circuit *>(comps[i].get())) {
+        tree.children.emplace_back();
+        fill_tree(*sub, freq, tree.children.back());
+        tree.impedances[i] = tree.children.back().total;
+        tree.count += tree.children.back().count;
+      } else {
+        tree.impedances[i] = comps[i]->evaluate(freq);
+      }
+    }
+
+    tree.total = sum_runs(comps, tree.impedances);
+  }
+}
+
+//------------------------------------------------------------------------------
+
+impedance_tree circuits::build_impedance_tree(const circuit &circ,
+  const double &freq)
+{
+  if (freq < 0.0) {
+    throw std::out_of_range{"Cannot have negative frequency."};
+  }
+
+  impedance_tree tree;
+  fill_tree(circ, freq, tree);
+  return tree;
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,111 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Impedance of every component of a circuit at one frequency:
+//------------------------------------------------------------------------------
+
+#ifndef impedance_tree_hpp
+#define impedance_tree_hpp
+
+#include "circuit.hpp"
+
+//------------------------------------------------------------------------------
+
+namespace circuits
+{
+  // Found bottom up, so each nested circuit is evaluated once (O(n) overall,
+  // where evaluate() on every component would be O(n x nesting depth)):
+  struct impedance_tree
+  {
+    // One per component of the circuit:
+    std::vector<std::complex<double>> impedances;
+
+    // One per nested circuit, in order:
+    std::vector<impedance_tree> children;
+
+    // Circuit impedance (same runs and order as circuit::evaluate()):
+    std::complex<double> total;
+
+    // Components below this circuit, nested ones included:
+    size_t count;
+  };
+
+  // Through each component's evaluate(), the circuit isn't changed:
+  impedance_tree build_impedance_tree(const circuit &circ, const double &freq);
+
+//------------------------------------------------------------------------------
+
+  // With current flowing through circ, calls write(index, component,
+  // voltage, current) for every component in depth first order (a nested
+  // circuit just before its own components). Series runs pass the current to
+  // each component, parallel runs put their voltage across each one:
+  template <class F> void propagate_current(const circuit &circ,
+    const impedance_tree &tree, const std::complex<double> &current,
+    F &&write);
+
+  // Index of the next component to write (used by propagate_current):
+  template <class F> void propagate_current(const circuit &circ,
+    const impedance_tree &tree, const std::complex<double> &current,
+    size_t &next, F &write);
+}
+
+//------------------------------------------------------------------------------
+
+template <class F> void circuits::propagate_current(const circuit &circ,
+  const impedance_tree &tree, const std::complex<double> &current,
+  F &&write)
+{
+  size_t next{};
+  propagate_current(circ, tree, current, next, write);
+}
+
+template <class F> void circuits::propagate_current(const circuit &circ,
+  const impedance_tree &tree, const std::complex<double> &current,
+  size_t &next, F &write)
+{
+  const auto &comps = circ.get_components();
+  const auto &z = tree.impedances;
+  size_t child{};
+
+  for (size_t i{}; i < comps.size();) {
+    char conn = comps[i]->get_connection_type();
+    size_t j{i};
+    while (j < comps.size() && comps[j]->get_connection_type() == conn) {
+      ++j;
+    }
+
+    // Voltage across the whole run if parallel:
+    std::complex<double> run_voltage{};
+    if (conn == 'p') {
+      std::complex<double> reciprocal_sum{};
+      for (size_t k{i}; k < j; ++k) {
+        reciprocal_sum += (1.0 / z[k]);
+      }
+      run_voltage = current / reciprocal_sum;
+    }
+
+    for (size_t k{i}; k < j; ++k) {
+      std::complex<double> part_voltage = (conn == 'p') ? run_voltage
+        : (current * z[k]);
+      std::complex<double> part_current = (conn == 'p')
+        ? (run_voltage / z[k]) : current;
+
+      write(next++, comps[k].get(), part_voltage, part_current);
+
+      if (auto sub = dynamic_cast<const circuit *>(comps[k].get())) {
+        propagate_current(*sub, tree.children[child], part_current, next,
+          write);
+        ++child;
+      }
+    }
+
+    i = j;
+  }
+}
+
+//------------------------------------------------------------------------------
+#endif
+//------------------------------------------------------------------------------
@@ -22,8 +22,7 @@ std::unique_ptr<component> inductor::clone() const
 // Default constructor:
 inductor::inductor()
 {
-  type = "inductor";
-  symbol = 'L';
+  kind = component_kind::inductor;
   inductance = 0;
   set_impedance();
 }
@@ -43,8 +42,7 @@ inductor::inductor(const double &ind)
     throw std::out_of_range{"Inductance must be below 10 kH."};
   }
 
-  type = "inductor";
-  symbol = 'L';
+  kind = component_kind::inductor;
   inductance = ind;
   set_impedance();
 }
@@ -54,8 +52,7 @@ inductor::inductor(const double &ind)
 // Copy constructor:
 inductor::inductor(const inductor &induc)
 {
-  type = induc.type;
-  symbol = induc.symbol;
+  kind = induc.kind;
   impedance = induc.impedance;
   frequency = induc.frequency;
   inductance = induc.inductance;
@@ -67,15 +64,13 @@ inductor::inductor(const inductor &induc)
 inductor::inductor(inductor &&induc)
 {
   // Steal the data:
-  type = induc.type;
-  symbol = induc.symbol;
+  kind = induc.kind;
   impedance = induc.impedance;
   frequency = induc.frequency;
   inductance = induc.inductance;
 
   // Empty 'old' inductor data:
-  induc.type = "empty";
-  induc.symbol = 'N';
+  induc.kind = component_kind::empty;
   induc.impedance = 0;
   induc.frequency = 0;
   induc.inductance = 0;
@@ -90,10 +85,19 @@ inductor::~inductor() {}
 // Access Functions:
 //------------------------------------------------------------------------------
 
+std::complex<double> inductor::evaluate(const double &freq) const
+{
+  if (freq < 0.0) {
+    throw std::out_of_range{"Cannot have negative frequency."};
+  }
+
+  double omega = (2 * M_PI * freq);
+  return std::complex<double>{0.0, (omega * inductance)};
+}
+
 void inductor::set_impedance()
 {
-  double omega = (2 * M_PI * frequency);
-  impedance = std::complex<double>{0.0, (omega * inductance)};
+  impedance = evaluate(frequency);
 }
 
 //------------------------------------------------------------------------------
@@ -155,17 +159,18 @@ double inductor::get_frequency() const
   return frequency;
 }
 
+// Z = j 2 pi f L, so dZ/df = j 2 pi L:
+std::complex<double> inductor::get_impedance_derivative() const
+{
+  return std::complex<double>{0.0, (2 * M_PI * inductance)};
+}
+
 //------------------------------------------------------------------------------
 
-void inductor::print_info() const
+void inductor::write_info(circuits::report_writer &out) const
 {
-  if (inductance <= 1e-2 || inductance >= 1e3) {
-    std::cout << std::scientific;
-  } else {
-    std::cout << std::fixed;
-  }
-  std::cout << "Inductor:" << std::endl
-  << "    Inductance, L = " << inductance << " H," << std::endl;
+  out << "Inductor:" << '\n'
+  << "    Inductance, L = " << inductance << " H," << '\n';
 }
 
 
@@ -182,8 +187,7 @@ std::unique_ptr<component> real_inductor::clone() const
 // Default constructor:
 real_inductor::real_inductor()
 {
-  type = "real inductor";
-  symbol = 'l';
+  kind = component_kind::real_inductor;
   inductance = 0;
   resistance = 0;
   capacitance = 0;
@@ -226,8 +230,7 @@ real_inductor::real_inductor(
 
 //------------------------------------------------------------------------------
 
-  type = "real inductor";
-  symbol = 'l';
+  kind = component_kind::real_inductor;
   inductance = ind;
   resistance = res;
   capacitance = cap;
@@ -239,8 +242,7 @@ real_inductor::real_inductor(
 // Copy constructor:
 real_inductor::real_inductor(const real_inductor &induc)
 {
-  type = induc.type;
-  symbol = induc.symbol;
+  kind = induc.kind;
   impedance = induc.impedance;
   frequency = induc.frequency;
   inductance = induc.inductance;
@@ -254,8 +256,7 @@ real_inductor::real_inductor(const real_inductor &induc)
 real_inductor::real_inductor(real_inductor &&induc)
 {
   // Steal the data:
-  type = induc.type;
-  symbol = induc.symbol;
+  kind = induc.kind;
   impedance = induc.impedance;
   frequency = induc.frequency;
   inductance = induc.inductance;
@@ -263,8 +264,7 @@ real_inductor::real_inductor(real_inductor &&induc)
   capacitance = induc.capacitance;
 
   // Empty 'old' real_inductor data:
-  induc.type = "empty";
-  induc.symbol = 'N';
+  induc.kind = component_kind::empty;
   induc.impedance = 0;
   induc.frequency = 0;
   induc.inductance = 0;
@@ -281,10 +281,14 @@ real_inductor::~real_inductor() {}
 // Access Functions:
 //------------------------------------------------------------------------------
 
-void real_inductor::set_impedance()
+std::complex<double> real_inductor::evaluate(const double &freq) const
 {
+  if (freq < 0.0) {
+    throw std::out_of_range{"Cannot have negative frequency."};
+  }
+
   // Break up into smaller calcs:
-  double omega = (2 * M_PI * frequency);
+  double omega = (2 * M_PI * freq);
 
   double real_a = (1 - (pow(omega, 2) * capacitance * inductance));
   double real_b = (omega * resistance * capacitance);
@@ -297,12 +301,12 @@ void real_inductor::set_impedance()
   double ind_squared = pow(inductance, 2);
   double res_squared = pow(resistance, 2);
 
-  // Separate numerator terms:
+  // Separate numerator terms, Im[(R + jwL)(a - jb)] = wL - w^3 L^2 C - w R^2 C:
   double imag_a = (omega * inductance);
   double imag_b = (omega_cubed * capacitance * ind_squared);
   double imag_c = (omega * capacitance * res_squared);
 
-  double imag_numerator = (imag_a + imag_b - imag_c);
+  double imag_numerator = (imag_a - imag_b - imag_c);
 
 //------------------------------------------------------------------------------
 
@@ -313,36 +317,61 @@ void real_inductor::set_impedance()
 
   double imag_part = imag_numerator / imag_denominator;
 
-  impedance = std::complex<double>{real_part, imag_part};
+  return std::complex<double>{real_part, imag_part};
+}
+
+void real_inductor::set_impedance()
+{
+  impedance = evaluate(frequency);
 }
 
 //------------------------------------------------------------------------------
 
-void real_inductor::print_info() const
+// Derivative of Z = (R + jwL) / (1 - w^2 LC + jwRC) with respect to f:
+std::complex<double> real_inductor::get_impedance_derivative() const
 {
-  std::cout << "Non-ideal inductor:" << std::endl;
+  double omega = (2 * M_PI * frequency);
 
-  // Converts to scientific notation:
-  if (resistance <= 1e-2 || resistance >= 1e3) {
-    std::cout << std::scientific;
-  } else {
-    std::cout << std::fixed;
-  }
-  std::cout << "    Resistance, R = " << resistance << " Ohms," << std::endl;
+  std::complex<double> numerator{resistance, (omega * inductance)};
+  std::complex<double> denominator{
+    (1 - (pow(omega, 2) * capacitance * inductance)),
+    (omega * resistance * capacitance)};
 
-  if (inductance <= 1e-2 || inductance >= 1e3) {
-    std::cout << std::scientific;
-  } else {
-    std::cout << std::fixed;
-  }
-  std::cout << "    Inductance, L = " << inductance << " H," << std::endl;
+  // Derivatives of each part with respect to omega:
+  std::complex<double> d_numerator{0.0, inductance};
+  std::complex<double> d_denominator{
+    (-2 * omega * capacitance * inductance), (resistance * capacitance)};
 
-  if (capacitance <= 1e-2 || capacitance >= 1e3) {
-    std::cout << std::scientific;
-  } else {
-    std::cout << std::fixed;
-  }
-  std::cout << "    Capacitance, C = " << capacitance << " F." << std::endl;
+  std::complex<double> d_impedance = ((d_numerator * denominator)
+    - (numerator * d_denominator)) / (denominator * denominator);
+
+  // Chain rule, since omega = 2 pi f:
+  return (2 * M_PI * d_impedance);
+}
+
+//------------------------------------------------------------------------------
+
+double real_inductor::get_resistance() const
+{
+  return resistance;
+}
+
+double real_inductor::get_capacitance() const
+{
+  return capacitance;
+}
+
+//------------------------------------------------------------------------------
+
+void real_inductor::write_info(circuits::report_writer &out) const
+{
+  out << "Non-ideal inductor:" << '\n';
+
+  out << "    Resistance, R = " << resistance << " Ohms," << '\n';
+
+  out << "    Inductance, L = " << inductance << " H," << '\n';
+
+  out << "    Capacitance, C = " << capacitance << " F." << '\n';
 }
 
 //------------------------------------------------------------------------------
\ No newline at end of file
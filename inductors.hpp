@@ -42,6 +42,7 @@ public:
 
 //------------------------------------------------------------------------------
 
+  std::complex<double> evaluate(const double &freq) const;
   void set_impedance();
 
   void set_inductance(const double &ind);
@@ -53,7 +54,9 @@ public:
   void set_frequency(const double &freq);
   double get_frequency() const;
 
-  void print_info() const;
+  std::complex<double> get_impedance_derivative() const;
+
+  void write_info(circuits::report_writer &out) const;
 };
 
 
@@ -90,9 +93,15 @@ public:
 //------------------------------------------------------------------------------
 
   // Different calculation for impedance:
+  std::complex<double> evaluate(const double &freq) const;
   void set_impedance();
+  std::complex<double> get_impedance_derivative() const;
+
+  // Returns non-ideal parts:
+  double get_resistance() const;
+  double get_capacitance() const;
 
-  void print_info() const;
+  void write_info(circuits::report_writer &out) const;
 };
 
 //------------------------------------------------------------------------------
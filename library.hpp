@@ -0,0 +1,292 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Library container safe to read from many threads while it is being edited:
+//------------------------------------------------------------------------------
+
+#ifndef library_hpp
+#define library_hpp
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <stdexcept>
+#include <string>
+
+//------------------------------------------------------------------------------
+// How it works (read-copy-update):
+//
+// The contents are an immutable version (size + table of items) published
+// through one atomic pointer. Readers take a snapshot, which is just that
+// pointer plus a reader registration, so they never take a lock or wait.
+//
+// Writers (serialised between themselves) never change anything a reader can
+// see. Appends fill the next unused table slot then publish a version with a
+// larger size; replacing an item copies the table first. Old versions are
+// retired and only freed once every reader that could hold them has left
+// (two alternating reader counts, flipped by writers without waiting).
+//------------------------------------------------------------------------------
+
+namespace circuits
+{
+  template <class T> class concurrent_library
+  {
+  private:
+    struct table
+    {
+      // Slots below a published size are never changed:
+      std::vector<std::shared_ptr<const T>> items;
+
+      table(const size_t &capacity) : items(capacity) {}
+    };
+
+    struct version
+    {
+      size_t size;
+      std::shared_ptr<table> items_table;
+    };
+
+    std::atomic<const version*> current;
+
+    // Readers registered in even / odd epochs (separate cache lines):
+    struct alignas(64) reader_count
+    {
+      std::atomic<size_t> count{0};
+    };
+    mutable reader_count readers[2];
+    std::atomic<size_t> epoch{0};
+
+    // Writer only state:
+    std::mutex write_mutex;
+    std::vector<const version*> retired_now;
+    std::vector<const version*> retired_before;
+
+    // Returns the reader count used (lock free, retries only on an epoch flip):
+    size_t enter() const
+    {
+      while (true) {
+        size_t e = epoch.load();
+        readers[e & 1].count.fetch_add(1);
+
+        if (epoch.load() == e) {
+          return e & 1;
+        }
+        readers[e & 1].count.fetch_sub(1);
+      }
+    }
+
+    void leave(const size_t &parity) const
+    {
+      readers[parity].count.fetch_sub(1);
+    }
+
+    // Frees versions no reader can still see (called with write_mutex held):
+    void reclaim()
+    {
+      size_t e = epoch.load();
+
+      // Everyone from the previous epoch has gone, so anything retired before
+      // the last flip is unreachable:
+      if (readers[(e + 1) & 1].count.load() == 0) {
+        for (auto old : retired_before) {
+          delete old;
+        }
+        retired_before.swap(retired_now);
+        retired_now.clear();
+        epoch.store(e + 1);
+      }
+    }
+
+    void publish(const version *next)
+    {
+      retired_now.push_back(current.exchange(next));
+      reclaim();
+    }
+
+    void check_index(const size_t &index, const size_t &size) const
+    {
+      if (index >= size) {
+        throw std::out_of_range("Library index " + std::to_string(index + 1)
+        + " doesn't exist (library has " + std::to_string(size) + ").");
+      }
+    }
+
+    // Copies the table with one item swapped (called with write_mutex held):
+    void replace_item(const size_t &index, std::shared_ptr<const T> item)
+    {
+      const version *old = current.load();
+
+      auto copy = std::make_shared<table>(old->items_table->items.size());
+      std::copy(old->items_table->items.begin(),
+        old->items_table->items.begin() + old->size, copy->items.begin());
+
+      copy->items[index] = std::move(item);
+      publish(new version{old->size, copy});
+    }
+
+  public:
+//------------------------------------------------------------------------------
+// Snapshots (consistent read only view, valid while the object lives):
+//------------------------------------------------------------------------------
+
+    class snapshot
+    {
+    private:
+      const concurrent_library *library = nullptr;
+      const version *contents = nullptr;
+      size_t parity = 0;
+
+      friend class concurrent_library;
+
+      snapshot(const concurrent_library *lib) : library{lib}
+      {
+        parity = library->enter();
+        contents = library->current.load();
+      }
+
+    public:
+      ~snapshot()
+      {
+        if (library != nullptr) {
+          library->leave(parity);
+        }
+      }
+
+      snapshot(snapshot &&other) noexcept
+        : library{other.library}, contents{other.contents},
+          parity{other.parity}
+      {
+        other.library = nullptr;
+      }
+
+      snapshot(const snapshot &) = delete;
+      snapshot &operator=(const snapshot &) = delete;
+      snapshot &operator=(snapshot &&) = delete;
+
+      size_t size() const
+      {
+        return contents->size;
+      }
+
+      // Only valid while the snapshot lives:
+      const T &operator[](const size_t &index) const
+      {
+        return *contents->items_table->items[index];
+      }
+
+      // Owning pointer, for keeping an item after the snapshot has gone:
+      std::shared_ptr<const T> get(const size_t &index) const
+      {
+        library->check_index(index, contents->size);
+        return contents->items_table->items[index];
+      }
+    };
+
+//------------------------------------------------------------------------------
+
+    concurrent_library()
+    {
+      current.store(new version{0, std::make_shared<table>(0)});
+    }
+
+    // No readers may be left when the library is destroyed:
+    ~concurrent_library()
+    {
+      delete current.load();
+      for (auto old : retired_now) {
+        delete old;
+      }
+      for (auto old : retired_before) {
+        delete old;
+      }
+    }
+
+    concurrent_library(const concurrent_library &) = delete;
+    concurrent_library &operator=(const concurrent_library &) = delete;
+
+    // Readers never block (even behind writers):
+    snapshot get_snapshot() const
+    {
+      return snapshot{this};
+    }
+
+    size_t size() const
+    {
+      return get_snapshot().size();
+    }
+
+    std::shared_ptr<const T> get(const size_t &index) const
+    {
+      return get_snapshot().get(index);
+    }
+
+//------------------------------------------------------------------------------
+// Writers:
+//------------------------------------------------------------------------------
+
+    // Appends an item, returning its index (amortised O(1)):
+    size_t add(std::shared_ptr<const T> item)
+    {
+      std::lock_guard<std::mutex> lock{write_mutex};
+
+      const version *old = current.load();
+      std::shared_ptr<table> items_table = old->items_table;
+
+      // Unused slots are invisible to readers, so can be filled in place:
+      if (old->size == items_table->items.size()) {
+        auto bigger = std::make_shared<table>(
+          std::max<size_t>(8, 2 * old->size));
+
+        std::copy(items_table->items.begin(),
+          items_table->items.begin() + old->size, bigger->items.begin());
+        items_table = bigger;
+      }
+
+      size_t index = old->size;
+      items_table->items[index] = std::move(item);
+      publish(new version{index + 1, items_table});
+
+      return index;
+    }
+
+    // Swaps an item for a new one (copies the table, O(size)):
+    void replace(const size_t &index, std::shared_ptr<const T> item)
+    {
+      std::lock_guard<std::mutex> lock{write_mutex};
+
+      check_index(index, current.load()->size);
+      replace_item(index, std::move(item));
+    }
+
+    // Edits a copy of an item then publishes it (readers keep the old one):
+    // (T needs clone(), as components do - nothing changes if edit throws)
+    template <class F> void update(const size_t &index, F edit)
+    {
+      std::lock_guard<std::mutex> lock{write_mutex};
+
+      const version *old = current.load();
+      check_index(index, old->size);
+
+      const T &item = *old->items_table->items[index];
+      std::shared_ptr<T> copy{static_cast<T*>(item.clone().release())};
+      edit(*copy);
+
+      replace_item(index, std::move(copy));
+    }
+
+    void clear()
+    {
+      std::lock_guard<std::mutex> lock{write_mutex};
+      publish(new version{0, std::make_shared<table>(0)});
+    }
+  };
+}
+
+//------------------------------------------------------------------------------
+#endif
+//------------------------------------------------------------------------------
@@ -10,14 +10,22 @@
 #include "resistors.hpp"
 #include "capacitors.hpp"
 #include "inductors.hpp"
+#include "library.hpp"
+#include "netlist.hpp"
+#include "server.hpp"
+#include "streaming.hpp"
+
+#include <csignal>
+#include <fstream>
 
 //------------------------------------------------------------------------------
 // Set up libraries:
 //------------------------------------------------------------------------------
 
 // To store components / circuits made by the user:
-static std::vector<std::shared_ptr<component>> components_library;
-static std::vector<std::unique_ptr<circuit>> circuits_library;
+// (safe to read from other threads while being edited, see library.hpp)
+static concurrent_library<component> components_library;
+static concurrent_library<circuit> circuits_library;
 
 //------------------------------------------------------------------------------
 // Useful functions:
@@ -145,7 +153,7 @@ void add_valid_component(const std::string &type)
       if (type == "resistor") {
         res = valid_input<double>("Please input the resistance in Ohms: ");
 
-        components_library.push_back(
+        components_library.add(
           std::make_shared<resistor>(resistor{res}) );
         is_valid = true;
       }
@@ -153,7 +161,7 @@ void add_valid_component(const std::string &type)
       else if (type == "inductor"){
         ind = valid_input<double>("Please input the inductance in Henrys: ");
 
-        components_library.push_back(
+        components_library.add(
           std::make_shared<inductor>(inductor{ind}) );
         is_valid = true;
       }
@@ -161,7 +169,7 @@ void add_valid_component(const std::string &type)
       else if (type == "capacitor"){
         cap = valid_input<double>("Please input the capacitance in Farads: ");
 
-        components_library.push_back(
+        components_library.add(
           std::make_shared<capacitor>(capacitor{cap}) );
         is_valid = true;
       }
@@ -173,7 +181,7 @@ void add_valid_component(const std::string &type)
         cap = valid_input<double>(
           "Please input the non-ideal capacitance in Farads: ");
 
-        components_library.push_back(
+        components_library.add(
           std::make_shared<real_resistor>(real_resistor{res, ind, cap}) );
         is_valid = true;
       }
@@ -185,7 +193,7 @@ void add_valid_component(const std::string &type)
         res = valid_input<double>(
           "Please input the non-ideal resistance in Ohms: ");
 
-        components_library.push_back(
+        components_library.add(
           std::make_shared<real_inductor>(real_inductor{res, ind, cap}) );
         is_valid = true;
       }
@@ -197,7 +205,7 @@ void add_valid_component(const std::string &type)
         ind = valid_input<double>(
           "Please input the non-ideal inductance in Henrys: ");
 
-        components_library.push_back(
+        components_library.add(
           std::make_shared<real_capacitor>(real_capacitor{res, ind, cap}) );
         is_valid = true;
 
@@ -300,12 +308,13 @@ void create_circuit()
     << "Please choose one of the options below:" << std::endl
     << std::endl
     << "[1] - Create new circuit" << std::endl
-    << "[2] - Return to main menu" << std::endl
+    << "[2] - Import circuit from SPICE netlist" << std::endl
+    << "[3] - Return to main menu" << std::endl
     << std::endl
     << "----------------------------------------------------------" << std::endl
     << std::endl;
 
-    int choice = valid_int_range(1, 2);
+    int choice = valid_int_range(1, 3);
     switch (choice) {
 
       case 1: {
@@ -318,8 +327,8 @@ void create_circuit()
             double circuit_volt = valid_input<double>(
               "Now enter the voltage of the circuit (V): ");
 
-            circuits_library.push_back(
-              std::make_unique<circuit>(circuit{circuit_freq, circuit_volt}) );
+            circuits_library.add(
+              std::make_shared<circuit>(circuit{circuit_freq, circuit_volt}) );
 
             std::cout << "Circuit created." << std::endl;
             is_valid = true;
@@ -337,6 +346,35 @@ void create_circuit()
 //------------------------------------------------------------------------------
 
       case 2: {
+        try {
+          netlist_options options;
+          options.frequency = valid_input<double>(
+            "Enter the frequency of the circuit (Hz): ");
+
+          std::string filename = valid_input<std::string>(
+            "Enter the netlist file name: ");
+
+          // Impedance is taken across the deck's first source:
+          size_t index = circuits_library.add(
+            import_netlist(filename, options) );
+
+          std::cout << "Circuit imported with "
+          << static_cast<size_t>(circuits_library.get(index)->get_size())
+          << " components."
+          << std::endl;
+        }
+        // File, parse and component range errors (in netlist.cpp):
+        catch (const std::exception& e) {
+          std::cout <<  std::endl;
+          std::cerr << "Netlist error: " << std::endl
+          << e.what() << std::endl;
+        }
+        break;
+      }
+
+//------------------------------------------------------------------------------
+
+      case 3: {
         // Breaks while loop:
         add_circuit = false;
         break;
@@ -368,15 +406,18 @@ void components_info(const bool &print_title)
       << "----------------------------------------------------------" << std::endl;
     }
 
+    // Consistent view, even if components are added meanwhile:
+    auto components = components_library.get_snapshot();
+
     std::cout << std::endl
-    << "You've created " << components_library.size()
+    << "You've created " << components.size()
     << " components." << std::endl
     << "Here are ALL the existing components data:" << std::endl;
     std::cout << std::endl;
 
-    for (int i{}; i < components_library.size(); ++i) {
+    for (int i{}; i < components.size(); ++i) {
       std::cout << "Component " << (i + 1) << " - ";
-      components_library[i]->print_info();
+      components[i].print_info();
     }
   }
 
@@ -433,11 +474,14 @@ void change_component()
 
             try {
               std::string prompt = "Please enter the new value for the "
-              + components_library[comp_choice]->get_type() + ": ";
+              + components_library.get(comp_choice)->get_type() + ": ";
 
               double new_value = valid_input<double>(prompt);
 
-              components_library[comp_choice]->set_value(new_value);
+              // Edits a copy, so readers of the old one aren't affected:
+              components_library.update(comp_choice, [&](component &comp) {
+                comp.set_value(new_value);
+              });
 
               std::cout << std::endl;
               std::cout << "Component data modified." << std::endl;
@@ -518,10 +562,15 @@ void change_circuit()
             // To get correct vector index again (starts from 0):
             --circ_choice;
 
+            // All the additions go into a working copy in one transaction,
+            // so it's recalculated and published once:
+            circuit working{*circuits_library.get(circ_choice)};
+            circuit::transaction edits{working};
+
             // Overrides choice to ensure first component cannot be nested:
             bool first_comp = false;
 
-            if (circuits_library[circ_choice]->get_size() == 0) {
+            if (working.get_size() == 0) {
               std::cout << std::endl
               << "This circuit has no components yet!"<< std::endl;
               //std::cout << "The first component cannot be nested.";
@@ -554,9 +603,10 @@ void change_circuit()
                 }
 
                 // Prevents first component from being nested:
+                auto comp = components_library.get(comp_choice);
+
                 if (first_comp == true) {
-                  circuits_library[circ_choice]->add_component(
-                    components_library[comp_choice], conn_choice, false);
+                  working.add_component(comp, conn_choice, false);
                   first_comp = false;
 
                 } else {
@@ -565,8 +615,7 @@ void change_circuit()
                   // Functionality all possible, but unable to calc impedance:
                   //bool nest_choice = yes_or_no("Is this a nested component?");
 
-                  circuits_library[circ_choice]->add_component(
-                    components_library[comp_choice], conn_choice, nest_choice);
+                  working.add_component(comp, conn_choice, nest_choice);
                 }
 
                 std::cout << std::endl
@@ -582,6 +631,10 @@ void change_circuit()
                 << ia.what() << std::endl;
               }
             }
+
+            edits.commit();
+            circuits_library.replace(circ_choice,
+              std::make_shared<circuit>(std::move(working)));
           }
           break;
         }
@@ -598,32 +651,35 @@ void change_circuit()
           // To get correct vector index again (starts from 0):
           --circ_choice;
 
-          if (circuits_library[circ_choice]->get_size() == 0) {
+          if (circuits_library.get(circ_choice)->get_size() == 0) {
             std::cout << std::endl
             << "This circuit has no components yet!"<< std::endl
             << "Please add components first." << std::endl;
 
           } else {
 
+            // As for adding, one transaction on a working copy:
+            circuit working{*circuits_library.get(circ_choice)};
+            circuit::transaction edits{working};
+
             bool comps_remove = true;
             while (comps_remove) {
 
-              circuits_library[circ_choice]->print_components();
+              working.print_components();
 
               std::cout << std::endl
               << "Choose the component you want to remove." << std::endl;
-              int comp_choice = valid_int_range(
-                1, circuits_library[circ_choice]->get_size() );
+              int comp_choice = valid_int_range(1, working.get_size() );
 
               --comp_choice;
 
-              circuits_library[circ_choice]->remove_component(comp_choice);
+              working.remove_component(comp_choice);
 
               std::cout << std::endl;
               std::cout << "Component removed." << std::endl;
 
               // For cases where all components have been removed:
-              if (circuits_library[circ_choice]->get_size() == 0) {
+              if (working.get_size() == 0) {
                 std::cout << std::endl
                 << "This circuit is now empty." << std::endl
                 << "You cannot remove any more components from it." << std::endl;
@@ -635,6 +691,10 @@ void change_circuit()
                   "Do you want to remove another component from this circuit?");
               }
             }
+
+            edits.commit();
+            circuits_library.replace(circ_choice,
+              std::make_shared<circuit>(std::move(working)));
           }
           break;
         }
@@ -658,7 +718,9 @@ void change_circuit()
 
               double new_value = valid_input<double>(prompt);
 
-              circuits_library[circ_choice]->set_frequency(new_value);
+              circuits_library.update(circ_choice, [&](circuit &circ) {
+                circ.set_frequency(new_value);
+              });
 
               std::cout << std::endl;
               std::cout << "Frequency has been changed." << std::endl;
@@ -693,7 +755,9 @@ void change_circuit()
 
               double new_value = valid_input<double>(prompt);
 
-              circuits_library[circ_choice]->set_voltage(new_value);
+              circuits_library.update(circ_choice, [&](circuit &circ) {
+                circ.set_voltage(new_value);
+              });
 
               std::cout << std::endl;
               std::cout << "Voltage has been changed." << std::endl;
@@ -748,12 +812,13 @@ void circuits_info()
       << "[1] - View circuit information (e.g. total impedance)" << std::endl
       << "[2] - View list of components in a circuit" << std::endl
       << "[3] - View circuit diagram" << std::endl
-      << "[4] - Return to main menu" << std::endl
+      << "[4] - Export frequency sweep to CSV" << std::endl
+      << "[5] - Return to main menu" << std::endl
       << std::endl
       << "----------------------------------------------------------" << std::endl
       << std::endl;
 
-      int choice = valid_int_range(1, 4);
+      int choice = valid_int_range(1, 5);
       switch (choice) {
 
         case 1: {
@@ -766,7 +831,7 @@ void circuits_info()
             // To get correct vector index again (starts from 0):
             --circ_choice;
 
-            circuits_library[circ_choice]->print_info();
+            circuits_library.get(circ_choice)->print_info();
 
             if (circuits_library.size() == 1) {
               view_info = false;
@@ -792,13 +857,13 @@ void circuits_info()
             // To get correct vector index again (starts from 0):
             --circ_choice;
 
-            if (circuits_library[circ_choice]->get_size() == 0) {
+            if (circuits_library.get(circ_choice)->get_size() == 0) {
             std::cout << std::endl
             << "This circuit has no components yet!"<< std::endl
             << "Please add components first." << std::endl;
 
             } else {
-              circuits_library[circ_choice]->print_components();
+              circuits_library.get(circ_choice)->print_components();
             }
 
             if (circuits_library.size() == 1) {
@@ -826,13 +891,13 @@ void circuits_info()
             // To get correct vector index again (starts from 0):
             --circ_choice;
 
-            if (circuits_library[circ_choice]->get_size() == 0) {
+            if (circuits_library.get(circ_choice)->get_size() == 0) {
             std::cout << std::endl
             << "This circuit has no components yet!"<< std::endl
             << "Please add components first." << std::endl;
 
             } else {
-              circuits_library[circ_choice]->print_diagram();
+              circuits_library.get(circ_choice)->print_diagram();
             }
 
             if (circuits_library.size() == 1) {
@@ -850,6 +915,49 @@ void circuits_info()
 //------------------------------------------------------------------------------
 
         case 4: {
+          std::cout << std::endl
+          << "Which circuit do you want to sweep?" << std::endl;
+          int circ_choice = valid_int_range(1, circuits_library.size() );
+
+          // To get correct vector index again (starts from 0):
+          --circ_choice;
+
+          try {
+            sweep_range range;
+            range.f_min = valid_input<double>(
+              "Enter the start frequency (Hz): ");
+            range.f_max = valid_input<double>(
+              "Enter the end frequency (Hz): ");
+            range.points = valid_input<size_t>(
+              "Enter the number of points (log spaced): ");
+
+            std::string filename = valid_input<std::string>(
+              "Enter the CSV file name: ");
+
+            std::ofstream file{filename};
+            if (!file) {
+              throw std::runtime_error("Could not open " + filename + ".");
+            }
+
+            // Streamed to the file, so any number of points fits in memory:
+            csv_sink sink{file};
+            stream_sweep(*circuits_library.get(circ_choice), range, sink);
+
+            std::cout << std::endl
+            << "Sweep written to " << filename << "." << std::endl;
+          }
+          // Range, file and evaluation errors (in streaming.cpp):
+          catch (const std::exception& e) {
+            std::cout << std::endl;
+            std::cerr << "Sweep error: " << std::endl
+            << e.what() << std::endl;
+          }
+          break;
+        }
+
+//------------------------------------------------------------------------------
+
+        case 5: {
           view_circuits = false;
           break;
         }
@@ -924,12 +1032,61 @@ bool quit_program()
   }
 }
 
+//------------------------------------------------------------------------------
+// Server mode:
+//------------------------------------------------------------------------------
+
+// Set by Ctrl+C / SIGTERM:
+static volatile std::sig_atomic_t stop_requested = 0;
+
+void request_stop(int)
+{
+  stop_requested = 1;
+}
+
+// Runs the evaluation server until interrupted (protocol in server.hpp):
+int run_server(const std::string &socket_path)
+{
+  std::signal(SIGINT, request_stop);
+  std::signal(SIGTERM, request_stop);
+
+  try {
+    server_options options;
+    options.socket_path = socket_path;
+
+    evaluation_server server{options};
+    server.start();
+
+    std::cout << "Listening on " << socket_path << " (Ctrl+C to stop)."
+    << std::endl;
+
+    while (!stop_requested) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    server.stop();
+  }
+  catch (const std::exception& e) {
+    std::cerr << "Server error: " << std::endl
+    << e.what() << std::endl;
+    return 1;
+  }
+
+  std::cout << "Server stopped." << std::endl;
+  return 0;
+}
+
 //------------------------------------------------------------------------------
 // Main - contains main menu interface:
 //------------------------------------------------------------------------------
 
-int main()
+int main(int argc, char *argv[])
 {
+  // Server mode, e.g. ./ac_circuits --serve /tmp/ac_circuits.sock:
+  if (argc > 1 && std::string{argv[1]} == "--serve") {
+    return run_server((argc > 2) ? argv[2] : server_options{}.socket_path);
+  }
+
   bool run_program = true;
   while (run_program) {
 
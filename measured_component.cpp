@@ -0,0 +1,462 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Measured (table driven) component, e.g. from VNA data:
+//------------------------------------------------------------------------------
+
+#include "measured_component.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <mutex>
+
+//------------------------------------------------------------------------------
+// Impedance Table Class:
+//------------------------------------------------------------------------------
+
+namespace
+{
+  // Relative spacing error allowed when checking for a uniform grid:
+  const double uniform_tolerance = 1e-6;
+
+  bool is_evenly_spaced(const std::vector<double> &x)
+  {
+    double step = (x.back() - x.front()) / (x.size() - 1);
+
+    for (size_t i{1}; i < x.size(); ++i) {
+      if (std::abs((x[i] - x[i - 1]) - step) > (uniform_tolerance * step)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+}
+
+//------------------------------------------------------------------------------
+
+// Parameterised constructor:
+circuits::impedance_table::impedance_table(const std::vector<double> &freqs,
+  const std::vector<std::complex<double>> &z_values)
+{
+  if (freqs.size() != z_values.size()) {
+    throw std::invalid_argument{"Need one impedance for each frequency."};
+  }
+
+  if (freqs.size() < 2) {
+    throw std::invalid_argument{"Impedance table needs at least 2 points."};
+  }
+
+  if (freqs.front() < 0.0) {
+    throw std::out_of_range{"Cannot have negative frequency."};
+  }
+
+  for (size_t i{1}; i < freqs.size(); ++i) {
+    if (freqs[i] <= freqs[i - 1]) {
+      throw std::invalid_argument{"Table frequencies must be increasing."};
+    }
+  }
+
+  impedances = z_values;
+  f_min = freqs.front();
+  f_max = freqs.back();
+  size_t n = freqs.size();
+
+  // Log sweeps are splined (and indexed) in ln f, anything else in f:
+  log_axis = false;
+  if (freqs.front() > 0.0) {
+    axis.resize(n);
+    for (size_t i{}; i < n; ++i) {
+      axis[i] = std::log(freqs[i]);
+    }
+    log_axis = is_evenly_spaced(axis);
+  }
+
+  if (!log_axis) {
+    axis = freqs;
+  }
+
+  uniform = log_axis || is_evenly_spaced(axis);
+  axis_step = (axis.back() - axis.front()) / (n - 1);
+
+  // Natural spline, tridiagonal system for the inner curvatures:
+  curvatures.assign(n, std::complex<double>{});
+  if (n < 3) {
+    return;
+  }
+
+  std::vector<double> diagonal(n);
+  std::vector<std::complex<double>> rhs(n);
+
+  for (size_t i{1}; i < n - 1; ++i) {
+    double h_lo = axis[i] - axis[i - 1];
+    double h_hi = axis[i + 1] - axis[i];
+
+    diagonal[i] = 2 * (h_lo + h_hi);
+    rhs[i] = 6.0 * (((impedances[i + 1] - impedances[i]) / h_hi)
+      - ((impedances[i] - impedances[i - 1]) / h_lo));
+  }
+
+  // Forward elimination (Thomas algorithm):
+  for (size_t i{2}; i < n - 1; ++i) {
+    double h_lo = axis[i] - axis[i - 1];
+    double factor = h_lo / diagonal[i - 1];
+
+    diagonal[i] -= factor * h_lo;
+    rhs[i] -= factor * rhs[i - 1];
+  }
+
+  // Back substitution:
+  for (size_t i{n - 2}; i >= 1; --i) {
+    double h_hi = axis[i + 1] - axis[i];
+    curvatures[i] = (rhs[i] - (h_hi * curvatures[i + 1])) / diagonal[i];
+  }
+}
+
+//------------------------------------------------------------------------------
+
+double circuits::impedance_table::to_axis(const double &freq) const
+{
+  if (!log_axis) {
+    return freq;
+  }
+
+  // Below the table anyway, so any value under axis.front() works:
+  return (freq > 0.0) ? std::log(freq) : (axis.front() - 1.0);
+}
+
+//------------------------------------------------------------------------------
+
+size_t circuits::impedance_table::find_interval(
+  const double &x, size_t hint) const
+{
+  size_t last_interval = axis.size() - 2;
+
+  if (uniform) {
+    double u = (x - axis.front()) / axis_step;
+    if (u <= 0.0) {
+      return 0;
+    }
+
+    return std::min(static_cast<size_t>(u), last_interval);
+  }
+
+  // Sweeps usually move to the same or the next interval:
+  if (hint <= last_interval && axis[hint] <= x) {
+    for (size_t i{hint}; i <= std::min(hint + 2, last_interval); ++i) {
+      if (x < axis[i + 1]) {
+        return i;
+      }
+    }
+  }
+
+  auto upper = std::upper_bound(axis.begin() + 1, axis.end() - 1, x);
+  return static_cast<size_t>(upper - axis.begin()) - 1;
+}
+
+//------------------------------------------------------------------------------
+
+void circuits::impedance_table::evaluate_interval(const size_t &i,
+  const double &x, std::complex<double> &z, std::complex<double> &dz_dx) const
+{
+  // Hold the end values outside of the table:
+  if (x <= axis.front() || x >= axis.back()) {
+    z = (x <= axis.front()) ? impedances.front() : impedances.back();
+    dz_dx = 0;
+    return;
+  }
+
+  double h = axis[i + 1] - axis[i];
+  double a = axis[i + 1] - x;
+  double b = x - axis[i];
+
+  std::complex<double> c_lo = (impedances[i] / h) - (curvatures[i] * h / 6.0);
+  std::complex<double> c_hi
+    = (impedances[i + 1] / h) - (curvatures[i + 1] * h / 6.0);
+
+  z = (curvatures[i] * a * a * a / (6 * h))
+    + (curvatures[i + 1] * b * b * b / (6 * h)) + (c_lo * a) + (c_hi * b);
+
+  dz_dx = (curvatures[i + 1] * b * b / (2 * h))
+    - (curvatures[i] * a * a / (2 * h)) + c_hi - c_lo;
+}
+
+//------------------------------------------------------------------------------
+
+size_t circuits::impedance_table::get_size() const
+{
+  return impedances.size();
+}
+
+double circuits::impedance_table::get_min_frequency() const
+{
+  return f_min;
+}
+
+double circuits::impedance_table::get_max_frequency() const
+{
+  return f_max;
+}
+
+bool circuits::impedance_table::is_uniform() const
+{
+  return uniform;
+}
+
+//------------------------------------------------------------------------------
+
+std::complex<double> circuits::impedance_table::evaluate(
+  const double &freq) const
+{
+  double x = to_axis(freq);
+  std::complex<double> z, slope;
+
+  evaluate_interval(find_interval(x), x, z, slope);
+  return z;
+}
+
+// dZ/df = dZ/dx, or dZ/d(ln f) / f on a log axis:
+std::complex<double> circuits::impedance_table::evaluate_derivative(
+  const double &freq) const
+{
+  double x = to_axis(freq);
+  std::complex<double> z, slope;
+
+  evaluate_interval(find_interval(x), x, z, slope);
+  return log_axis ? (slope / freq) : slope;
+}
+
+//------------------------------------------------------------------------------
+
+std::vector<std::complex<double>> circuits::impedance_table::evaluate(
+  const std::vector<double> &freqs) const
+{
+  std::vector<std::complex<double>> results(freqs.size());
+  std::complex<double> slope;
+  size_t interval{};
+
+  for (size_t i{}; i < freqs.size(); ++i) {
+    double x = to_axis(freqs[i]);
+
+    interval = find_interval(x, interval);
+    evaluate_interval(interval, x, results[i], slope);
+  }
+
+  return results;
+}
+
+//------------------------------------------------------------------------------
+
+std::shared_ptr<const circuits::impedance_table>
+  circuits::load_impedance_table(const std::string &filename)
+{
+  // Tables stay loaded only while some component still uses them:
+  static std::map<std::string, std::weak_ptr<const impedance_table>> loaded;
+  static std::mutex loaded_mutex;
+
+  std::lock_guard<std::mutex> lock{loaded_mutex};
+
+  auto existing = loaded.find(filename);
+  if (existing != loaded.end()) {
+    if (auto table = existing->second.lock()) {
+      return table;
+    }
+  }
+
+  std::ifstream file{filename};
+  if (!file) {
+    throw std::runtime_error{"Could not open impedance table " + filename};
+  }
+
+  std::vector<double> freqs;
+  std::vector<std::complex<double>> z_values;
+
+  std::string line;
+  size_t line_number{};
+
+  while (std::getline(file, line)) {
+    ++line_number;
+    std::replace(line.begin(), line.end(), ',', ' ');
+
+    std::istringstream fields{line};
+    std::string first;
+
+    // Blank and comment lines:
+    if (!(fields >> first) || first[0] == '#' || first[0] == '!') {
+      continue;
+    }
+
+    double freq{}, re{}, im{};
+    fields.clear();
+    fields.str(line);
+
+    if (!(fields >> freq >> re >> im)) {
+      throw std::invalid_argument{"Bad impedance table line "
+        + std::to_string(line_number) + " in " + filename};
+    }
+
+    freqs.push_back(freq);
+    z_values.emplace_back(re, im);
+  }
+
+  auto table = std::make_shared<const impedance_table>(freqs, z_values);
+  loaded[filename] = table;
+
+  return table;
+}
+
+//------------------------------------------------------------------------------
+// Measured Component Class:
+//------------------------------------------------------------------------------
+
+// For cloning unique_ptr of component:
+std::unique_ptr<component> measured_component::clone() const
+{
+  return std::make_unique<measured_component>(*this);
+}
+
+// Default constructor (short circuit from 0 Hz to 1 Hz):
+measured_component::measured_component()
+{
+  kind = component_kind::measured;
+  frequency = 0;
+  source = "none";
+  table = std::make_shared<const circuits::impedance_table>(
+    std::vector<double>{0.0, 1.0}, std::vector<std::complex<double>>(2));
+  set_impedance();
+}
+
+//------------------------------------------------------------------------------
+
+// Parameterised constructors:
+measured_component::measured_component(
+  const std::shared_ptr<const circuits::impedance_table> &data,
+  const std::string &data_source)
+{
+  if (!data) {
+    throw std::invalid_argument{"Measured component needs a table."};
+  }
+
+  kind = component_kind::measured;
+  table = data;
+  source = data_source;
+  frequency = table->get_min_frequency();
+  set_impedance();
+}
+
+measured_component::measured_component(const std::string &filename)
+  : measured_component{circuits::load_impedance_table(filename), filename}
+{}
+
+//------------------------------------------------------------------------------
+
+// Copy constructor:
+measured_component::measured_component(const measured_component &measured)
+{
+  kind = measured.kind;
+  impedance = measured.impedance;
+  frequency = measured.frequency;
+  table = measured.table;
+  source = measured.source;
+}
+
+//------------------------------------------------------------------------------
+
+// Move constructor:
+measured_component::measured_component(measured_component &&measured)
+{
+  // Steal the data:
+  kind = measured.kind;
+  impedance = measured.impedance;
+  frequency = measured.frequency;
+  table = std::move(measured.table);
+  source = std::move(measured.source);
+
+  // Empty 'old' measured_component data:
+  measured.kind = component_kind::empty;
+  measured.impedance = 0;
+  measured.frequency = 0;
+}
+
+//------------------------------------------------------------------------------
+
+// Destructor:
+measured_component::~measured_component() {}
+
+//------------------------------------------------------------------------------
+// Access Functions:
+//------------------------------------------------------------------------------
+
+std::complex<double> measured_component::evaluate(const double &freq) const
+{
+  if (freq < 0.0) {
+    throw std::out_of_range{"Cannot have negative frequency."};
+  }
+
+  return table->evaluate(freq);
+}
+
+void measured_component::set_impedance()
+{
+  impedance = evaluate(frequency);
+}
+
+//------------------------------------------------------------------------------
+
+void measured_component::set_value(const double &freq)
+{
+  set_frequency(freq);
+}
+
+double measured_component::get_value() const
+{
+  return frequency;
+}
+
+void measured_component::set_frequency(const double &freq)
+{
+  if (freq < 0.0) {
+    throw std::out_of_range{"Cannot have negative frequency."};
+  }
+
+  frequency = freq;
+  set_impedance();
+}
+
+double measured_component::get_frequency() const
+{
+  return frequency;
+}
+
+std::complex<double> measured_component::get_impedance_derivative() const
+{
+  return table->evaluate_derivative(frequency);
+}
+
+const std::shared_ptr<const circuits::impedance_table> &
+  measured_component::get_table() const
+{
+  return table;
+}
+
+//------------------------------------------------------------------------------
+
+void measured_component::write_info(circuits::report_writer &out) const
+{
+  out << "Measured component:" << '\n'
+  << "    Data from " << source << " (" << table->get_size()
+  << " points)," << '\n';
+
+  double f_min = table->get_min_frequency();
+  double f_max = table->get_max_frequency();
+
+  out << "    Measured from " << f_min << " Hz";
+
+  out << " to " << f_max << " Hz." << '\n';
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,129 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Measured (table driven) component, e.g. from VNA data:
+//------------------------------------------------------------------------------
+
+#ifndef measured_component_hpp
+#define measured_component_hpp
+
+#include "base_component.hpp"
+
+//------------------------------------------------------------------------------
+
+namespace circuits
+{
+  // Measured (f, Z) points with a natural cubic spline through Re and Im:
+  // (tables are immutable once built, so components can share them)
+  class impedance_table
+  {
+  private:
+    // Spline axis, ln f for log spaced data and f otherwise:
+    std::vector<double> axis;
+    std::vector<std::complex<double>> impedances;
+
+    // Spline second derivatives (d^2 Z / d axis^2) at each point:
+    std::vector<std::complex<double>> curvatures;
+
+    bool log_axis;
+    double f_min;
+    double f_max;
+
+    // Uniformly spaced axis allows direct indexing instead of searching:
+    bool uniform;
+    double axis_step;
+
+    double to_axis(const double &freq) const;
+
+    // Interval containing x (starting the search at hint if given):
+    size_t find_interval(const double &x, size_t hint = 0) const;
+
+    void evaluate_interval(const size_t &i, const double &x,
+      std::complex<double> &z, std::complex<double> &dz_dx) const;
+
+  public:
+    // Parameterised constructor (frequencies must be increasing):
+    impedance_table(const std::vector<double> &freqs,
+      const std::vector<std::complex<double>> &z_values);
+
+    size_t get_size() const;
+    double get_min_frequency() const;
+    double get_max_frequency() const;
+    bool is_uniform() const;
+
+    // Impedance at a frequency (end values are held outside the table):
+    std::complex<double> evaluate(const double &freq) const;
+
+    // dZ/df at a frequency (zero outside the table):
+    std::complex<double> evaluate_derivative(const double &freq) const;
+
+    // Sweep lookup, ascending sweeps walk the table instead of searching:
+    std::vector<std::complex<double>> evaluate(
+      const std::vector<double> &freqs) const;
+  };
+
+  // Reads "f re(Z) im(Z)" lines (space or comma separated, '#' and '!'
+  // comment lines skipped), loading each file only once while in use:
+  std::shared_ptr<const impedance_table> load_impedance_table(
+    const std::string &filename);
+}
+
+//------------------------------------------------------------------------------
+// Measured Component Class:
+//------------------------------------------------------------------------------
+
+class measured_component : public component
+{
+private:
+  std::shared_ptr<const circuits::impedance_table> table;
+
+  // Where the data came from, for information only:
+  std::string source;
+
+public:
+  // For cloning unique_ptr of measured component:
+  std::unique_ptr<component> clone() const;
+
+  // Default constructor:
+  measured_component();
+
+  // Parameterised constructors:
+  measured_component(
+    const std::shared_ptr<const circuits::impedance_table> &data,
+    const std::string &data_source = "table");
+  measured_component(const std::string &filename);
+
+  // Copy constructor (shares the table):
+  measured_component(const measured_component &measured);
+
+  // Move constructor (note double &&):
+  measured_component(measured_component &&measured);
+
+  // Destructor:
+  ~measured_component();
+
+//------------------------------------------------------------------------------
+
+  std::complex<double> evaluate(const double &freq) const;
+  void set_impedance();
+
+  // Value of a measured component is its frequency (like circuit):
+  void set_value(const double &freq);
+  double get_value() const;
+
+  void set_frequency(const double &freq);
+  double get_frequency() const;
+
+  std::complex<double> get_impedance_derivative() const;
+
+  const std::shared_ptr<const circuits::impedance_table> &get_table() const;
+
+  void write_info(circuits::report_writer &out) const;
+};
+
+//------------------------------------------------------------------------------
+#endif
+//------------------------------------------------------------------------------
@@ -0,0 +1,1266 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// SPICE netlist importer (R / L / C elements, .subckt and X instances):
+//------------------------------------------------------------------------------
+
+#include "netlist.hpp"
+#include "resistors.hpp"
+#include "capacitors.hpp"
+#include "inductors.hpp"
+
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//------------------------------------------------------------------------------
+// Helper functions (only used in this file):
+//------------------------------------------------------------------------------
+
+namespace
+{
+  using namespace circuits;
+
+  // SPICE names are case insensitive:
+  char to_lower(const char &c)
+  {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+  }
+
+  bool equals_ignore_case(std::string_view a, std::string_view b)
+  {
+    if (a.size() != b.size()) {
+      return false;
+    }
+
+    for (size_t i{}; i < a.size(); ++i) {
+      if (to_lower(a[i]) != to_lower(b[i])) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  bool starts_with_ignore_case(std::string_view text, std::string_view prefix)
+  {
+    return text.size() >= prefix.size()
+      && equals_ignore_case(text.substr(0, prefix.size()), prefix);
+  }
+
+  // FNV-1a of the lower case name:
+  struct ignore_case_hash
+  {
+    size_t operator()(std::string_view name) const
+    {
+      size_t hash = 14695981039346656037ull;
+      for (const auto &c : name) {
+        hash = (hash ^ static_cast<unsigned char>(to_lower(c)))
+          * 1099511628211ull;
+      }
+      return hash;
+    }
+  };
+
+  struct ignore_case_equal
+  {
+    bool operator()(std::string_view a, std::string_view b) const
+    {
+      return equals_ignore_case(a, b);
+    }
+  };
+
+  // Keys are views into the netlist text, so nothing is copied:
+  template <class T> using name_map = std::unordered_map<
+    std::string_view, T, ignore_case_hash, ignore_case_equal>;
+
+  std::invalid_argument line_error(
+    const size_t &line, const std::string &message)
+  {
+    return std::invalid_argument{
+      "Netlist line " + std::to_string(line) + ": " + message};
+  }
+
+//------------------------------------------------------------------------------
+
+  // Read only memory map of a whole file (unmapped on destruction):
+  class mapped_file
+  {
+  private:
+    int descriptor = -1;
+    void *data = nullptr;
+    size_t size = 0;
+
+  public:
+    mapped_file(const std::string &filename)
+    {
+      descriptor = ::open(filename.c_str(), O_RDONLY);
+      if (descriptor < 0) {
+        throw std::runtime_error{"Could not open netlist " + filename};
+      }
+
+      struct stat info{};
+      if (::fstat(descriptor, &info) != 0) {
+        ::close(descriptor);
+        throw std::runtime_error{"Could not read netlist " + filename};
+      }
+
+      size = static_cast<size_t>(info.st_size);
+
+      // Empty files can't be mapped (and have nothing to parse):
+      if (size == 0) {
+        return;
+      }
+
+      data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+      if (data == MAP_FAILED) {
+        ::close(descriptor);
+        throw std::runtime_error{"Could not map netlist " + filename};
+      }
+
+      ::madvise(data, size, MADV_SEQUENTIAL);
+    }
+
+    ~mapped_file()
+    {
+      if (data) {
+        ::munmap(data, size);
+      }
+      ::close(descriptor);
+    }
+
+    mapped_file(const mapped_file &) = delete;
+    mapped_file &operator=(const mapped_file &) = delete;
+
+    std::string_view get_text() const
+    {
+      return std::string_view{static_cast<const char *>(data), size};
+    }
+  };
+
+//------------------------------------------------------------------------------
+// Parsing:
+//------------------------------------------------------------------------------
+
+  bool is_separator(const char &c)
+  {
+    return c == ' ' || c == '\t' || c == '\r' || c == ',' || c == '('
+      || c == ')' || c == '=';
+  }
+
+  // Splits a line into tokens (views into the text, no copies):
+  // ("key=value" pairs become two tokens, ';' and '$' start comments)
+  void tokenize(std::string_view line, std::vector<std::string_view> &tokens)
+  {
+    size_t i{};
+    while (i < line.size()) {
+      if (is_separator(line[i])) {
+        ++i;
+        continue;
+      }
+
+      if (line[i] == ';' || line[i] == '$') {
+        return;
+      }
+
+      size_t start = i;
+      while (i < line.size() && !is_separator(line[i]) && line[i] != ';') {
+        ++i;
+      }
+
+      tokens.push_back(line.substr(start, i - start));
+    }
+  }
+
+//------------------------------------------------------------------------------
+
+  const size_t no_index = static_cast<size_t>(-1);
+
+  // Open addressing table numbering the node names of one definition:
+  // (names are views into the netlist text, so nothing is copied)
+  class node_table
+  {
+  private:
+    // Kept small (8 bytes) as big netlists make this table miss cache:
+    struct slot
+    {
+      uint32_t hash;
+      // Node number + 1, 0 for an empty slot:
+      uint32_t id;
+    };
+
+    std::vector<slot> slots;
+    std::vector<std::string_view> names;
+
+    void grow()
+    {
+      std::vector<slot> old_slots(slots.size() * 2);
+      std::swap(slots, old_slots);
+
+      size_t mask = slots.size() - 1;
+      for (const auto &old : old_slots) {
+        if (old.id != 0) {
+          size_t i = old.hash & mask;
+          while (slots[i].id != 0) {
+            i = (i + 1) & mask;
+          }
+          slots[i] = old;
+        }
+      }
+    }
+
+    size_t find_slot(std::string_view name, const uint32_t &hash) const
+    {
+      size_t mask = slots.size() - 1;
+      size_t i = hash & mask;
+
+      while (slots[i].id != 0) {
+        if (slots[i].hash == hash
+          && equals_ignore_case(names[slots[i].id - 1], name)) {
+          return i;
+        }
+        i = (i + 1) & mask;
+      }
+
+      return i;
+    }
+
+  public:
+    node_table() : slots(64) {}
+
+    // Number of the node, adding it if it is new:
+    size_t intern(std::string_view name)
+    {
+      // Keep the table at most half full:
+      if (2 * (names.size() + 1) > slots.size()) {
+        grow();
+      }
+
+      uint32_t hash = static_cast<uint32_t>(ignore_case_hash{}(name));
+      size_t i = find_slot(name, hash);
+
+      if (slots[i].id == 0) {
+        names.push_back(name);
+        slots[i] = slot{hash, static_cast<uint32_t>(names.size())};
+      }
+
+      return slots[i].id - 1;
+    }
+
+    // Number of the node, or no_index if there isn't one:
+    size_t find(std::string_view name) const
+    {
+      size_t i = find_slot(
+        name, static_cast<uint32_t>(ignore_case_hash{}(name)));
+      return (slots[i].id == 0) ? no_index : slots[i].id - 1;
+    }
+
+    size_t get_size() const
+    {
+      return names.size();
+    }
+  };
+
+//------------------------------------------------------------------------------
+
+  struct element
+  {
+    // r, l, c or x (subcircuit instance):
+    char kind;
+    size_t node_a;
+    size_t node_b;
+    double value;
+
+    // Parasitics given as R= / L= / C= (negative if not given):
+    double resistance;
+    double inductance;
+    double capacitance;
+
+    // Given as TC1= / TC2= or TC=tc1[,tc2] (zero if not), moved to 25 C
+    // once parsed:
+    temperature_coefficients coefficients;
+
+    std::string_view subckt;
+    size_t line;
+  };
+
+  struct definition
+  {
+    std::string_view name;
+    node_table nodes;
+    size_t port_a = no_index;
+    size_t port_b = no_index;
+    std::vector<element> elements;
+  };
+
+  struct parsed_netlist
+  {
+    definition top;
+    name_map<definition> subckts;
+
+    // Nodes and AC magnitude of the first source (if any):
+    bool has_source = false;
+    size_t source_a = no_index;
+    size_t source_b = no_index;
+    double source_voltage = 0.0;
+  };
+
+//------------------------------------------------------------------------------
+
+  double parse_value(std::string_view text, const size_t &line)
+  {
+    try {
+      return parse_spice_value(text);
+    }
+    catch (const std::invalid_argument &ia) {
+      throw line_error(line, ia.what());
+    }
+  }
+
+  // Is the token a number (not the next key of a key=value pair):
+  bool starts_value(std::string_view text)
+  {
+    return !text.empty() && (std::isdigit(static_cast<unsigned char>(text[0]))
+      || text[0] == '.' || text[0] == '+' || text[0] == '-');
+  }
+
+  // SPICE gives a value and its TC1 / TC2 at TNOM, 27 C by default, but
+  // components here are at nominal_temperature (25 C). Re-expanding the same
+  // drift about 25 C keeps every temperature's value exact:
+  const double spice_nominal_temperature = 27.0;
+
+  void move_to_nominal_temperature(element &elem)
+  {
+    if (elem.coefficients.is_zero()) {
+      return;
+    }
+
+    double shift = nominal_temperature - spice_nominal_temperature;
+    double first = elem.coefficients.first;
+    double second = elem.coefficients.second;
+
+    double factor = 1.0 + (first * shift) + (second * shift * shift);
+    if (!(factor > 0.0)) {
+      throw line_error(elem.line,
+        "TC= / TC1= / TC2= give a value <= 0 at 25 C.");
+    }
+
+    elem.value *= factor;
+    elem.coefficients.first = (first + (2.0 * second * shift)) / factor;
+    elem.coefficients.second = second / factor;
+  }
+
+  class netlist_parser
+  {
+  private:
+    parsed_netlist &netlist;
+    definition *current;
+    bool ended = false;
+
+    void parse_directive(
+      const std::vector<std::string_view> &tokens, const size_t &line)
+    {
+      std::string_view directive = tokens[0];
+
+      if (equals_ignore_case(directive, ".subckt")) {
+        if (current != &netlist.top) {
+          throw line_error(line, "Nested .subckt definitions not supported.");
+        }
+
+        if (tokens.size() < 4) {
+          throw line_error(line, ".subckt needs a name and two ports.");
+        }
+
+        // Anything after the ports would be more pins:
+        if (tokens.size() > 4) {
+          throw line_error(line,
+            "Only two terminal subcircuits are supported.");
+        }
+
+        auto inserted = netlist.subckts.emplace(tokens[1], definition{});
+        if (!inserted.second) {
+          throw line_error(line,
+            "Subcircuit " + std::string{tokens[1]} + " defined twice.");
+        }
+
+        current = &inserted.first->second;
+        current->name = tokens[1];
+        current->port_a = current->nodes.intern(tokens[2]);
+        current->port_b = current->nodes.intern(tokens[3]);
+
+      } else if (equals_ignore_case(directive, ".ends")) {
+        if (current == &netlist.top) {
+          throw line_error(line, ".ends without a .subckt.");
+        }
+        current = &netlist.top;
+
+      } else if (equals_ignore_case(directive, ".end")) {
+        ended = true;
+
+      } else if (equals_ignore_case(directive, ".include")
+        || equals_ignore_case(directive, ".inc")
+        || equals_ignore_case(directive, ".lib")) {
+        throw line_error(line, std::string{directive} + " is not supported.");
+      }
+
+      // Analysis / output directives (.ac, .tran, .print, ...) are ignored.
+    }
+
+    // Only used for its nodes (default ports) and AC magnitude:
+    void parse_source(
+      const std::vector<std::string_view> &tokens, const size_t &line)
+    {
+      if (netlist.has_source || current != &netlist.top) {
+        return;
+      }
+
+      netlist.has_source = true;
+      netlist.source_a = current->nodes.intern(tokens[1]);
+      netlist.source_b = current->nodes.intern(tokens[2]);
+
+      for (size_t i{3}; i + 1 < tokens.size(); ++i) {
+        if (equals_ignore_case(tokens[i], "ac")) {
+          netlist.source_voltage = parse_value(tokens[i + 1], line);
+        }
+      }
+    }
+
+    void parse_element(
+      const std::vector<std::string_view> &tokens, const size_t &line)
+    {
+      if (tokens.size() < 3) {
+        throw line_error(line, "Element needs two nodes.");
+      }
+
+      element elem{};
+      elem.kind = to_lower(tokens[0][0]);
+      elem.resistance = -1.0;
+      elem.inductance = -1.0;
+      elem.capacitance = -1.0;
+      elem.line = line;
+
+      switch (elem.kind) {
+        case 'r':
+        case 'l':
+        case 'c': {
+          if (tokens.size() < 4) {
+            throw line_error(line, "Element needs a value.");
+          }
+
+          elem.value = parse_value(tokens[3], line);
+
+          // Optional parasitics (a non-ideal model takes both of its
+          // type's: L= and C= for R, R= and L= for C, R= and C= for L) and
+          // temperature coefficients (other parameters are ignored):
+          for (size_t i{4}; i + 1 < tokens.size(); i += 2) {
+            if (equals_ignore_case(tokens[i], "r")) {
+              elem.resistance = parse_value(tokens[i + 1], line);
+            } else if (equals_ignore_case(tokens[i], "l")) {
+              elem.inductance = parse_value(tokens[i + 1], line);
+            } else if (equals_ignore_case(tokens[i], "c")) {
+              elem.capacitance = parse_value(tokens[i + 1], line);
+            } else if (equals_ignore_case(tokens[i], "tc1")) {
+              elem.coefficients.first = parse_value(tokens[i + 1], line);
+            } else if (equals_ignore_case(tokens[i], "tc2")) {
+              elem.coefficients.second = parse_value(tokens[i + 1], line);
+            } else if (equals_ignore_case(tokens[i], "tc")) {
+              // TC=tc1,tc2 (the comma splits off a third token):
+              elem.coefficients.first = parse_value(tokens[i + 1], line);
+              if (i + 2 < tokens.size() && starts_value(tokens[i + 2])) {
+                elem.coefficients.second = parse_value(tokens[i + 2], line);
+                ++i;
+              }
+            }
+          }
+          move_to_nominal_temperature(elem);
+          break;
+        }
+
+        case 'x': {
+          if (tokens.size() != 4) {
+            throw line_error(line,
+              "Only two terminal subcircuit instances are supported.");
+          }
+          elem.subckt = tokens[3];
+          break;
+        }
+
+        case 'v':
+        case 'i': {
+          parse_source(tokens, line);
+          return;
+        }
+
+        default: {
+          throw line_error(line,
+            "Unsupported element " + std::string{tokens[0]} + ".");
+        }
+      }
+
+      elem.node_a = current->nodes.intern(tokens[1]);
+      elem.node_b = current->nodes.intern(tokens[2]);
+      current->elements.push_back(elem);
+    }
+
+  public:
+    netlist_parser(parsed_netlist &parsed)
+      : netlist{parsed}, current{&parsed.top}
+    {}
+
+    bool is_ended() const
+    {
+      return ended;
+    }
+
+    void parse_statement(
+      const std::vector<std::string_view> &tokens, const size_t &line)
+    {
+      if (tokens.empty()) {
+        return;
+      }
+
+      if (tokens[0][0] == '.') {
+        parse_directive(tokens, line);
+      } else {
+        parse_element(tokens, line);
+      }
+    }
+
+    void finish()
+    {
+      if (current != &netlist.top) {
+        throw std::invalid_argument{"Subcircuit "
+          + std::string{current->name} + " is missing .ends."};
+      }
+    }
+  };
+
+//------------------------------------------------------------------------------
+
+  // Statements can carry on over '+' lines, so tokens are collected until
+  // the next statement starts:
+  void parse_text(std::string_view text, parsed_netlist &netlist)
+  {
+    netlist_parser parser{netlist};
+
+    std::vector<std::string_view> tokens;
+    tokens.reserve(16);
+
+    size_t statement_line{};
+    size_t line_number{};
+    size_t position{};
+
+    while (position < text.size() && !parser.is_ended()) {
+      size_t line_end = text.find('\n', position);
+      if (line_end == std::string_view::npos) {
+        line_end = text.size();
+      }
+
+      std::string_view line = text.substr(position, line_end - position);
+      position = line_end + 1;
+      ++line_number;
+
+      // First line is always the title:
+      if (line_number == 1 || line.empty() || line[0] == '*') {
+        continue;
+      }
+
+      if (line[0] == '+') {
+        tokenize(line.substr(1), tokens);
+        continue;
+      }
+
+      parser.parse_statement(tokens, statement_line);
+      tokens.clear();
+
+      tokenize(line, tokens);
+      statement_line = line_number;
+    }
+
+    if (!parser.is_ended()) {
+      parser.parse_statement(tokens, statement_line);
+    }
+
+    parser.finish();
+  }
+
+//------------------------------------------------------------------------------
+// Series / parallel reduction:
+//------------------------------------------------------------------------------
+
+  // Series / parallel expression built up while reducing the graph:
+  struct network
+  {
+    // e (single element), s (series) or p (parallel):
+    char kind;
+    std::shared_ptr<component> comp;
+
+    // Parts are a linked list (through next_part), so joining is O(1):
+    size_t first_part;
+    size_t last_part;
+    size_t next_part;
+  };
+
+  // Each edge is in the edge list of both of its nodes:
+  struct edge
+  {
+    size_t nodes[2];
+    size_t next[2];
+    size_t net;
+    bool alive;
+  };
+
+  class graph_reducer
+  {
+  private:
+    std::vector<network> networks;
+    std::vector<edge> edges;
+
+    // Per node: first edge in its list and number of live edges:
+    std::vector<size_t> heads;
+    std::vector<size_t> degrees;
+    std::vector<bool> is_port;
+
+    // Live edge between each pair of nodes (stale entries are overwritten):
+    std::vector<std::pair<uint64_t, size_t>> pair_slots;
+
+    std::vector<size_t> work;
+    std::vector<size_t> live;
+
+    size_t side(const size_t &e, const size_t &node) const
+    {
+      return (edges[e].nodes[0] == node) ? 0 : 1;
+    }
+
+    size_t other_end(const size_t &e, const size_t &node) const
+    {
+      return edges[e].nodes[1 - side(e, node)];
+    }
+
+    // Slot for the (unordered) node pair, key 0 marks an empty slot:
+    std::pair<uint64_t, size_t> &pair_slot(const size_t &a, const size_t &b)
+    {
+      uint64_t key = ((static_cast<uint64_t>(std::min(a, b)) << 32)
+        | static_cast<uint64_t>(std::max(a, b))) + 1;
+
+      size_t mask = pair_slots.size() - 1;
+      size_t i = static_cast<size_t>(key * 0x9e3779b97f4a7c15ull) & mask;
+
+      while (pair_slots[i].first != 0 && pair_slots[i].first != key) {
+        i = (i + 1) & mask;
+      }
+
+      if (pair_slots[i].first == 0) {
+        pair_slots[i] = std::make_pair(key, no_index);
+      }
+
+      return pair_slots[i];
+    }
+
+    void grow_pairs()
+    {
+      std::vector<std::pair<uint64_t, size_t>> old_slots(
+        2 * pair_slots.size());
+      std::swap(pair_slots, old_slots);
+
+      for (size_t e{}; e < edges.size(); ++e) {
+        if (edges[e].alive) {
+          pair_slot(edges[e].nodes[0], edges[e].nodes[1]).second = e;
+        }
+      }
+    }
+
+    // Joins two networks, reusing a run of the same kind if there is one:
+    size_t combine(const char &kind, size_t x, size_t y)
+    {
+      if (networks[x].kind != kind && networks[y].kind == kind) {
+        std::swap(x, y);
+      }
+
+      if (networks[x].kind != kind) {
+        networks.push_back(network{kind, nullptr, x, x, no_index});
+        x = networks.size() - 1;
+      }
+
+      // Splice y (or its parts) onto the end of x's parts:
+      size_t first = y;
+      size_t last = y;
+      if (networks[y].kind == kind) {
+        first = networks[y].first_part;
+        last = networks[y].last_part;
+      }
+
+      networks[networks[x].last_part].next_part = first;
+      networks[x].last_part = last;
+      networks[last].next_part = no_index;
+
+      return x;
+    }
+
+    void queue_node(const size_t &node)
+    {
+      if (!is_port[node] && degrees[node] <= 2) {
+        work.push_back(node);
+      }
+    }
+
+    // Adds an edge, merging it with any edge already between the nodes:
+    void connect(const size_t &a, const size_t &b, const size_t &net)
+    {
+      if (2 * (edges.size() + 1) > pair_slots.size()) {
+        grow_pairs();
+      }
+
+      std::pair<uint64_t, size_t> &slot = pair_slot(a, b);
+
+      if (slot.second != no_index && edges[slot.second].alive) {
+        edges[slot.second].net = combine('p', edges[slot.second].net, net);
+        return;
+      }
+
+      edges.push_back(edge{{a, b}, {heads[a], heads[b]}, net, true});
+      heads[a] = edges.size() - 1;
+      heads[b] = edges.size() - 1;
+      ++degrees[a];
+      ++degrees[b];
+      slot.second = edges.size() - 1;
+    }
+
+    void kill_edge(const size_t &e)
+    {
+      edges[e].alive = false;
+      --degrees[edges[e].nodes[0]];
+      --degrees[edges[e].nodes[1]];
+    }
+
+    // Live edges of a node (dead ones are unlinked on the way):
+    void collect_live(const size_t &node)
+    {
+      live.clear();
+      for (size_t e = heads[node]; e != no_index; e = edges[e].next[side(e, node)]) {
+        if (edges[e].alive) {
+          live.push_back(e);
+        }
+      }
+
+      heads[node] = no_index;
+      for (auto e = live.rbegin(); e != live.rend(); ++e) {
+        edges[*e].next[side(*e, node)] = heads[node];
+        heads[node] = *e;
+      }
+    }
+
+    void process_node(const size_t &node)
+    {
+      if (is_port[node] || degrees[node] == 0 || degrees[node] > 2) {
+        return;
+      }
+
+      collect_live(node);
+
+      // Dangling element, no current flows through it:
+      if (live.size() == 1) {
+        size_t neighbour = other_end(live[0], node);
+        kill_edge(live[0]);
+        queue_node(neighbour);
+
+      // Internal node joining two elements in series:
+      } else if (live.size() == 2) {
+        size_t e1 = live[0];
+        size_t e2 = live[1];
+        size_t u = other_end(e1, node);
+        size_t w = other_end(e2, node);
+
+        size_t net = combine('s', edges[e1].net, edges[e2].net);
+        kill_edge(e1);
+        kill_edge(e2);
+
+        connect(u, w, net);
+        queue_node(u);
+        queue_node(w);
+      }
+    }
+
+  public:
+    graph_reducer(const size_t &node_count, const size_t &port_a,
+      const size_t &port_b)
+      : heads(node_count, no_index), degrees(node_count, 0),
+        is_port(node_count, false), pair_slots(64)
+    {
+      is_port[port_a] = true;
+      is_port[port_b] = true;
+    }
+
+    void add_element(const size_t &a, const size_t &b,
+      const std::shared_ptr<component> &comp)
+    {
+      // Both ends on one node, so it is shorted out:
+      if (a == b) {
+        return;
+      }
+
+      networks.push_back(network{'e', comp, no_index, no_index, no_index});
+      connect(a, b, networks.size() - 1);
+    }
+
+    // Returns the network left between the ports:
+    size_t reduce(const size_t &port_a, const size_t &port_b)
+    {
+      for (size_t node{}; node < heads.size(); ++node) {
+        queue_node(node);
+      }
+
+      while (!work.empty()) {
+        size_t node = work.back();
+        work.pop_back();
+
+        process_node(node);
+      }
+
+      // Everything left should now be a single edge between the ports:
+      size_t result = no_index;
+
+      for (const auto &e : edges) {
+        if (!e.alive) {
+          continue;
+        }
+
+        bool between_ports = (e.nodes[0] == port_a && e.nodes[1] == port_b)
+          || (e.nodes[0] == port_b && e.nodes[1] == port_a);
+
+        if (!between_ports) {
+          throw std::runtime_error{"Netlist is not a series / parallel "
+            "network between the ports (e.g. it contains a bridge)."};
+        }
+
+        result = e.net;
+      }
+
+      if (result == no_index) {
+        throw std::invalid_argument{"Netlist has no path between the ports."};
+      }
+
+      return result;
+    }
+
+    // Components of a series / parallel network, with connections set:
+    std::vector<std::shared_ptr<component>> build_parts(
+      const size_t &net, const double &freq)
+    {
+      if (networks[net].kind == 'e') {
+        networks[net].comp->set_connection_type('s');
+        return {networks[net].comp};
+      }
+
+      std::vector<std::shared_ptr<component>> parts;
+
+      for (size_t part = networks[net].first_part; part != no_index;
+        part = networks[part].next_part) {
+        std::shared_ptr<component> comp = networks[part].comp;
+
+        if (networks[part].kind != 'e') {
+          comp = std::make_shared<circuit>(freq, 0.0, build_parts(part, freq));
+          comp->set_nested_bool(true);
+        }
+
+        comp->set_connection_type(networks[net].kind);
+        parts.push_back(comp);
+      }
+
+      return parts;
+    }
+  };
+
+//------------------------------------------------------------------------------
+
+  class reduction_context
+  {
+  private:
+    const parsed_netlist &netlist;
+    double frequency;
+
+    // Reduced subcircuits, cloned for each instance:
+    name_map<std::shared_ptr<circuit>> prototypes;
+    name_map<bool> in_progress;
+
+    std::shared_ptr<component> make_element(const element &elem);
+
+  public:
+    reduction_context(const parsed_netlist &parsed, const double &freq)
+      : netlist{parsed}, frequency{freq}
+    {}
+
+    // Reduces a definition to a single network between two of its nodes:
+    std::vector<std::shared_ptr<component>> reduce(const definition &def,
+      const size_t &port_a, const size_t &port_b);
+
+    const std::shared_ptr<circuit> &get_prototype(
+      std::string_view name, const size_t &line);
+  };
+
+//------------------------------------------------------------------------------
+
+  // R / L / C element (line numbers added to range errors):
+  // True if the element gives either of its type's two parasitics (the
+  // non-ideal model needs both, so a missing one is reported by name):
+  bool has_parasitics(const element &elem, const std::string &type,
+    const double &first, const char *first_name, const double &second,
+    const char *second_name)
+  {
+    if (first < 0.0 && second < 0.0) {
+      return false;
+    }
+
+    const char *missing = (first < 0.0) ? first_name
+      : (second < 0.0) ? second_name : nullptr;
+    if (missing != nullptr) {
+      throw line_error(elem.line, "Non-ideal " + type + " needs both "
+        + first_name + "= and " + second_name + "= (" + missing
+        + "= is missing).");
+    }
+    return true;
+  }
+
+  // Drifting only if TC1= / TC2= were given (see base_component.hpp):
+  template <class T, class... A> std::shared_ptr<component> make_part(
+    const temperature_coefficients &tc, const A &... args)
+  {
+    if (tc.is_zero()) {
+      return std::make_shared<T>(args...);
+    }
+
+    auto part = std::make_shared<drifting<T>>(args...);
+    part->set_temperature_coefficients(tc);
+    return part;
+  }
+
+  std::shared_ptr<component> make_basic_element(const element &elem)
+  {
+    std::shared_ptr<component> comp;
+
+    try {
+      const temperature_coefficients &tc = elem.coefficients;
+      switch (elem.kind) {
+        case 'r': {
+          if (has_parasitics(elem, "resistor", elem.inductance, "L",
+            elem.capacitance, "C")) {
+            comp = make_part<real_resistor>(tc,
+              elem.value, elem.inductance, elem.capacitance);
+          } else {
+            comp = make_part<resistor>(tc, elem.value);
+          }
+          break;
+        }
+
+        case 'c': {
+          if (has_parasitics(elem, "capacitor", elem.resistance, "R",
+            elem.inductance, "L")) {
+            comp = make_part<real_capacitor>(tc,
+              elem.resistance, elem.inductance, elem.value);
+          } else {
+            comp = make_part<capacitor>(tc, elem.value);
+          }
+          break;
+        }
+
+        case 'l': {
+          if (has_parasitics(elem, "inductor", elem.resistance, "R",
+            elem.capacitance, "C")) {
+            comp = make_part<real_inductor>(tc,
+              elem.resistance, elem.value, elem.capacitance);
+          } else {
+            comp = make_part<inductor>(tc, elem.value);
+          }
+          break;
+        }
+      }
+    }
+    // Component range checks, reported with the line they came from:
+    catch (const std::out_of_range &oor) {
+      throw line_error(elem.line, oor.what());
+    }
+
+    return comp;
+  }
+
+  std::shared_ptr<component> reduction_context::make_element(
+    const element &elem)
+  {
+    std::shared_ptr<component> comp;
+
+    if (elem.kind == 'x') {
+      comp = get_prototype(elem.subckt, elem.line)->clone();
+    } else {
+      comp = make_basic_element(elem);
+    }
+
+    try {
+      comp->set_frequency(frequency);
+    }
+    catch (const std::out_of_range &oor) {
+      throw line_error(elem.line, oor.what());
+    }
+
+    return comp;
+  }
+
+//------------------------------------------------------------------------------
+
+  std::vector<std::shared_ptr<component>> reduction_context::reduce(
+    const definition &def, const size_t &port_a, const size_t &port_b)
+  {
+    if (port_a == port_b) {
+      throw std::invalid_argument{"Ports must be two different nodes."};
+    }
+
+    graph_reducer reducer{def.nodes.get_size(), port_a, port_b};
+
+    for (const auto &elem : def.elements) {
+      reducer.add_element(elem.node_a, elem.node_b, make_element(elem));
+    }
+
+    size_t net = reducer.reduce(port_a, port_b);
+    return reducer.build_parts(net, frequency);
+  }
+
+//------------------------------------------------------------------------------
+
+  const std::shared_ptr<circuit> &reduction_context::get_prototype(
+    std::string_view name, const size_t &line)
+  {
+    auto existing = prototypes.find(name);
+    if (existing != prototypes.end()) {
+      return existing->second;
+    }
+
+    auto def = netlist.subckts.find(name);
+    if (def == netlist.subckts.end()) {
+      throw line_error(line,
+        "Unknown subcircuit " + std::string{name} + ".");
+    }
+
+    if (in_progress[name]) {
+      throw line_error(line,
+        "Subcircuit " + std::string{name} + " contains itself.");
+    }
+
+    in_progress[name] = true;
+
+    std::vector<std::shared_ptr<component>> parts = reduce(
+      def->second, def->second.port_a, def->second.port_b);
+
+    in_progress[name] = false;
+
+    auto prototype = std::make_shared<circuit>(frequency, 0.0,
+      std::move(parts));
+    return prototypes.emplace(name, prototype).first->second;
+  }
+
+//------------------------------------------------------------------------------
+// Nodal expansion:
+//------------------------------------------------------------------------------
+
+  // Copies every element into a nodal circuit, expanding subcircuit
+  // instances in place (their internal nodes become new nodes):
+  class nodal_builder
+  {
+  private:
+    const parsed_netlist &netlist;
+    nodal_circuit &result;
+    name_map<bool> in_progress;
+
+  public:
+    nodal_builder(const parsed_netlist &parsed, nodal_circuit &nodal)
+      : netlist{parsed}, result{nodal}
+    {}
+
+    // nodes maps the definition's node numbers to the circuit's:
+    void expand(const definition &def, const std::vector<size_t> &nodes)
+    {
+      for (const auto &elem : def.elements) {
+        if (elem.kind != 'x') {
+          result.add_element(nodes[elem.node_a], nodes[elem.node_b],
+            make_basic_element(elem));
+          continue;
+        }
+
+        auto sub = netlist.subckts.find(elem.subckt);
+        if (sub == netlist.subckts.end()) {
+          throw line_error(elem.line,
+            "Unknown subcircuit " + std::string{elem.subckt} + ".");
+        }
+
+        if (in_progress[elem.subckt]) {
+          throw line_error(elem.line, "Subcircuit "
+            + std::string{elem.subckt} + " contains itself.");
+        }
+
+        const definition &sub_def = sub->second;
+        std::vector<size_t> sub_nodes(sub_def.nodes.get_size(), no_index);
+        sub_nodes[sub_def.port_a] = nodes[elem.node_a];
+        sub_nodes[sub_def.port_b] = nodes[elem.node_b];
+
+        for (auto &node : sub_nodes) {
+          if (node == no_index) {
+            node = result.add_node();
+          }
+        }
+
+        in_progress[elem.subckt] = true;
+        expand(sub_def, sub_nodes);
+        in_progress[elem.subckt] = false;
+      }
+    }
+  };
+
+//------------------------------------------------------------------------------
+
+  // Ports given in the options, otherwise the nodes of the first source:
+  std::pair<size_t, size_t> find_ports(const parsed_netlist &netlist,
+    const netlist_options &options)
+  {
+    size_t port_a = netlist.source_a;
+    size_t port_b = netlist.source_b;
+
+    // Default to the impedance seen by the first source:
+    if (!options.port_a.empty() && !options.port_b.empty()) {
+      port_a = netlist.top.nodes.find(options.port_a);
+      port_b = netlist.top.nodes.find(options.port_b);
+
+      if (port_a == no_index || port_b == no_index) {
+        throw std::invalid_argument{"Port node "
+          + ((port_a == no_index) ? options.port_a : options.port_b)
+          + " is not in the netlist."};
+      }
+
+    } else if (!netlist.has_source) {
+      throw std::invalid_argument{
+        "Netlist has no source, so the ports must be given."};
+    }
+
+    return std::make_pair(port_a, port_b);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Netlist import:
+//------------------------------------------------------------------------------
+
+double circuits::parse_spice_value(std::string_view text)
+{
+  const char *first = text.data();
+  const char *last = text.data() + text.size();
+
+  if (first != last && *first == '+') {
+    ++first;
+  }
+
+  double value{};
+  auto result = std::from_chars(first, last, value);
+
+  if (result.ec != std::errc{} || !std::isfinite(value)) {
+    throw std::invalid_argument{"Invalid value " + std::string{text} + "."};
+  }
+
+  std::string_view suffix{result.ptr,
+    static_cast<size_t>(last - result.ptr)};
+
+  if (suffix.empty()) {
+    return value;
+  }
+
+  if (starts_with_ignore_case(suffix, "meg")) {
+    return value * 1e6;
+  }
+
+  if (starts_with_ignore_case(suffix, "mil")) {
+    return value * 25.4e-6;
+  }
+
+  switch (to_lower(suffix[0])) {
+    case 't': return value * 1e12;
+    case 'g': return value * 1e9;
+    case 'k': return value * 1e3;
+    case 'm': return value * 1e-3;
+    case 'u': return value * 1e-6;
+    case 'n': return value * 1e-9;
+    case 'p': return value * 1e-12;
+    case 'f': return value * 1e-15;
+  }
+
+  // Just units (Ohm, H, V, ...):
+  return value;
+}
+
+//------------------------------------------------------------------------------
+
+std::unique_ptr<circuit> circuits::parse_netlist(
+  std::string_view text, const netlist_options &options)
+{
+  parsed_netlist netlist;
+  parse_text(text, netlist);
+
+  auto [port_a, port_b] = find_ports(netlist, options);
+
+  double voltage = (options.voltage < 0.0)
+    ? netlist.source_voltage : options.voltage;
+
+  reduction_context context{netlist, options.frequency};
+
+  std::vector<std::shared_ptr<component>> parts = context.reduce(
+    netlist.top, port_a, port_b);
+
+  return std::make_unique<circuit>(options.frequency, voltage,
+    std::move(parts));
+}
+
+//------------------------------------------------------------------------------
+
+std::unique_ptr<circuit> circuits::import_netlist(
+  const std::string &filename, const netlist_options &options)
+{
+  mapped_file file{filename};
+  return parse_netlist(file.get_text(), options);
+}
+
+//------------------------------------------------------------------------------
+
+nodal_circuit circuits::parse_netlist_nodal(
+  std::string_view text, const netlist_options &options)
+{
+  parsed_netlist netlist;
+  parse_text(text, netlist);
+
+  auto [port_a, port_b] = find_ports(netlist, options);
+
+  size_t node_count = netlist.top.nodes.get_size();
+  nodal_circuit nodal{node_count, port_a, port_b};
+
+  std::vector<size_t> nodes(node_count);
+  for (size_t i{}; i < node_count; ++i) {
+    nodes[i] = i;
+  }
+
+  nodal_builder builder{netlist, nodal};
+  builder.expand(netlist.top, nodes);
+
+  return nodal;
+}
+
+nodal_circuit circuits::import_netlist_nodal(
+  const std::string &filename, const netlist_options &options)
+{
+  mapped_file file{filename};
+  return parse_netlist_nodal(file.get_text(), options);
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,60 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// SPICE netlist importer (R / L / C elements, .subckt and X instances):
+//------------------------------------------------------------------------------
+
+#ifndef netlist_hpp
+#define netlist_hpp
+
+#include "circuit.hpp"
+#include "nodal.hpp"
+
+#include <string_view>
+
+//------------------------------------------------------------------------------
+
+namespace circuits
+{
+  struct netlist_options
+  {
+    // Nodes the impedance is measured between, if blank the nodes of the
+    // first V / I source are used:
+    std::string port_a;
+    std::string port_b;
+
+    double frequency = 0.0;
+
+    // Negative means use the source's AC magnitude (or 0 if none):
+    double voltage = -1.0;
+  };
+
+  // Value with an engineering suffix, e.g. 4.7k, 10meg, 2.2uF, 1e-9:
+  // (SPICE rules, so m is milli and any trailing units are ignored)
+  double parse_spice_value(std::string_view text);
+
+  // Parses netlist text (first line is the title, as in SPICE) and reduces
+  // it to nested series / parallel circuits between the two ports:
+  std::unique_ptr<circuit> parse_netlist(std::string_view text,
+    const netlist_options &options = netlist_options{});
+
+  // Memory maps the file and parses it in place:
+  std::unique_ptr<circuit> import_netlist(const std::string &filename,
+    const netlist_options &options = netlist_options{});
+
+  // Keeps the nodes instead, for nodal analysis of any network (bridges
+  // included), subcircuit instances are expanded in place:
+  // (frequency and voltage in the options aren't used)
+  nodal_circuit parse_netlist_nodal(std::string_view text,
+    const netlist_options &options = netlist_options{});
+
+  nodal_circuit import_netlist_nodal(const std::string &filename,
+    const netlist_options &options = netlist_options{});
+}
+
+//------------------------------------------------------------------------------
+#endif
+//------------------------------------------------------------------------------
@@ -0,0 +1,780 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Nodal analysis (any two terminal network, including bridges):
+//------------------------------------------------------------------------------
+
+#include "nodal.hpp"
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <set>
+#include <stdexcept>
+
+using namespace circuits;
+
+//------------------------------------------------------------------------------
+// Helper functions (only used in this file):
+//------------------------------------------------------------------------------
+
+namespace
+{
+  const size_t no_index = static_cast<size_t>(-1);
+
+  // Minimum degree ordering on the quotient graph (as AMD, but with exact
+  // degrees and no supervariables, circuit graphs have low degree anyway):
+  // eliminated variables become "elements" standing for the clique of their
+  // remaining neighbours, so fill never has to be stored explicitly.
+  std::vector<size_t> minimum_degree_order(
+    const std::vector<std::vector<size_t>> &adjacency)
+  {
+    size_t size = adjacency.size();
+
+    // Variables adjacent to each variable / elements adjacent to it:
+    std::vector<std::vector<size_t>> variables = adjacency;
+    std::vector<std::vector<size_t>> elements(size);
+
+    // Variables of each element (element e is the eliminated variable e):
+    std::vector<std::vector<size_t>> members(size);
+
+    std::vector<bool> eliminated(size, false);
+    std::vector<bool> absorbed(size, false);
+
+    std::vector<size_t> degrees(size);
+    std::set<std::pair<size_t, size_t>> queue;
+    for (size_t i{}; i < size; ++i) {
+      degrees[i] = variables[i].size();
+      queue.emplace(degrees[i], i);
+    }
+
+    std::vector<size_t> marks(size, 0);
+    size_t stamp{};
+
+    std::vector<size_t> order;
+    order.reserve(size);
+
+    while (!queue.empty()) {
+      size_t pivot = queue.begin()->second;
+      queue.erase(queue.begin());
+
+      eliminated[pivot] = true;
+      order.push_back(pivot);
+
+      // New element: remaining neighbours of pivot, through any element:
+      std::vector<size_t> &pivot_members = members[pivot];
+      ++stamp;
+      marks[pivot] = stamp;
+
+      for (const auto &v : variables[pivot]) {
+        if (!eliminated[v] && marks[v] != stamp) {
+          marks[v] = stamp;
+          pivot_members.push_back(v);
+        }
+      }
+
+      for (const auto &e : elements[pivot]) {
+        if (absorbed[e]) {
+          continue;
+        }
+        for (const auto &v : members[e]) {
+          if (!eliminated[v] && marks[v] != stamp) {
+            marks[v] = stamp;
+            pivot_members.push_back(v);
+          }
+        }
+
+        // Its members are all in the new element now:
+        absorbed[e] = true;
+        std::vector<size_t>{}.swap(members[e]);
+      }
+
+      std::vector<size_t>{}.swap(variables[pivot]);
+      std::vector<size_t>{}.swap(elements[pivot]);
+
+      // Neighbours now reach each other through the new element, so drop
+      // the direct links it covers:
+      for (const auto &i : pivot_members) {
+        auto &i_elements = elements[i];
+        i_elements.erase(std::remove_if(i_elements.begin(), i_elements.end(),
+          [&](const size_t &e) { return absorbed[e]; }), i_elements.end());
+        i_elements.push_back(pivot);
+
+        auto &i_variables = variables[i];
+        i_variables.erase(std::remove_if(i_variables.begin(),
+          i_variables.end(), [&](const size_t &v) {
+            return eliminated[v] || marks[v] == stamp;
+          }), i_variables.end());
+      }
+
+      // Exact degree of each neighbour (distinct variables it reaches):
+      for (const auto &i : pivot_members) {
+        ++stamp;
+        marks[i] = stamp;
+        size_t degree{};
+
+        for (const auto &v : variables[i]) {
+          if (marks[v] != stamp) {
+            marks[v] = stamp;
+            ++degree;
+          }
+        }
+
+        for (const auto &e : elements[i]) {
+          for (const auto &v : members[e]) {
+            if (!eliminated[v] && marks[v] != stamp) {
+              marks[v] = stamp;
+              ++degree;
+            }
+          }
+        }
+
+        queue.erase(std::make_pair(degrees[i], i));
+        degrees[i] = degree;
+        queue.emplace(degree, i);
+      }
+    }
+
+    return order;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Analysis (everything that depends only on the topology):
+//------------------------------------------------------------------------------
+
+class circuits::nodal_analysis
+{
+public:
+  // Unknowns and the (permuted) unknown of port_a:
+  size_t size = 0;
+  size_t port = 0;
+
+  // Upper triangle of the permuted Y by column, diagonal last in each:
+  std::vector<size_t> column_starts;
+  std::vector<size_t> rows;
+
+  // Where each element's admittance goes in Y (no_index if nowhere):
+  struct scatter
+  {
+    size_t diagonal_a;
+    size_t diagonal_b;
+    size_t off_diagonal;
+  };
+  std::vector<scatter> scatters;
+
+  // Pattern of L (unit lower triangular, by column):
+  std::vector<size_t> factor_starts;
+  std::vector<size_t> factor_rows;
+
+  // Non zero columns of each row of L in the order they are eliminated,
+  // and where that entry is stored:
+  std::vector<size_t> pattern_starts;
+  std::vector<size_t> pattern_columns;
+  std::vector<size_t> pattern_positions;
+
+  nodal_analysis(const size_t &node_count, const size_t &port_a,
+    const size_t &port_b, const std::vector<nodal_element> &elements);
+};
+
+//------------------------------------------------------------------------------
+
+circuits::nodal_analysis::nodal_analysis(const size_t &node_count,
+  const size_t &port_a, const size_t &port_b,
+  const std::vector<nodal_element> &elements)
+{
+  // Nodes reachable from ground (anything else is floating, so ignored):
+  std::vector<std::vector<size_t>> node_links(node_count);
+  for (const auto &elem : elements) {
+    if (elem.node_a != elem.node_b) {
+      node_links[elem.node_a].push_back(elem.node_b);
+      node_links[elem.node_b].push_back(elem.node_a);
+    }
+  }
+
+  std::vector<bool> reached(node_count, false);
+  std::vector<size_t> stack{port_b};
+  reached[port_b] = true;
+
+  while (!stack.empty()) {
+    size_t node = stack.back();
+    stack.pop_back();
+
+    for (const auto &next : node_links[node]) {
+      if (!reached[next]) {
+        reached[next] = true;
+        stack.push_back(next);
+      }
+    }
+  }
+
+  if (!reached[port_a]) {
+    throw std::invalid_argument{"Network has no path between the ports."};
+  }
+
+  // Number the unknowns (every reached node but ground):
+  std::vector<size_t> unknowns(node_count, no_index);
+  for (size_t node{}; node < node_count; ++node) {
+    if (reached[node] && node != port_b) {
+      unknowns[node] = size++;
+    }
+  }
+
+  std::vector<std::vector<size_t>> adjacency(size);
+  for (const auto &elem : elements) {
+    size_t a = unknowns[elem.node_a];
+    size_t b = unknowns[elem.node_b];
+
+    if (a != no_index && b != no_index && a != b) {
+      adjacency[a].push_back(b);
+      adjacency[b].push_back(a);
+    }
+  }
+
+  for (auto &links : adjacency) {
+    std::sort(links.begin(), links.end());
+    links.erase(std::unique(links.begin(), links.end()), links.end());
+  }
+
+//------------------------------------------------------------------------------
+
+  // Fill reducing order, old to new numbering:
+  std::vector<size_t> order = minimum_degree_order(adjacency);
+  std::vector<size_t> inverse(size);
+  for (size_t k{}; k < size; ++k) {
+    inverse[order[k]] = k;
+  }
+
+  port = inverse[unknowns[port_a]];
+
+  // Column k holds rows j < k linked to it, then the diagonal:
+  column_starts.assign(size + 1, 0);
+  for (size_t k{}; k < size; ++k) {
+    size_t count{1};
+    for (const auto &old : adjacency[order[k]]) {
+      count += (inverse[old] < k) ? 1 : 0;
+    }
+    column_starts[k + 1] = column_starts[k] + count;
+  }
+
+  rows.resize(column_starts[size]);
+  for (size_t k{}; k < size; ++k) {
+    size_t position = column_starts[k];
+    for (const auto &old : adjacency[order[k]]) {
+      if (inverse[old] < k) {
+        rows[position++] = inverse[old];
+      }
+    }
+    std::sort(rows.begin() + column_starts[k], rows.begin() + position);
+    rows[position] = k;
+  }
+
+  // Position of entry (row, column), row <= column:
+  auto find_entry = [&](const size_t &row, const size_t &column) {
+    auto first = rows.begin() + column_starts[column];
+    auto last = rows.begin() + column_starts[column + 1];
+    return static_cast<size_t>(std::lower_bound(first, last, row)
+      - rows.begin());
+  };
+
+  scatters.reserve(elements.size());
+  for (const auto &elem : elements) {
+    size_t a = unknowns[elem.node_a];
+    size_t b = unknowns[elem.node_b];
+    scatter entry{no_index, no_index, no_index};
+
+    // Shorted, floating or (one end at ground) only on the diagonal:
+    if (elem.node_a != elem.node_b
+      && (reached[elem.node_a] || reached[elem.node_b])) {
+      if (a != no_index) {
+        entry.diagonal_a = column_starts[inverse[a] + 1] - 1;
+      }
+      if (b != no_index) {
+        entry.diagonal_b = column_starts[inverse[b] + 1] - 1;
+      }
+      if (a != no_index && b != no_index) {
+        entry.off_diagonal = find_entry(std::min(inverse[a], inverse[b]),
+          std::max(inverse[a], inverse[b]));
+      }
+    }
+
+    scatters.push_back(entry);
+  }
+
+//------------------------------------------------------------------------------
+
+  // Elimination tree and column counts of L (as in Davis's LDL):
+  std::vector<size_t> parents(size, no_index);
+  std::vector<size_t> flags(size, no_index);
+  std::vector<size_t> counts(size, 0);
+
+  for (size_t k{}; k < size; ++k) {
+    flags[k] = k;
+    for (size_t p = column_starts[k]; p + 1 < column_starts[k + 1]; ++p) {
+      for (size_t i = rows[p]; flags[i] != k; i = parents[i]) {
+        if (parents[i] == no_index) {
+          parents[i] = k;
+        }
+        ++counts[i];
+        flags[i] = k;
+      }
+    }
+  }
+
+  factor_starts.assign(size + 1, 0);
+  for (size_t k{}; k < size; ++k) {
+    factor_starts[k + 1] = factor_starts[k] + counts[k];
+  }
+  factor_rows.resize(factor_starts[size]);
+
+  // Row patterns (walking up the tree from each entry), filling in L:
+  std::vector<size_t> filled(size, 0);
+  std::vector<size_t> path(size);
+  std::vector<size_t> pattern(size);
+  std::fill(flags.begin(), flags.end(), no_index);
+
+  pattern_starts.assign(size + 1, 0);
+  pattern_columns.reserve(factor_rows.size());
+  pattern_positions.reserve(factor_rows.size());
+
+  for (size_t k{}; k < size; ++k) {
+    size_t top = size;
+    flags[k] = k;
+
+    for (size_t p = column_starts[k]; p + 1 < column_starts[k + 1]; ++p) {
+      size_t length{};
+      for (size_t i = rows[p]; flags[i] != k; i = parents[i]) {
+        path[length++] = i;
+        flags[i] = k;
+      }
+      while (length > 0) {
+        pattern[--top] = path[--length];
+      }
+    }
+
+    for (; top < size; ++top) {
+      size_t i = pattern[top];
+      size_t position = factor_starts[i] + filled[i]++;
+
+      factor_rows[position] = k;
+      pattern_columns.push_back(i);
+      pattern_positions.push_back(position);
+    }
+    pattern_starts[k + 1] = pattern_columns.size();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Numeric factorisation and solve:
+//------------------------------------------------------------------------------
+
+namespace
+{
+  // Per thread scratch space for one analysis:
+  struct nodal_workspace
+  {
+    std::vector<std::complex<double>> values;
+    std::vector<std::complex<double>> work;
+    std::vector<std::complex<double>> diagonal;
+    std::vector<std::complex<double>> factor;
+
+    // Sum of |admittance| at each diagonal entry (the size a pivot is
+    // judged against), and the iterate / residual of any refinement:
+    std::vector<double> scale;
+    std::vector<std::complex<double>> refined;
+    std::vector<std::complex<double>> residual;
+
+    explicit nodal_workspace(const nodal_analysis &analysis)
+      : values(analysis.rows.size()), work(analysis.size),
+        diagonal(analysis.size), factor(analysis.factor_rows.size()),
+        scale(analysis.rows.size())
+    {}
+  };
+
+  // Solves L D L^T x = b in place (x holds b, zero above first):
+  void solve_factored(const nodal_analysis &analysis,
+    const nodal_workspace &space, std::vector<std::complex<double>> &x,
+    const size_t &first)
+  {
+    size_t size = analysis.size;
+
+    // (entries above first stay zero going forwards):
+    for (size_t j{first}; j < size; ++j) {
+      for (size_t p = analysis.factor_starts[j];
+        p < analysis.factor_starts[j + 1]; ++p) {
+        x[analysis.factor_rows[p]] -= space.factor[p] * x[j];
+      }
+    }
+
+    for (size_t j{}; j < size; ++j) {
+      x[j] /= space.diagonal[j];
+    }
+
+    for (size_t j = size; j-- > 0;) {
+      for (size_t p = analysis.factor_starts[j];
+        p < analysis.factor_starts[j + 1]; ++p) {
+        x[j] -= space.factor[p] * x[analysis.factor_rows[p]];
+      }
+    }
+  }
+
+  double largest(const std::vector<std::complex<double>> &x)
+  {
+    double size{};
+    for (const auto &value : x) {
+      size = std::max(size, std::abs(value));
+    }
+    return size;
+  }
+
+  // Assembles Y at freq, factorises it and returns v at port_a for 1 A
+  // injected there.
+  //
+  // Pivots are taken in the fill reducing order, so one can be (near) zero
+  // even though Y isn't singular, e.g. a series LC at its resonance. Such a
+  // pivot is replaced by a small one (static pivoting, as SuperLU_DIST does)
+  // and the solution refined against the real Y. Only if that doesn't
+  // converge is Y singular:
+  std::complex<double> solve_port(const nodal_analysis &analysis,
+    const std::vector<const component *> &parts, const double &freq,
+    nodal_workspace &space)
+  {
+    std::fill(space.values.begin(), space.values.end(),
+      std::complex<double>{});
+    std::fill(space.scale.begin(), space.scale.end(), 0.0);
+
+    for (size_t e{}; e < parts.size(); ++e) {
+      const auto &entry = analysis.scatters[e];
+      if (entry.diagonal_a == no_index && entry.diagonal_b == no_index) {
+        continue;
+      }
+
+      std::complex<double> admittance = 1.0 / parts[e]->evaluate(freq);
+      double magnitude = std::abs(admittance.real())
+        + std::abs(admittance.imag());
+
+      if (entry.diagonal_a != no_index) {
+        space.values[entry.diagonal_a] += admittance;
+        space.scale[entry.diagonal_a] += magnitude;
+      }
+      if (entry.diagonal_b != no_index) {
+        space.values[entry.diagonal_b] += admittance;
+        space.scale[entry.diagonal_b] += magnitude;
+      }
+      if (entry.off_diagonal != no_index) {
+        space.values[entry.off_diagonal] -= admittance;
+      }
+    }
+
+    // Up looking LDL^T (Y is complex symmetric, so no conjugates):
+    const double small = std::sqrt(std::numeric_limits<double>::epsilon());
+    bool perturbed = false;
+    size_t size = analysis.size;
+    auto &work = space.work;
+    auto &factor = space.factor;
+
+    for (size_t k{}; k < size; ++k) {
+      for (size_t p = analysis.column_starts[k];
+        p < analysis.column_starts[k + 1]; ++p) {
+        work[analysis.rows[p]] += space.values[p];
+      }
+
+      std::complex<double> pivot = work[k];
+      work[k] = 0.0;
+
+      for (size_t t = analysis.pattern_starts[k];
+        t < analysis.pattern_starts[k + 1]; ++t) {
+        size_t i = analysis.pattern_columns[t];
+        size_t position = analysis.pattern_positions[t];
+
+        std::complex<double> y_i = work[i];
+        work[i] = 0.0;
+
+        for (size_t p = analysis.factor_starts[i]; p < position; ++p) {
+          work[analysis.factor_rows[p]] -= factor[p] * y_i;
+        }
+
+        std::complex<double> l_ki = y_i / space.diagonal[i];
+        pivot -= l_ki * y_i;
+        factor[position] = l_ki;
+      }
+
+      double scale = space.scale[analysis.column_starts[k + 1] - 1];
+      if (!std::isfinite(std::abs(pivot)) || !std::isfinite(scale)) {
+        std::fill(work.begin(), work.end(), std::complex<double>{});
+        throw std::runtime_error{"Nodal matrix isn't finite at "
+          + std::to_string(freq) + " Hz (a component has zero impedance)."};
+      }
+
+      double threshold = small * scale;
+      if (std::abs(pivot) <= threshold) {
+        // Keeps the phase of what is left, if anything:
+        pivot = (pivot == 0.0) ? std::complex<double>{threshold}
+          : pivot * (threshold / std::abs(pivot));
+        perturbed = true;
+      }
+
+      if (pivot == 0.0) {
+        std::fill(work.begin(), work.end(), std::complex<double>{});
+        throw std::runtime_error{"Nodal matrix is singular at "
+          + std::to_string(freq) + " Hz (a node is only joined through open "
+          "circuits)."};
+      }
+      space.diagonal[k] = pivot;
+    }
+
+    // Solve L D L^T v = e_port:
+    auto &solution = work;
+    solution[analysis.port] = 1.0;
+    solve_factored(analysis, space, solution, analysis.port);
+
+    // Iterative refinement, r = e_port - Y v, v += (L D L^T)^-1 r:
+    if (perturbed) {
+      auto &refined = space.refined;
+      auto &residual = space.residual;
+      refined = solution;
+      residual.resize(size);
+
+      bool converged = false;
+      for (size_t iteration{}; iteration < 10 && !converged; ++iteration) {
+        std::fill(residual.begin(), residual.end(), std::complex<double>{});
+        residual[analysis.port] = 1.0;
+
+        for (size_t k{}; k < size; ++k) {
+          for (size_t p = analysis.column_starts[k];
+            p < analysis.column_starts[k + 1]; ++p) {
+            size_t row = analysis.rows[p];
+            residual[row] -= space.values[p] * refined[k];
+            if (row != k) {
+              residual[k] -= space.values[p] * refined[row];
+            }
+          }
+        }
+
+        solve_factored(analysis, space, residual, 0);
+        for (size_t j{}; j < size; ++j) {
+          refined[j] += residual[j];
+        }
+
+        converged = largest(residual) <= 1e-13 * largest(refined);
+      }
+
+      if (!converged || !std::isfinite(largest(refined))) {
+        std::fill(work.begin(), work.end(), std::complex<double>{});
+        throw std::runtime_error{"Nodal matrix is singular at "
+          + std::to_string(freq) + " Hz (no unique port voltage, e.g. "
+          "an LC tank across the port at its resonance)."};
+      }
+      solution[analysis.port] = refined[analysis.port];
+    }
+
+    std::complex<double> result = solution[analysis.port];
+
+    // Work is all zero at the start of the next factorisation:
+    std::fill(solution.begin(), solution.end(), std::complex<double>{});
+    return result;
+  }
+
+  // Splits count points into one block per thread, each block with its own
+  // workspace calling evaluate(parts, space, index):
+  // (components are shared, evaluate() doesn't change them)
+  template <class F> std::vector<std::complex<double>> run_blocks(
+    const nodal_analysis &analysis, const std::vector<nodal_element> &elements,
+    const size_t &count, size_t threads, F evaluate)
+  {
+    std::vector<std::complex<double>> results(count);
+
+    if (threads == 0) {
+      threads = get_thread_count();
+    }
+    size_t blocks = std::max<size_t>(1, std::min(threads, count));
+
+    parallel_for(blocks, [&](const size_t &block) {
+      std::vector<const component *> parts;
+      parts.reserve(elements.size());
+
+      for (const auto &elem : elements) {
+        parts.push_back(elem.part.get());
+      }
+
+      nodal_workspace space{analysis};
+
+      size_t begin = (count * block) / blocks;
+      size_t end = (count * (block + 1)) / blocks;
+
+      for (size_t i{begin}; i < end; ++i) {
+        results[i] = evaluate(parts, space, i);
+      }
+    }, blocks);
+
+    return results;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Constructors:
+//------------------------------------------------------------------------------
+
+nodal_circuit::nodal_circuit(const size_t &nodes, const size_t &port_a,
+  const size_t &port_b)
+  : node_count{nodes}, port_a{port_a}, port_b{port_b}
+{
+  if (port_a >= nodes || port_b >= nodes) {
+    throw std::out_of_range{"Port node number out of range."};
+  }
+  if (port_a == port_b) {
+    throw std::invalid_argument{"Ports must be two different nodes."};
+  }
+}
+
+nodal_circuit::nodal_circuit(const nodal_circuit &nodal)
+  : node_count{nodal.node_count}, port_a{nodal.port_a},
+    port_b{nodal.port_b}, analysis{nodal.analysis}
+{
+  elements.reserve(nodal.elements.size());
+  for (const auto &elem : nodal.elements) {
+    elements.push_back(nodal_element{
+      elem.node_a, elem.node_b, elem.part->clone()});
+  }
+}
+
+nodal_circuit &nodal_circuit::operator=(const nodal_circuit &nodal)
+{
+  if (&nodal != this) {
+    nodal_circuit copy{nodal};
+    *this = std::move(copy);
+  }
+  return *this;
+}
+
+nodal_circuit::~nodal_circuit() {}
+
+//------------------------------------------------------------------------------
+
+size_t nodal_circuit::add_node()
+{
+  analysis.reset();
+  return node_count++;
+}
+
+size_t nodal_circuit::add_element(const size_t &node_a, const size_t &node_b,
+  const std::shared_ptr<component> &part)
+{
+  if (node_a >= node_count || node_b >= node_count) {
+    throw std::out_of_range{"Node number out of range."};
+  }
+  if (!part) {
+    throw std::invalid_argument{"Element needs a component."};
+  }
+
+  analysis.reset();
+  elements.push_back(nodal_element{node_a, node_b, part});
+  return elements.size() - 1;
+}
+
+size_t nodal_circuit::get_node_count() const
+{
+  return node_count;
+}
+
+size_t nodal_circuit::get_element_count() const
+{
+  return elements.size();
+}
+
+const nodal_element &nodal_circuit::get_element(const size_t &index) const
+{
+  if (index >= elements.size()) {
+    throw std::out_of_range{"Element index out of range."};
+  }
+  return elements[index];
+}
+
+void nodal_circuit::set_value(const size_t &index, const double &value)
+{
+  if (index >= elements.size()) {
+    throw std::out_of_range{"Element index out of range."};
+  }
+
+  elements[index].part->set_value(value);
+}
+
+//------------------------------------------------------------------------------
+// Evaluation:
+//------------------------------------------------------------------------------
+
+const nodal_analysis &nodal_circuit::get_analysis()
+{
+  if (!analysis) {
+    analysis = std::make_shared<const nodal_analysis>(
+      node_count, port_a, port_b, elements);
+  }
+  return *analysis;
+}
+
+std::complex<double> nodal_circuit::get_impedance(const double &freq)
+{
+  const nodal_analysis &current = get_analysis();
+  nodal_workspace space{current};
+
+  std::vector<const component *> parts;
+  parts.reserve(elements.size());
+  for (const auto &elem : elements) {
+    parts.push_back(elem.part.get());
+  }
+
+  return solve_port(current, parts, freq, space);
+}
+
+std::vector<std::complex<double>> nodal_circuit::sweep(
+  const std::vector<double> &frequencies, const size_t &threads)
+{
+  const nodal_analysis &current = get_analysis();
+
+  return run_blocks(current, elements, frequencies.size(), threads,
+    [&](std::vector<const component *> &parts, nodal_workspace &space,
+      const size_t &i) {
+      return solve_port(current, parts, frequencies[i], space);
+    });
+}
+
+std::vector<std::complex<double>> nodal_circuit::sweep_value(
+  const size_t &index, const std::vector<double> &values, const double &freq,
+  const size_t &threads)
+{
+  if (index >= elements.size()) {
+    throw std::out_of_range{"Element index out of range."};
+  }
+
+  const nodal_analysis &current = get_analysis();
+
+  return run_blocks(current, elements, values.size(), threads,
+    [&](std::vector<const component *> &parts, nodal_workspace &space,
+      const size_t &i) {
+      // Only the changed component is copied:
+      std::unique_ptr<component> varied = elements[index].part->clone();
+      varied->set_value(values[i]);
+
+      parts[index] = varied.get();
+      std::complex<double> result = solve_port(current, parts, freq, space);
+      parts[index] = elements[index].part.get();
+
+      return result;
+    });
+}
+
+//------------------------------------------------------------------------------
+
+size_t nodal_circuit::get_unknown_count()
+{
+  return get_analysis().size;
+}
+
+size_t nodal_circuit::get_factor_size()
+{
+  return get_analysis().factor_rows.size();
+}
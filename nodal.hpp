@@ -0,0 +1,117 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Nodal analysis (any two terminal network, including bridges):
+//------------------------------------------------------------------------------
+
+#ifndef nodal_hpp
+#define nodal_hpp
+
+#include "base_component.hpp"
+
+#include <complex>
+#include <memory>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// The impedance between the ports comes from solving Y v = i, where Y is the
+// nodal admittance matrix with port_b as ground and 1 A injected at port_a.
+//
+// Y only changes value with frequency (or component values), never shape, so
+// the expensive part (fill reducing ordering and the symbolic factorisation)
+// is done once per topology and kept in a shared analysis. Each evaluation
+// then only assembles Y and runs the numeric LDL^T factorisation. Pivots
+// keep that fixed order, so one near zero is perturbed and the solution
+// refined against Y (only a Y that really is singular throws).
+//------------------------------------------------------------------------------
+
+namespace circuits
+{
+  // Ordering and symbolic factorisation of one topology (defined in nodal.cpp):
+  class nodal_analysis;
+
+  struct nodal_element
+  {
+    size_t node_a;
+    size_t node_b;
+    std::shared_ptr<component> part;
+  };
+
+  class nodal_circuit
+  {
+  private:
+    size_t node_count;
+    size_t port_a;
+    size_t port_b;
+
+    std::vector<nodal_element> elements;
+
+    // Null until needed, dropped when the topology changes (copies share it):
+    std::shared_ptr<const nodal_analysis> analysis;
+
+    const nodal_analysis &get_analysis();
+
+  public:
+    // Nodes are numbered 0 to (nodes - 1):
+    nodal_circuit(const size_t &nodes, const size_t &port_a,
+      const size_t &port_b);
+
+    // Copy constructor (deep copies the components, shares the analysis):
+    nodal_circuit(const nodal_circuit &nodal);
+    nodal_circuit &operator=(const nodal_circuit &nodal);
+
+    nodal_circuit(nodal_circuit &&nodal) = default;
+    nodal_circuit &operator=(nodal_circuit &&nodal) = default;
+
+    ~nodal_circuit();
+
+//------------------------------------------------------------------------------
+
+    // Adds a new node, returning its number:
+    size_t add_node();
+
+    // Adds a component between two nodes, returning its element number:
+    size_t add_element(const size_t &node_a, const size_t &node_b,
+      const std::shared_ptr<component> &part);
+
+    size_t get_node_count() const;
+    size_t get_element_count() const;
+    const nodal_element &get_element(const size_t &index) const;
+
+    // Changes a component value (keeps the analysis, topology is the same):
+    void set_value(const size_t &index, const double &value);
+
+//------------------------------------------------------------------------------
+
+    // Impedance between the ports at freq (Hz):
+    // (throws std::runtime_error if Y is singular at that frequency)
+    std::complex<double> get_impedance(const double &freq);
+
+    // Impedance at every frequency, frequencies are split across threads
+    // (0 = one per core), all sharing the components (through evaluate()):
+    std::vector<std::complex<double>> sweep(
+      const std::vector<double> &frequencies, const size_t &threads = 0);
+
+    // Impedance at freq for each value of one component (others unchanged):
+    std::vector<std::complex<double>> sweep_value(const size_t &index,
+      const std::vector<double> &values, const double &freq,
+      const size_t &threads = 0);
+
+//------------------------------------------------------------------------------
+
+    // Size of the analysis (builds it if needed):
+
+    // Unknown node voltages (nodes connected to the ports, less ground):
+    size_t get_unknown_count();
+
+    // Non zeros in the factor L (fill in included):
+    size_t get_factor_size();
+  };
+}
+
+//------------------------------------------------------------------------------
+#endif
+//------------------------------------------------------------------------------
@@ -0,0 +1,248 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Thermal (Johnson) noise at the circuit's terminals:
+//------------------------------------------------------------------------------
+
+#include "noise.hpp"
+#include "impedance_tree.hpp"
+#include "parallel.hpp"
+
+using namespace circuits;
+
+//------------------------------------------------------------------------------
+// Helper functions (only used in this file):
+//------------------------------------------------------------------------------
+
+namespace
+{
+  // Adaptive Simpson limits (an interval is halved at most max_depth times):
+  const int max_depth = 30;
+  const size_t initial_intervals = 8;
+  const size_t max_evaluations = 1000000;
+
+  void check_temperature(const double &temperature)
+  {
+    if (temperature < 0.0) {
+      throw std::out_of_range{"Cannot have negative temperature."};
+    }
+  }
+
+  // Calls add(index, component, share) for every component, returning the
+  // total output noise (V^2/Hz):
+  template <class F> double noise_shares(const circuit &circ,
+    const double &freq, const double &temperature, F add)
+  {
+    impedance_tree tree = build_impedance_tree(circ, freq);
+    double scale = 4 * boltzmann_constant * temperature;
+    double total{};
+
+    // 1 A in at the terminals, nested circuits are counted by their parts
+    // (ideal C and L skipped, rounding would leave them +/- 1e-30 or so):
+    propagate_current(circ, tree, 1.0, [&](const size_t &index,
+      const component *part, const std::complex<double> &voltage,
+      const std::complex<double> &current) {
+      double share{};
+      component_kind kind = part->get_kind();
+
+      if (kind != component_kind::circuit && kind != component_kind::capacitor
+        && kind != component_kind::inductor) {
+        share = scale * (voltage * std::conj(current)).real();
+      }
+      total += share;
+      add(index, part, share);
+    });
+
+    return total;
+  }
+
+//------------------------------------------------------------------------------
+
+  struct interval
+  {
+    // Ends in log frequency, with the integrand at the ends and middle:
+    double a;
+    double b;
+    double fa;
+    double fm;
+    double fb;
+
+    // Simpson's rule over the whole interval:
+    double whole;
+    int depth;
+  };
+
+  double simpson(const double &a, const double &b, const double &fa,
+    const double &fm, const double &fb)
+  {
+    return ((b - a) / 6) * (fa + (4 * fm) + fb);
+  }
+}
+
+//------------------------------------------------------------------------------
+
+noise_density circuits::find_noise_density(const circuit &circ,
+  const double &freq, const double &temperature)
+{
+  check_temperature(temperature);
+
+  noise_density density;
+  density.frequency = freq;
+
+  density.total = noise_shares(circ, freq, temperature,
+    [&](const size_t &, const component *part, const double &share) {
+    density.components.push_back(part);
+    density.contributions.push_back(share);
+  });
+
+  return density;
+}
+
+//------------------------------------------------------------------------------
+
+std::vector<double> circuits::sweep_noise_density(const circuit &circ,
+  const std::vector<double> &frequencies, const double &temperature,
+  const size_t &threads)
+{
+  check_temperature(temperature);
+
+  std::vector<double> densities(frequencies.size());
+
+  parallel_for(frequencies.size(), [&](const size_t &i) {
+    densities[i] = noise_shares(circ, frequencies[i], temperature,
+      [](const size_t &, const component *, const double &) {});
+  }, threads);
+
+  return densities;
+}
+
+//------------------------------------------------------------------------------
+
+noise_integral circuits::integrate_noise(const circuit &circ,
+  const double &f_min, const double &f_max, const double &temperature,
+  const double &relative_tolerance, const size_t &threads)
+{
+  if (f_min <= 0.0) {
+    throw std::out_of_range{"Minimum frequency must be above 0 Hz."};
+  }
+
+  if (f_max <= f_min) {
+    throw std::out_of_range{"Maximum frequency must be above the minimum."};
+  }
+
+  if (relative_tolerance <= 0.0) {
+    throw std::out_of_range{"Tolerance must be above 0."};
+  }
+
+  check_temperature(temperature);
+
+  double u_min = std::log(f_min);
+  double u_max = std::log(f_max);
+  double width = u_max - u_min;
+
+  noise_integral result{};
+  result.converged = true;
+
+  // Density x f at each u = ln f (so the integral over u is over f):
+  auto integrand = [&](const std::vector<double> &us) {
+    std::vector<double> frequencies(us.size());
+    for (size_t i{}; i < us.size(); ++i) {
+      frequencies[i] = std::exp(us[i]);
+    }
+
+    std::vector<double> values = sweep_noise_density(circ, frequencies,
+      temperature, threads);
+    for (size_t i{}; i < us.size(); ++i) {
+      values[i] *= frequencies[i];
+    }
+
+    result.evaluations += us.size();
+    return values;
+  };
+
+  // Equal starting intervals (so a narrow peak isn't missed by one rule):
+  std::vector<double> nodes(2 * initial_intervals + 1);
+  for (size_t k{}; k < nodes.size(); ++k) {
+    nodes[k] = u_min + ((width * k) / (2 * initial_intervals));
+  }
+  nodes.back() = u_max;
+
+  std::vector<double> values = integrand(nodes);
+  std::vector<interval> pending;
+
+  for (size_t i{}; i < initial_intervals; ++i) {
+    interval part{nodes[2 * i], nodes[(2 * i) + 2], values[2 * i],
+      values[(2 * i) + 1], values[(2 * i) + 2], 0.0, 0};
+    part.whole = simpson(part.a, part.b, part.fa, part.fm, part.fb);
+    pending.push_back(part);
+  }
+
+  double accepted{};
+
+  while (!pending.empty()) {
+    // Tolerance of each interval is its share (by width) of the total's:
+    double estimate = accepted;
+    for (const auto &part : pending) {
+      estimate += part.whole;
+    }
+
+    if (result.evaluations + (2 * pending.size()) > max_evaluations) {
+      accepted = estimate;
+      result.converged = false;
+      break;
+    }
+
+    // Quarter points of every interval, evaluated together:
+    std::vector<double> quarters;
+    quarters.reserve(2 * pending.size());
+    for (const auto &part : pending) {
+      double middle = (part.a + part.b) / 2;
+      quarters.push_back((part.a + middle) / 2);
+      quarters.push_back((middle + part.b) / 2);
+    }
+
+    std::vector<double> quarter_values = integrand(quarters);
+    std::vector<interval> next;
+
+    for (size_t i{}; i < pending.size(); ++i) {
+      const interval &part = pending[i];
+      double middle = (part.a + part.b) / 2;
+      double f_left = quarter_values[2 * i];
+      double f_right = quarter_values[(2 * i) + 1];
+
+      double left = simpson(part.a, middle, part.fa, f_left, part.fm);
+      double right = simpson(middle, part.b, part.fm, f_right, part.fb);
+      double difference = (left + right) - part.whole;
+
+      double tolerance = relative_tolerance * std::abs(estimate)
+        * ((part.b - part.a) / width);
+
+      if (std::abs(difference) <= 15 * tolerance) {
+        // Richardson extrapolation of the two rules:
+        accepted += left + right + (difference / 15);
+
+      } else if (part.depth + 1 >= max_depth) {
+        accepted += left + right;
+        result.converged = false;
+
+      } else {
+        next.push_back(interval{part.a, middle, part.fa, f_left, part.fm,
+          left, part.depth + 1});
+        next.push_back(interval{middle, part.b, part.fm, f_right, part.fb,
+          right, part.depth + 1});
+      }
+    }
+
+    pending.swap(next);
+  }
+
+  result.mean_square = accepted;
+  result.rms = std::sqrt(std::max(0.0, accepted));
+
+  return result;
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,78 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Thermal (Johnson) noise at the circuit's terminals:
+//------------------------------------------------------------------------------
+
+#ifndef noise_hpp
+#define noise_hpp
+
+#include "circuit.hpp"
+
+//------------------------------------------------------------------------------
+// Every component's resistance makes noise 4kT Re(z) (V^2/Hz), as a voltage
+// source in series with it. Its transfer to the terminals (open circuit) is,
+// by reciprocity, the current through it when 1 A flows in at the terminals,
+// so its share of the output is 4kT Re(z) |i|^2 = 4kT x (power it dissipates
+// with 1 A in). The shares are found in one pass (as find_branch_states()),
+// and add up to 4kT Re(Z) of the whole circuit. Ideal capacitors and
+// inductors make none. Nested circuits are split into their components.
+//------------------------------------------------------------------------------
+
+namespace circuits
+{
+  // Boltzmann constant (J/K) and standard noise temperature (K):
+  const double boltzmann_constant = 1.380649e-23;
+  const double reference_temperature = 290.0;
+
+  struct noise_density
+  {
+    double frequency;
+
+    // Every component in depth first order (as fault_table), with its
+    // share of the output (V^2/Hz, zero for nested circuits themselves):
+    std::vector<const component *> components;
+    std::vector<double> contributions;
+
+    // Output noise spectral density (V^2/Hz):
+    double total;
+  };
+
+  struct noise_integral
+  {
+    // Integral of the density over the band (V^2) and its square root (V):
+    double mean_square;
+    double rms;
+
+    // Frequencies evaluated, and false if an interval hit the depth limit:
+    size_t evaluations;
+    bool converged;
+  };
+
+//------------------------------------------------------------------------------
+
+  // Output noise and each component's share at freq (Hz), temperature in K:
+  noise_density find_noise_density(const circuit &circ, const double &freq,
+    const double &temperature = reference_temperature);
+
+  // Output noise at each frequency (V^2/Hz), split across threads (0 = one
+  // per core):
+  std::vector<double> sweep_noise_density(const circuit &circ,
+    const std::vector<double> &frequencies,
+    const double &temperature = reference_temperature,
+    const size_t &threads = 0);
+
+  // RMS output noise over f_min to f_max (Hz) by adaptive Simpson in log
+  // frequency. Intervals are refined a level at a time, each level's new
+  // frequencies evaluated together by sweep_noise_density():
+  noise_integral integrate_noise(const circuit &circ, const double &f_min,
+    const double &f_max, const double &temperature = reference_temperature,
+    const double &relative_tolerance = 1e-6, const size_t &threads = 0);
+}
+
+//------------------------------------------------------------------------------
+#endif
+//------------------------------------------------------------------------------
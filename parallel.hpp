@@ -0,0 +1,226 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Helper for running independent jobs across threads:
+//------------------------------------------------------------------------------
+
+#ifndef parallel_hpp
+#define parallel_hpp
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <exception>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+
+//------------------------------------------------------------------------------
+
+namespace circuits
+{
+  // Number of worker threads to use (at least one):
+  inline size_t get_thread_count()
+  {
+    size_t hardware_threads = std::thread::hardware_concurrency();
+    return std::max<size_t>(1, hardware_threads);
+  }
+
+  // Calls job(index) for every index in [0, count) using a pool of threads:
+  // (each thread takes the next free index, so uneven jobs balance out)
+  template <class F> void parallel_for(
+    const size_t &count, F job, size_t threads = 0)
+  {
+    if (threads == 0) {
+      threads = get_thread_count();
+    }
+    threads = std::min(threads, count);
+
+    // Not worth starting threads for a single job:
+    if (threads <= 1) {
+      for (size_t i{}; i < count; ++i) {
+        job(i);
+      }
+      return;
+    }
+
+    std::atomic<size_t> next_index{0};
+
+    // First exception thrown by a job is rethrown on the calling thread:
+    std::exception_ptr first_error;
+    std::mutex error_mutex;
+
+    auto worker = [&]() {
+      size_t index{};
+      while ((index = next_index.fetch_add(1)) < count) {
+        try {
+          job(index);
+        }
+        catch (...) {
+          std::lock_guard<std::mutex> lock{error_mutex};
+          if (!first_error) {
+            first_error = std::current_exception();
+          }
+        }
+      }
+    };
+
+    std::vector<std::thread> pool;
+    for (size_t i{1}; i < threads; ++i) {
+      pool.emplace_back(worker);
+    }
+
+    // Calling thread does its share too:
+    worker();
+
+    for (auto &thread : pool) {
+      thread.join();
+    }
+
+    if (first_error) {
+      std::rethrow_exception(first_error);
+    }
+  }
+
+//------------------------------------------------------------------------------
+
+  // Same as parallel_for, but the threads are started once and reused:
+  // (for code running many small batches, e.g. the evaluation server)
+  class thread_pool
+  {
+  private:
+    std::vector<std::thread> workers;
+
+    std::mutex pool_mutex;
+    std::condition_variable work_ready;
+    std::condition_variable work_done;
+
+    // Current run, changed only while the workers are idle:
+    std::function<void(const size_t &)> job;
+    size_t job_count = 0;
+    std::atomic<size_t> next_index{0};
+    std::exception_ptr first_error;
+
+    size_t generation = 0;
+    size_t busy_workers = 0;
+    bool stopping = false;
+
+    // Only one run at a time:
+    std::mutex run_mutex;
+
+    void take_jobs()
+    {
+      size_t index{};
+      while ((index = next_index.fetch_add(1)) < job_count) {
+        try {
+          job(index);
+        }
+        catch (...) {
+          std::lock_guard<std::mutex> lock{pool_mutex};
+          if (!first_error) {
+            first_error = std::current_exception();
+          }
+        }
+      }
+    }
+
+    void worker_loop()
+    {
+      size_t seen_generation{};
+
+      while (true) {
+        {
+          std::unique_lock<std::mutex> lock{pool_mutex};
+          work_ready.wait(lock, [&]() {
+            return stopping || generation != seen_generation;
+          });
+
+          if (stopping) {
+            return;
+          }
+          seen_generation = generation;
+        }
+
+        take_jobs();
+
+        std::lock_guard<std::mutex> lock{pool_mutex};
+        if (--busy_workers == 0) {
+          work_done.notify_all();
+        }
+      }
+    }
+
+  public:
+    // Calling thread of run() also works, so threads - 1 are started:
+    thread_pool(size_t threads = 0)
+    {
+      if (threads == 0) {
+        threads = get_thread_count();
+      }
+
+      for (size_t i{1}; i < threads; ++i) {
+        workers.emplace_back([this]() { worker_loop(); });
+      }
+    }
+
+    ~thread_pool()
+    {
+      {
+        std::lock_guard<std::mutex> lock{pool_mutex};
+        stopping = true;
+      }
+      work_ready.notify_all();
+
+      for (auto &worker : workers) {
+        worker.join();
+      }
+    }
+
+    thread_pool(const thread_pool &) = delete;
+    thread_pool &operator=(const thread_pool &) = delete;
+
+    size_t get_size() const
+    {
+      return workers.size() + 1;
+    }
+
+    // Calls job(index) for every index in [0, count), returning when done:
+    template <class F> void run(const size_t &count, F func)
+    {
+      if (count == 0) {
+        return;
+      }
+
+      std::lock_guard<std::mutex> run_lock{run_mutex};
+
+      {
+        std::lock_guard<std::mutex> lock{pool_mutex};
+        job = func;
+        job_count = count;
+        next_index = 0;
+        first_error = nullptr;
+        busy_workers = workers.size();
+        ++generation;
+      }
+      work_ready.notify_all();
+
+      take_jobs();
+
+      std::unique_lock<std::mutex> lock{pool_mutex};
+      work_done.wait(lock, [&]() { return busy_workers == 0; });
+      job = nullptr;
+
+      if (first_error) {
+        std::rethrow_exception(first_error);
+      }
+    }
+  };
+}
+
+//------------------------------------------------------------------------------
+#endif
+//------------------------------------------------------------------------------
@@ -0,0 +1,1048 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Rational function (pole / zero) form of a circuit's impedance:
+//------------------------------------------------------------------------------
+
+#include "rational_function.hpp"
+#include "frozen_circuit.hpp"
+#include "resistors.hpp"
+#include "capacitors.hpp"
+#include "inductors.hpp"
+
+#include <limits>
+
+//------------------------------------------------------------------------------
+// Root finding:
+//------------------------------------------------------------------------------
+
+std::vector<std::complex<double>> circuits::find_roots(
+  const std::vector<std::complex<double>> &coeffs)
+{
+  // Ignore zero coefficients at the top (they don't change the degree):
+  size_t top = coeffs.size();
+  while (top > 0 && coeffs[top - 1] == 0.0) {
+    --top;
+  }
+
+  std::vector<std::complex<double>> roots;
+  if (top <= 1) {
+    return roots;
+  }
+
+  // Exact roots at x = 0 for each zero coefficient at the bottom:
+  size_t bottom{};
+  while (coeffs[bottom] == 0.0) {
+    roots.push_back(0.0);
+    ++bottom;
+  }
+
+  // Monic polynomial for the remaining roots:
+  std::vector<std::complex<double>> monic(
+    coeffs.begin() + bottom, coeffs.begin() + top);
+  std::complex<double> leading = monic.back();
+  for (auto &coeff : monic) {
+    coeff /= leading;
+  }
+
+  size_t degree = monic.size() - 1;
+  if (degree == 0) {
+    return roots;
+  }
+
+  // Start on a circle with the geometric mean radius of the roots:
+  double radius = std::pow(std::abs(monic[0]), 1.0 / degree);
+  std::vector<std::complex<double>> guesses(degree);
+  for (size_t i{}; i < degree; ++i) {
+    double angle = (2 * M_PI * i / degree) + 0.4;
+    guesses[i] = std::polar(radius, angle);
+  }
+
+  const size_t max_iterations = 500;
+  for (size_t iteration{}; iteration < max_iterations; ++iteration) {
+    double largest_step{};
+
+    for (size_t i{}; i < degree; ++i) {
+
+      // p(z) and p'(z) together by Horner:
+      std::complex<double> value = monic[degree];
+      std::complex<double> slope{};
+      for (size_t k = degree; k-- > 0;) {
+        slope = slope * guesses[i] + value;
+        value = value * guesses[i] + monic[k];
+      }
+
+      if (value == 0.0) {
+        continue;
+      }
+
+      std::complex<double> ratio = value / slope;
+
+      std::complex<double> repulsion{};
+      for (size_t j{}; j < degree; ++j) {
+        if (j != i) {
+          repulsion += 1.0 / (guesses[i] - guesses[j]);
+        }
+      }
+
+      std::complex<double> step = ratio / (1.0 - ratio * repulsion);
+      if (!std::isfinite(step.real()) || !std::isfinite(step.imag())) {
+        continue;
+      }
+
+      guesses[i] -= step;
+      largest_step = std::max(
+        largest_step, std::abs(step) / std::max(1.0, std::abs(guesses[i])));
+    }
+
+    if (largest_step <= 1e-15) {
+      break;
+    }
+  }
+
+  roots.insert(roots.end(), guesses.begin(), guesses.end());
+  return roots;
+}
+
+//------------------------------------------------------------------------------
+
+// Aberth-Ehrlich iteration using p'/p = f'/f + sum(1 / (s - known)):
+std::vector<std::complex<double>> circuits::find_function_roots(
+  const complex_function &func,
+  const std::vector<std::complex<double>> &known,
+  std::vector<std::complex<double>> guesses)
+{
+  const size_t max_iterations = 500;
+
+  for (size_t iteration{}; iteration < max_iterations; ++iteration) {
+    double largest_step{};
+
+    for (size_t i{}; i < guesses.size(); ++i) {
+      std::complex<double> value{}, slope{};
+      func(guesses[i], value, slope);
+
+      std::complex<double> log_slope = slope / value;
+      for (const auto &root : known) {
+        log_slope += 1.0 / (guesses[i] - root);
+      }
+
+      std::complex<double> ratio = 1.0 / log_slope;
+
+      std::complex<double> repulsion{};
+      for (size_t j{}; j < guesses.size(); ++j) {
+        if (j != i) {
+          repulsion += 1.0 / (guesses[i] - guesses[j]);
+        }
+      }
+
+      std::complex<double> step = ratio / (1.0 - ratio * repulsion);
+      if (!std::isfinite(step.real()) || !std::isfinite(step.imag())) {
+        continue;
+      }
+
+      guesses[i] -= step;
+      largest_step = std::max(
+        largest_step, std::abs(step) / std::max(1.0, std::abs(guesses[i])));
+    }
+
+    if (largest_step <= 1e-15) {
+      break;
+    }
+  }
+
+  return guesses;
+}
+
+//------------------------------------------------------------------------------
+// Polynomial Class:
+//------------------------------------------------------------------------------
+
+// Default constructor:
+polynomial::polynomial() : coeffs{0.0} {}
+
+// Parameterised constructor:
+polynomial::polynomial(const std::vector<double> &coefficients)
+  : coeffs{coefficients}
+{
+  // Removes zero coefficients at the top so degree is correct:
+  while (coeffs.size() > 1 && coeffs.back() == 0.0) {
+    coeffs.pop_back();
+  }
+
+  if (coeffs.size() == 0) {
+    coeffs.push_back(0.0);
+  }
+}
+
+//------------------------------------------------------------------------------
+
+size_t polynomial::get_degree() const
+{
+  return coeffs.size() - 1;
+}
+
+const std::vector<double> &polynomial::get_coefficients() const
+{
+  return coeffs;
+}
+
+std::complex<double> polynomial::evaluate(const std::complex<double> &s) const
+{
+  std::complex<double> value{};
+  for (size_t k = coeffs.size(); k-- > 0;) {
+    value = value * s + coeffs[k];
+  }
+
+  return value;
+}
+
+polynomial polynomial::derivative() const
+{
+  std::vector<double> slope;
+  for (size_t k{1}; k < coeffs.size(); ++k) {
+    slope.push_back(k * coeffs[k]);
+  }
+
+  return polynomial{slope};
+}
+
+std::vector<std::complex<double>> polynomial::get_roots() const
+{
+  return find_roots(
+    std::vector<std::complex<double>>(coeffs.begin(), coeffs.end()));
+}
+
+//------------------------------------------------------------------------------
+
+bool polynomial::is_close(const polynomial &poly) const
+{
+  if (coeffs.size() != poly.coeffs.size()) {
+    return false;
+  }
+
+  double largest{};
+  for (const auto &coeff : coeffs) {
+    largest = std::max(largest, std::abs(coeff));
+  }
+
+  for (size_t i{}; i < coeffs.size(); ++i) {
+    if (std::abs(coeffs[i] - poly.coeffs[i]) > (1e-12 * largest)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+size_t polynomial::get_lowest_order() const
+{
+  size_t order{};
+  while (order < get_degree() && coeffs[order] == 0.0) {
+    ++order;
+  }
+
+  return order;
+}
+
+polynomial polynomial::divide_by_s(const size_t &power) const
+{
+  if (power > get_lowest_order()) {
+    throw std::invalid_argument{"Polynomial is not divisible by this power."};
+  }
+
+  return polynomial{std::vector<double>(coeffs.begin() + power, coeffs.end())};
+}
+
+//------------------------------------------------------------------------------
+
+polynomial polynomial::operator+(const polynomial &poly) const
+{
+  std::vector<double> sum(std::max(coeffs.size(), poly.coeffs.size()));
+
+  for (size_t i{}; i < coeffs.size(); ++i) {
+    sum[i] += coeffs[i];
+  }
+
+  for (size_t i{}; i < poly.coeffs.size(); ++i) {
+    sum[i] += poly.coeffs[i];
+  }
+
+  return polynomial{sum};
+}
+
+polynomial polynomial::operator*(const polynomial &poly) const
+{
+  std::vector<double> product(coeffs.size() + poly.coeffs.size() - 1);
+
+  for (size_t i{}; i < coeffs.size(); ++i) {
+    for (size_t j{}; j < poly.coeffs.size(); ++j) {
+      product[i + j] += coeffs[i] * poly.coeffs[j];
+    }
+  }
+
+  return polynomial{product};
+}
+
+//------------------------------------------------------------------------------
+// Rational Function Class:
+//------------------------------------------------------------------------------
+
+// Default constructor (Z = 0):
+rational_function::rational_function()
+  : numerator{}, denominator{{1.0}}, omega_scale{1.0}, impedance_scale{1.0}
+{
+  set_factored_form();
+}
+
+// Parameterised constructor:
+rational_function::rational_function(const polynomial &num,
+  const polynomial &den, const double &omega, const double &z_scale)
+  : numerator{num}, denominator{den}, omega_scale{omega},
+  impedance_scale{z_scale}
+{
+  if (omega <= 0.0 || z_scale <= 0.0) {
+    throw std::out_of_range{"Rational function scales must be above 0."};
+  }
+
+  set_factored_form();
+}
+
+// Parameterised constructor with an already known factored form:
+rational_function::rational_function(const polynomial &num,
+  const polynomial &den, const double &omega, const double &z_scale,
+  const std::complex<double> &factored_gain,
+  const std::vector<std::complex<double>> &factored_zeros,
+  const std::vector<std::complex<double>> &factored_poles)
+  : numerator{num}, denominator{den}, omega_scale{omega},
+  impedance_scale{z_scale}, gain{factored_gain}, zeros{factored_zeros},
+  poles{factored_poles}
+{
+  if (omega <= 0.0 || z_scale <= 0.0) {
+    throw std::out_of_range{"Rational function scales must be above 0."};
+  }
+}
+
+//------------------------------------------------------------------------------
+
+std::complex<double> rational_function::evaluate(const double &freq) const
+{
+  // Normalised s' = j 2 pi f / omega_scale:
+  std::complex<double> s{0.0, (2 * M_PI * freq / omega_scale)};
+
+  // Low orders: plain Horner on N and D:
+  size_t expanded_order = std::max(
+    numerator.get_degree(), denominator.get_degree());
+
+  if (expanded_order <= max_horner_order) {
+    return impedance_scale * numerator.evaluate(s) / denominator.evaluate(s);
+  }
+
+  // High orders: pair up factors so the running product stays near 1:
+  std::complex<double> value = gain;
+  size_t pairs = std::min(zeros.size(), poles.size());
+
+  for (size_t i{}; i < pairs; ++i) {
+    value *= (s - zeros[i]) / (s - poles[i]);
+  }
+
+  for (size_t i = pairs; i < zeros.size(); ++i) {
+    value *= (s - zeros[i]);
+  }
+
+  for (size_t i = pairs; i < poles.size(); ++i) {
+    value /= (s - poles[i]);
+  }
+
+  return impedance_scale * value;
+}
+
+std::vector<std::complex<double>> rational_function::evaluate(
+  const std::vector<double> &freqs) const
+{
+  std::vector<std::complex<double>> impedances;
+  impedances.reserve(freqs.size());
+
+  for (const auto &freq : freqs) {
+    impedances.push_back(evaluate(freq));
+  }
+
+  return impedances;
+}
+
+// dZ/df = dZ/ds' * j 2 pi / omega_scale:
+std::complex<double> rational_function::evaluate_derivative(
+  const double &freq) const
+{
+  std::complex<double> s{0.0, (2 * M_PI * freq / omega_scale)};
+  std::complex<double> ds_df{0.0, (2 * M_PI / omega_scale)};
+
+  size_t expanded_order = std::max(
+    numerator.get_degree(), denominator.get_degree());
+
+  if (expanded_order <= max_horner_order) {
+    std::complex<double> num = numerator.evaluate(s);
+    std::complex<double> den = denominator.evaluate(s);
+    std::complex<double> d_num = numerator.derivative().evaluate(s);
+    std::complex<double> d_den = denominator.derivative().evaluate(s);
+
+    return impedance_scale * ds_df
+      * ((d_num * den) - (num * d_den)) / (den * den);
+  }
+
+  // Z'/Z = sum(1 / (s - zeros)) - sum(1 / (s - poles)):
+  std::complex<double> log_slope{};
+  for (const auto &zero : zeros) {
+    log_slope += 1.0 / (s - zero);
+  }
+
+  for (const auto &pole : poles) {
+    log_slope -= 1.0 / (s - pole);
+  }
+
+  return evaluate(freq) * log_slope * ds_df;
+}
+
+//------------------------------------------------------------------------------
+
+size_t rational_function::get_order() const
+{
+  return std::max(zeros.size(), poles.size());
+}
+
+std::vector<std::complex<double>> rational_function::get_poles() const
+{
+  std::vector<std::complex<double>> scaled{poles};
+  for (auto &pole : scaled) {
+    pole *= omega_scale;
+  }
+
+  return scaled;
+}
+
+std::vector<std::complex<double>> rational_function::get_zeros() const
+{
+  std::vector<std::complex<double>> scaled{zeros};
+  for (auto &zero : scaled) {
+    zero *= omega_scale;
+  }
+
+  return scaled;
+}
+
+const polynomial &rational_function::get_numerator() const
+{
+  return numerator;
+}
+
+const polynomial &rational_function::get_denominator() const
+{
+  return denominator;
+}
+
+double rational_function::get_omega_scale() const
+{
+  return omega_scale;
+}
+
+double rational_function::get_impedance_scale() const
+{
+  return impedance_scale;
+}
+
+//------------------------------------------------------------------------------
+// Compiling a circuit:
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+
+namespace
+{
+  using namespace circuits;
+
+  // N / D pair while the circuit is being walked:
+  struct fraction
+  {
+    polynomial num;
+    polynomial den;
+  };
+
+  // One component, a sum of children (series) or a parallel run:
+  enum class node_kind {element, sum, parallel};
+
+  struct compiled_node
+  {
+    node_kind kind;
+
+    // Only used by elements (with derivatives for Newton / Aberth steps):
+    fraction value;
+    fraction slope;
+
+    std::vector<compiled_node> children;
+
+    // Factored form of this node (normalised s'), filled in bottom up:
+    std::vector<std::complex<double>> zeros;
+    std::vector<std::complex<double>> poles;
+
+    // Z grows like s^order_at_infinity for large s:
+    int order_at_infinity;
+  };
+
+  // Values used to pick the normalisation scales:
+  struct value_logs
+  {
+    std::vector<double> resistances;
+    std::vector<double> inductances;
+    std::vector<double> capacitances;
+  };
+
+  void collect_values(const circuit &circ, value_logs &values)
+  {
+    for (const auto &comp : circ.get_components()) {
+      const component *ptr = comp.get();
+
+      if (auto real_resis = dynamic_cast<const real_resistor*>(ptr)) {
+        values.resistances.push_back(real_resis->get_resistance());
+        values.inductances.push_back(real_resis->get_inductance());
+        values.capacitances.push_back(real_resis->get_capacitance());
+
+      } else if (auto real_capac = dynamic_cast<const real_capacitor*>(ptr)) {
+        values.inductances.push_back(real_capac->get_inductance());
+        values.capacitances.push_back(real_capac->get_capacitance());
+
+      } else if (auto real_induc = dynamic_cast<const real_inductor*>(ptr)) {
+        values.inductances.push_back(real_induc->get_inductance());
+        values.capacitances.push_back(real_induc->get_capacitance());
+
+      } else if (auto resis = dynamic_cast<const resistor*>(ptr)) {
+        values.resistances.push_back(resis->get_resistance());
+
+      } else if (auto capac = dynamic_cast<const capacitor*>(ptr)) {
+        values.capacitances.push_back(capac->get_capacitance());
+
+      } else if (auto induc = dynamic_cast<const inductor*>(ptr)) {
+        values.inductances.push_back(induc->get_inductance());
+
+      } else if (auto sub_circ = dynamic_cast<const circuit*>(ptr)) {
+        collect_values(*sub_circ, values);
+
+      } else if (auto frozen = dynamic_cast<const frozen_circuit*>(ptr)) {
+        // As an R, L and C at the scales it was compiled with:
+        if (!frozen->is_table()) {
+          const rational_function &form = frozen->get_rational_function();
+          double z_scale = form.get_impedance_scale();
+          double omega = form.get_omega_scale();
+          values.resistances.push_back(z_scale);
+          values.inductances.push_back(z_scale / omega);
+          values.capacitances.push_back(1.0 / (z_scale * omega));
+        }
+      }
+    }
+  }
+
+  double log_mean(const std::vector<double> &values)
+  {
+    double sum{};
+    for (const auto &value : values) {
+      sum += std::log(value);
+    }
+
+    return sum / values.size();
+  }
+
+//------------------------------------------------------------------------------
+// Building the structure:
+//------------------------------------------------------------------------------
+
+  compiled_node make_element(const fraction &value)
+  {
+    compiled_node node{node_kind::element, value,
+      fraction{value.num.derivative(), value.den.derivative()}, {}, {}, {}, 0};
+
+    return node;
+  }
+
+  compiled_node build_circuit_node(const circuit &circ,
+    const double &omega, const double &z_scale);
+
+  // Z = Z1 N(s / w1) / D(s / w1) of a frozen circuit in this compile's
+  // s' = s / w0 and Z' = Z / Z0, keeping the roots it already found:
+  compiled_node make_frozen_element(const rational_function &form,
+    const double &omega, const double &z_scale)
+  {
+    double ratio = omega / form.get_omega_scale();
+    auto rescale = [&](const polynomial &poly, const double &factor) {
+      std::vector<double> coeffs = poly.get_coefficients();
+      double power = factor;
+      for (auto &coeff : coeffs) {
+        coeff *= power;
+        power *= ratio;
+      }
+      return polynomial{coeffs};
+    };
+
+    compiled_node node = make_element(fraction{
+      rescale(form.get_numerator(), form.get_impedance_scale() / z_scale),
+      rescale(form.get_denominator(), 1.0)});
+
+    node.zeros = form.get_zeros();
+    for (auto &zero : node.zeros) {
+      zero /= omega;
+    }
+    node.poles = form.get_poles();
+    for (auto &pole : node.poles) {
+      pole /= omega;
+    }
+    return node;
+  }
+
+  // Normalised r = R / Z0, l = w0 L / Z0, c = w0 C Z0:
+  compiled_node build_node(const component &comp,
+    const double &omega, const double &z_scale)
+  {
+    const component *ptr = &comp;
+
+    // (R + sL) || C = (r + s'l) / (1 + s'rc + s'^2 lc):
+    auto parallel_model = [&](const double &res, const double &ind,
+      const double &cap) {
+      double r = res / z_scale;
+      double l = omega * ind / z_scale;
+      double c = omega * cap * z_scale;
+      return make_element(
+        fraction{polynomial{{r, l}}, polynomial{{1.0, r * c, l * c}}});
+    };
+
+    if (auto real_resis = dynamic_cast<const real_resistor*>(ptr)) {
+      return parallel_model(real_resis->get_resistance(),
+        real_resis->get_inductance(), real_resis->get_capacitance());
+
+    } else if (auto real_induc = dynamic_cast<const real_inductor*>(ptr)) {
+      return parallel_model(real_induc->get_resistance(),
+        real_induc->get_inductance(), real_induc->get_capacitance());
+
+    } else if (auto real_capac = dynamic_cast<const real_capacitor*>(ptr)) {
+      // R + sL + 1/sC = (1 + s'rc + s'^2 lc) / s'c:
+      double r = real_capac->get_resistance() / z_scale;
+      double l = omega * real_capac->get_inductance() / z_scale;
+      double c = omega * real_capac->get_capacitance() * z_scale;
+      return make_element(
+        fraction{polynomial{{1.0, r * c, l * c}}, polynomial{{0.0, c}}});
+
+    } else if (auto resis = dynamic_cast<const resistor*>(ptr)) {
+      return make_element(fraction{
+        polynomial{{resis->get_resistance() / z_scale}}, polynomial{{1.0}}});
+
+    } else if (auto capac = dynamic_cast<const capacitor*>(ptr)) {
+      double c = omega * capac->get_capacitance() * z_scale;
+      return make_element(
+        fraction{polynomial{{1.0}}, polynomial{{0.0, c}}});
+
+    } else if (auto induc = dynamic_cast<const inductor*>(ptr)) {
+      double l = omega * induc->get_inductance() / z_scale;
+      return make_element(
+        fraction{polynomial{{0.0, l}}, polynomial{{1.0}}});
+
+    } else if (auto sub_circ = dynamic_cast<const circuit*>(ptr)) {
+      return build_circuit_node(*sub_circ, omega, z_scale);
+
+    } else if (auto frozen = dynamic_cast<const frozen_circuit*>(ptr)) {
+      if (frozen->is_table()) {
+        throw std::invalid_argument{"Cannot compile a frozen table (only a "
+          "frozen circuit's rational form)."};
+      }
+      return make_frozen_element(frozen->get_rational_function(), omega,
+        z_scale);
+    }
+
+    throw std::invalid_argument{
+      "Cannot compile component of type " + comp.get_type() + "."};
+  }
+
+  // Circuit = sum of its series components and of each parallel run:
+  // (same runs as circuit::set_impedance)
+  compiled_node build_circuit_node(const circuit &circ,
+    const double &omega, const double &z_scale)
+  {
+    compiled_node sum_node{node_kind::sum, {}, {}, {}, {}, {}, 0};
+
+    // Index of the parallel run currently being filled:
+    bool in_parallel = false;
+    size_t parallel_index{};
+
+    for (const auto &comp : circ.get_components()) {
+      compiled_node child = build_node(*comp, omega, z_scale);
+
+      if (comp->get_connection_type() == 's') {
+        sum_node.children.push_back(child);
+        in_parallel = false;
+
+      } else if (comp->get_connection_type() == 'p') {
+
+        if (!in_parallel) {
+          sum_node.children.push_back(
+            compiled_node{node_kind::parallel, {}, {}, {}, {}, {}, 0});
+          parallel_index = sum_node.children.size() - 1;
+          in_parallel = true;
+        }
+
+        sum_node.children[parallel_index].children.push_back(child);
+      }
+    }
+
+    return sum_node;
+  }
+
+//------------------------------------------------------------------------------
+// Expanded N / D (used for Horner evaluation at low orders):
+//------------------------------------------------------------------------------
+
+  // Sum of two fractions (shares the denominator when they match):
+  fraction add(const fraction &a, const fraction &b)
+  {
+    fraction sum;
+
+    if (a.den.is_close(b.den)) {
+      sum = fraction{a.num + b.num, a.den};
+
+    } else {
+      sum = fraction{(a.num * b.den) + (b.num * a.den), a.den * b.den};
+    }
+
+    // Cancel common factors of s (e.g. from several capacitors):
+    size_t common = std::min(
+      sum.num.get_lowest_order(), sum.den.get_lowest_order());
+
+    if (common > 0) {
+      sum.num = sum.num.divide_by_s(common);
+      sum.den = sum.den.divide_by_s(common);
+    }
+
+    return sum;
+  }
+
+  fraction invert(const fraction &f)
+  {
+    return fraction{f.den, f.num};
+  }
+
+  fraction reduce_node(const compiled_node &node)
+  {
+    if (node.kind == node_kind::element) {
+      return node.value;
+    }
+
+    fraction total{polynomial{}, polynomial{{1.0}}};
+    bool first = true;
+
+    // Parallel runs add admittances, then invert at the end:
+    for (const auto &child : node.children) {
+      fraction term = reduce_node(child);
+      if (node.kind == node_kind::parallel) {
+        term = invert(term);
+      }
+
+      total = first ? term : add(total, term);
+      first = false;
+    }
+
+    if (node.kind == node_kind::parallel) {
+      total = invert(total);
+    }
+
+    return total;
+  }
+
+//------------------------------------------------------------------------------
+// Factored form:
+//------------------------------------------------------------------------------
+
+  // Z and dZ/ds straight from the structure (no expanded polynomials):
+  void evaluate_node(const compiled_node &node, const std::complex<double> &s,
+    std::complex<double> &value, std::complex<double> &slope)
+  {
+    if (node.kind == node_kind::element) {
+      std::complex<double> num = node.value.num.evaluate(s);
+      std::complex<double> den = node.value.den.evaluate(s);
+      std::complex<double> d_num = node.slope.num.evaluate(s);
+      std::complex<double> d_den = node.slope.den.evaluate(s);
+
+      value = num / den;
+      slope = ((d_num * den) - (num * d_den)) / (den * den);
+      return;
+    }
+
+    // Parallel: Y = sum(1/z), dY/ds = -sum(z' / z^2):
+    std::complex<double> sum{}, d_sum{};
+
+    for (const auto &child : node.children) {
+      std::complex<double> child_value{}, child_slope{};
+      evaluate_node(child, s, child_value, child_slope);
+
+      if (node.kind == node_kind::sum) {
+        sum += child_value;
+        d_sum += child_slope;
+
+      } else {
+        sum += 1.0 / child_value;
+        d_sum -= child_slope / (child_value * child_value);
+      }
+    }
+
+    if (node.kind == node_kind::sum) {
+      value = sum;
+      slope = d_sum;
+
+    } else {
+      value = 1.0 / sum;
+      slope = -d_sum / (sum * sum);
+    }
+  }
+
+  // Union of several root lists, keeping the largest multiplicity of each:
+  std::vector<std::complex<double>> merge_roots(
+    const std::vector<const std::vector<std::complex<double>>*> &lists)
+  {
+    std::vector<std::complex<double>> merged;
+
+    for (const auto &list : lists) {
+      std::vector<bool> used(merged.size(), false);
+
+      for (const auto &root : *list) {
+        bool matched = false;
+
+        for (size_t i{}; i < used.size(); ++i) {
+          double scale = std::max(1.0, std::abs(root));
+          if (!used[i] && std::abs(merged[i] - root) <= 1e-12 * scale) {
+            used[i] = true;
+            matched = true;
+            break;
+          }
+        }
+
+        if (!matched) {
+          merged.push_back(root);
+        }
+      }
+    }
+
+    return merged;
+  }
+
+  // Roots of Z (or of Y = 1 / Z) of a node times prod(s - known):
+  std::vector<std::complex<double>> structural_roots(
+    const compiled_node &node, const std::vector<std::complex<double>> &known,
+    const int &count, const bool &of_admittance)
+  {
+    std::vector<std::complex<double>> guesses;
+    if (count <= 0) {
+      return guesses;
+    }
+
+    // Start on a circle at the typical size of the known roots:
+    double log_radius{};
+    size_t nonzero{};
+    for (const auto &root : known) {
+      if (std::abs(root) > 0) {
+        log_radius += std::log(std::abs(root));
+        ++nonzero;
+      }
+    }
+
+    double radius = (nonzero != 0) ? std::exp(log_radius / nonzero) : 1.0;
+    for (int i{}; i < count; ++i) {
+      double angle = (2 * M_PI * i / count) + 0.4;
+      guesses.push_back(std::polar(radius, angle));
+    }
+
+    auto func = [&](const std::complex<double> &s,
+      std::complex<double> &value, std::complex<double> &slope) {
+      evaluate_node(node, s, value, slope);
+
+      if (of_admittance) {
+        slope = -slope / (value * value);
+        value = 1.0 / value;
+      }
+    };
+
+    return find_function_roots(func, known, guesses);
+  }
+
+  // Fills in zeros / poles of each node from the bottom up:
+  // sum: poles are the union of the children's, zeros found by Aberth.
+  // parallel: zeros are the union of the children's, poles found by Aberth.
+  void factor_node(compiled_node &node)
+  {
+    if (node.kind == node_kind::element) {
+      // (a frozen circuit's element already has its roots)
+      if (node.zeros.empty() && node.poles.empty()) {
+        node.zeros = node.value.num.get_roots();
+        node.poles = node.value.den.get_roots();
+      }
+      node.order_at_infinity = int(node.value.num.get_degree())
+        - int(node.value.den.get_degree());
+      return;
+    }
+
+    std::vector<const std::vector<std::complex<double>>*> lists;
+    bool first = true;
+
+    for (auto &child : node.children) {
+      factor_node(child);
+
+      if (node.kind == node_kind::sum) {
+        lists.push_back(&child.poles);
+        node.order_at_infinity = first ? child.order_at_infinity
+          : std::max(node.order_at_infinity, child.order_at_infinity);
+
+      } else {
+        lists.push_back(&child.zeros);
+        node.order_at_infinity = first ? child.order_at_infinity
+          : std::min(node.order_at_infinity, child.order_at_infinity);
+      }
+      first = false;
+    }
+
+    if (node.kind == node_kind::sum) {
+      node.poles = merge_roots(lists);
+      int count = int(node.poles.size()) + node.order_at_infinity;
+      node.zeros = structural_roots(node, node.poles, count, false);
+
+    } else {
+      node.zeros = merge_roots(lists);
+      int count = int(node.zeros.size()) - node.order_at_infinity;
+      node.poles = structural_roots(node, node.zeros, count, true);
+    }
+  }
+
+  // Removes pole / zero pairs that (nearly) coincide:
+  void cancel_common_roots(std::vector<std::complex<double>> &zeros,
+    std::vector<std::complex<double>> &poles)
+  {
+    const double tolerance = 1e-8;
+
+    for (size_t i{}; i < zeros.size();) {
+      bool cancelled = false;
+
+      for (size_t j{}; j < poles.size(); ++j) {
+        double distance = std::abs(zeros[i] - poles[j]);
+
+        if (distance <= tolerance * std::max(1.0, std::abs(poles[j]))) {
+          zeros.erase(zeros.begin() + i);
+          poles.erase(poles.begin() + j);
+          cancelled = true;
+          break;
+        }
+      }
+
+      if (!cancelled) {
+        ++i;
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+
+// Finds poles / zeros and cancels common pairs:
+void rational_function::set_factored_form()
+{
+  zeros = numerator.get_roots();
+  poles = denominator.get_roots();
+
+  cancel_common_roots(zeros, poles);
+
+  gain = numerator.get_coefficients().back()
+    / denominator.get_coefficients().back();
+}
+
+//------------------------------------------------------------------------------
+
+rational_function circuits::compile_circuit(const circuit &circ)
+{
+  value_logs values;
+  collect_values(circ, values);
+
+  // Impedance scale from resistors (or sqrt(L / C) for pure LC circuits):
+  double z_scale = 1.0;
+  if (values.resistances.size() != 0) {
+    z_scale = std::exp(log_mean(values.resistances));
+
+  } else if (values.inductances.size() != 0
+    && values.capacitances.size() != 0) {
+    z_scale = std::exp(0.5 * (log_mean(values.inductances)
+      - log_mean(values.capacitances)));
+  }
+
+  // Frequency scale balances w0 L / Z0 and w0 C Z0 around 1:
+  std::vector<double> omegas;
+  for (const auto &ind : values.inductances) {
+    omegas.push_back(z_scale / ind);
+  }
+
+  for (const auto &cap : values.capacitances) {
+    omegas.push_back(1.0 / (z_scale * cap));
+  }
+
+  double omega = 1.0;
+  if (omegas.size() != 0) {
+    omega = std::exp(log_mean(omegas));
+  }
+
+  compiled_node root_node = build_circuit_node(circ, omega, z_scale);
+
+  // Empty circuit has Z = 0:
+  if (root_node.children.size() == 0) {
+    return rational_function{};
+  }
+
+  fraction expanded = reduce_node(root_node);
+
+  // Factored form from the structure (stays accurate at high orders):
+  factor_node(root_node);
+  std::vector<std::complex<double>> zeros = root_node.zeros;
+  std::vector<std::complex<double>> poles = root_node.poles;
+  cancel_common_roots(zeros, poles);
+
+  // Gain matched to the structure where it is furthest (relatively) from
+  // every root, so no factor is near 0. s' = j would land on the resonance
+  // of an LC circuit with balanced values, and a passive circuit has its
+  // roots in the left half plane, so s' = 1 is tried first:
+  const std::complex<double> candidates[] = {{1.0, 0.0}, {2.0, 0.0},
+    {0.5, 0.0}, {1.0, 1.0}, {1.0, -1.0}, {4.0, 0.0}, {0.25, 0.0}};
+
+  std::complex<double> reference = candidates[0];
+  double best_distance = -1.0;
+  for (const auto &candidate : candidates) {
+    double distance = std::numeric_limits<double>::infinity();
+    for (const auto &zero : zeros) {
+      distance = std::min(distance, std::abs(candidate - zero));
+    }
+    for (const auto &pole : poles) {
+      distance = std::min(distance, std::abs(candidate - pole));
+    }
+    distance /= std::abs(candidate);
+
+    if (distance > best_distance) {
+      best_distance = distance;
+      reference = candidate;
+    }
+  }
+
+  std::complex<double> value{}, slope{};
+  evaluate_node(root_node, reference, value, slope);
+
+  std::complex<double> gain = value;
+  for (const auto &pole : poles) {
+    gain *= (reference - pole);
+  }
+
+  for (const auto &zero : zeros) {
+    gain /= (reference - zero);
+  }
+
+  return rational_function{expanded.num, expanded.den, omega, z_scale,
+    gain, zeros, poles};
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,142 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Rational function (pole / zero) form of a circuit's impedance:
+//------------------------------------------------------------------------------
+
+#ifndef rational_function_hpp
+#define rational_function_hpp
+
+#include "circuit.hpp"
+
+#include <functional>
+
+//------------------------------------------------------------------------------
+
+namespace circuits
+{
+  // Roots of c[0] + c[1] x + ... + c[n] x^n (Aberth-Ehrlich iteration):
+  std::vector<std::complex<double>> find_roots(
+    const std::vector<std::complex<double>> &coeffs);
+
+  // f(s) and df/ds at a point:
+  using complex_function = std::function<void(const std::complex<double> &s,
+    std::complex<double> &value, std::complex<double> &slope)>;
+
+  // Roots of p(s) = f(s) prod(s - known), starting from the given guesses:
+  // (f is evaluated directly, so p is never expanded into coefficients)
+  std::vector<std::complex<double>> find_function_roots(
+    const complex_function &func,
+    const std::vector<std::complex<double>> &known,
+    std::vector<std::complex<double>> guesses);
+
+//------------------------------------------------------------------------------
+// Polynomial with real coefficients (lowest order first):
+//------------------------------------------------------------------------------
+
+  class polynomial
+  {
+  private:
+    std::vector<double> coeffs;
+
+  public:
+    // Default constructor (zero polynomial):
+    polynomial();
+
+    // Parameterised constructor:
+    polynomial(const std::vector<double> &coefficients);
+
+    size_t get_degree() const;
+    const std::vector<double> &get_coefficients() const;
+
+    // Horner evaluation at a complex point:
+    std::complex<double> evaluate(const std::complex<double> &s) const;
+
+    polynomial derivative() const;
+
+    std::vector<std::complex<double>> get_roots() const;
+
+    // True if both have (relatively) the same coefficients:
+    bool is_close(const polynomial &poly) const;
+
+    // Number of lowest order coefficients that are zero (factors of s):
+    size_t get_lowest_order() const;
+    polynomial divide_by_s(const size_t &power) const;
+
+    polynomial operator+(const polynomial &poly) const;
+    polynomial operator*(const polynomial &poly) const;
+  };
+
+//------------------------------------------------------------------------------
+// Compiled impedance Z(s) = N(s) / D(s):
+//------------------------------------------------------------------------------
+
+  class rational_function
+  {
+  private:
+    // Polynomials use normalised s' = s / omega_scale and Z' = Z / z_scale:
+    polynomial numerator;
+    polynomial denominator;
+    double omega_scale;
+    double impedance_scale;
+
+    // Factored form, Z' = gain * prod(s' - zeros) / prod(s' - poles):
+    std::complex<double> gain;
+    std::vector<std::complex<double>> zeros;
+    std::vector<std::complex<double>> poles;
+
+    void set_factored_form();
+
+  public:
+    // Above this order the factored form is used instead of Horner:
+    static const size_t max_horner_order = 8;
+
+    // Default constructor:
+    rational_function();
+
+    // Parameterised constructor (finds the factored form itself):
+    rational_function(const polynomial &num, const polynomial &den,
+      const double &omega, const double &z_scale);
+
+    // Parameterised constructor with an already known factored form:
+    rational_function(const polynomial &num, const polynomial &den,
+      const double &omega, const double &z_scale,
+      const std::complex<double> &factored_gain,
+      const std::vector<std::complex<double>> &factored_zeros,
+      const std::vector<std::complex<double>> &factored_poles);
+
+    // Impedance at a given frequency (Hz):
+    std::complex<double> evaluate(const double &freq) const;
+
+    // Impedance at many frequencies (Hz):
+    std::vector<std::complex<double>> evaluate(
+      const std::vector<double> &freqs) const;
+
+    // dZ/df at a given frequency (Hz):
+    std::complex<double> evaluate_derivative(const double &freq) const;
+
+    size_t get_order() const;
+
+    // Returns poles / zeros in rad/s (s-plane, not normalised):
+    std::vector<std::complex<double>> get_poles() const;
+    std::vector<std::complex<double>> get_zeros() const;
+
+    // Normalised polynomials (and the scales they use):
+    const polynomial &get_numerator() const;
+    const polynomial &get_denominator() const;
+    double get_omega_scale() const;
+    double get_impedance_scale() const;
+  };
+
+//------------------------------------------------------------------------------
+
+  // Walks the circuit once and returns its impedance as N(s) / D(s):
+  rational_function compile_circuit(const circuit &circ);
+}
+
+//------------------------------------------------------------------------------
+#endif
+//------------------------------------------------------------------------------
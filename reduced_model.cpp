@@ -0,0 +1,673 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Reduced order (pole / residue) model of a circuit, used as a component:
+//------------------------------------------------------------------------------
+
+#include "reduced_model.hpp"
+#include "rational_function.hpp"
+
+#include <limits>
+#include <sstream>
+
+//------------------------------------------------------------------------------
+// Reduced Model Class:
+//------------------------------------------------------------------------------
+
+// For cloning unique_ptr of component:
+std::unique_ptr<component> reduced_model::clone() const
+{
+  return std::make_unique<reduced_model>(*this);
+}
+
+// Default constructor:
+reduced_model::reduced_model()
+{
+  kind = component_kind::reduced_model;
+  frequency = 0;
+  constant = 0;
+  proportional = 0;
+  f_min = 0;
+  f_max = 0;
+  error_bound = 0;
+  set_impedance();
+}
+
+//------------------------------------------------------------------------------
+
+// Parameterised constructor:
+reduced_model::reduced_model(
+  const std::vector<std::complex<double>> &pole_list,
+  const std::vector<std::complex<double>> &residue_list,
+  const double &d, const double &e, const double &min_freq,
+  const double &max_freq, const double &error)
+{
+  if (pole_list.size() != residue_list.size()) {
+    throw std::invalid_argument{"Need one residue for each pole."};
+  }
+
+  for (const auto &pole : pole_list) {
+    if (pole.real() > 0.0) {
+      throw std::out_of_range{"Reduced model poles must be stable."};
+    }
+  }
+
+  if (min_freq < 0.0 || max_freq < min_freq) {
+    throw std::out_of_range{"Invalid frequency band for reduced model."};
+  }
+
+  kind = component_kind::reduced_model;
+  frequency = min_freq;
+  poles = pole_list;
+  residues = residue_list;
+  constant = d;
+  proportional = e;
+  f_min = min_freq;
+  f_max = max_freq;
+  error_bound = error;
+  set_impedance();
+}
+
+//------------------------------------------------------------------------------
+
+// Copy constructor:
+reduced_model::reduced_model(const reduced_model &model)
+{
+  kind = model.kind;
+  impedance = model.impedance;
+  frequency = model.frequency;
+  poles = model.poles;
+  residues = model.residues;
+  constant = model.constant;
+  proportional = model.proportional;
+  f_min = model.f_min;
+  f_max = model.f_max;
+  error_bound = model.error_bound;
+}
+
+//------------------------------------------------------------------------------
+
+// Move constructor:
+reduced_model::reduced_model(reduced_model &&model)
+{
+  // Steal the data:
+  kind = model.kind;
+  impedance = model.impedance;
+  frequency = model.frequency;
+  poles = std::move(model.poles);
+  residues = std::move(model.residues);
+  constant = model.constant;
+  proportional = model.proportional;
+  f_min = model.f_min;
+  f_max = model.f_max;
+  error_bound = model.error_bound;
+
+  // Empty 'old' reduced_model data:
+  model.kind = component_kind::empty;
+  model.impedance = 0;
+  model.frequency = 0;
+  model.poles.clear();
+  model.residues.clear();
+  model.constant = 0;
+  model.proportional = 0;
+  model.f_min = 0;
+  model.f_max = 0;
+  model.error_bound = 0;
+}
+
+//------------------------------------------------------------------------------
+
+// Destructor:
+reduced_model::~reduced_model() {}
+
+//------------------------------------------------------------------------------
+// Access Functions:
+//------------------------------------------------------------------------------
+
+std::complex<double> reduced_model::evaluate(const double &freq) const
+{
+  if (freq < 0.0) {
+    throw std::out_of_range{"Cannot have negative frequency."};
+  }
+
+  std::complex<double> s{0.0, (2 * M_PI * freq)};
+
+  std::complex<double> sum = constant + (s * proportional);
+  for (size_t i{}; i < poles.size(); ++i) {
+    sum += residues[i] / (s - poles[i]);
+  }
+
+  return sum;
+}
+
+void reduced_model::set_impedance()
+{
+  impedance = evaluate(frequency);
+}
+
+//------------------------------------------------------------------------------
+
+void reduced_model::set_value(const double &freq)
+{
+  set_frequency(freq);
+}
+
+double reduced_model::get_value() const
+{
+  return frequency;
+}
+
+void reduced_model::set_frequency(const double &freq)
+{
+  if (freq < 0.0) {
+    throw std::out_of_range{"Cannot have negative frequency."};
+  }
+
+  frequency = freq;
+  set_impedance();
+}
+
+double reduced_model::get_frequency() const
+{
+  return frequency;
+}
+
+// dZ/ds = e - sum(r / (s - p)^2), and ds/df = j 2 pi:
+std::complex<double> reduced_model::get_impedance_derivative() const
+{
+  std::complex<double> s{0.0, (2 * M_PI * frequency)};
+
+  std::complex<double> slope = proportional;
+  for (size_t i{}; i < poles.size(); ++i) {
+    slope -= residues[i] / ((s - poles[i]) * (s - poles[i]));
+  }
+
+  return std::complex<double>{0.0, (2 * M_PI)} * slope;
+}
+
+//------------------------------------------------------------------------------
+
+size_t reduced_model::get_order() const
+{
+  return poles.size();
+}
+
+void reduced_model::set_error_bound(const double &error)
+{
+  error_bound = error;
+}
+
+double reduced_model::get_error_bound() const
+{
+  return error_bound;
+}
+
+//------------------------------------------------------------------------------
+
+void reduced_model::write_info(circuits::report_writer &out) const
+{
+  out << "Reduced model:" << '\n'
+  << "    Order = " << poles.size() << " poles," << '\n';
+
+  out << "    Valid from " << f_min << " Hz";
+
+  out << " to " << f_max << " Hz," << '\n';
+
+  out << "    Relative error < " << circuits::as_scientific(error_bound)
+  << "." << '\n';
+}
+
+//------------------------------------------------------------------------------
+// Vector fitting:
+//------------------------------------------------------------------------------
+
+namespace
+{
+  using namespace circuits;
+
+  // Real pole, or complex pair stored by its upper half plane member:
+  struct pole_entry
+  {
+    std::complex<double> value;
+    bool is_pair;
+  };
+
+  // Least squares solution of A x = b by Householder QR (A is m x n):
+  // (columns are scaled to unit length first for conditioning)
+  std::vector<double> least_squares(std::vector<double> matrix,
+    std::vector<double> rhs, const size_t &rows, const size_t &cols)
+  {
+    std::vector<double> column_scale(cols, 1.0);
+
+    for (size_t j{}; j < cols; ++j) {
+      double norm{};
+      for (size_t i{}; i < rows; ++i) {
+        norm += matrix[i * cols + j] * matrix[i * cols + j];
+      }
+
+      norm = std::sqrt(norm);
+      if (norm > 0) {
+        column_scale[j] = norm;
+        for (size_t i{}; i < rows; ++i) {
+          matrix[i * cols + j] /= norm;
+        }
+      }
+    }
+
+    for (size_t k{}; k < cols; ++k) {
+      double norm{};
+      for (size_t i = k; i < rows; ++i) {
+        norm += matrix[i * cols + k] * matrix[i * cols + k];
+      }
+      norm = std::sqrt(norm);
+
+      if (norm == 0) {
+        continue;
+      }
+
+      double alpha = (matrix[k * cols + k] > 0) ? -norm : norm;
+
+      // Householder vector v = x - alpha e1 (stored in place):
+      std::vector<double> v(rows - k);
+      for (size_t i = k; i < rows; ++i) {
+        v[i - k] = matrix[i * cols + k];
+      }
+      v[0] -= alpha;
+
+      double v_norm{};
+      for (const auto &value : v) {
+        v_norm += value * value;
+      }
+
+      if (v_norm == 0) {
+        continue;
+      }
+
+      // Apply H = I - 2 v v^T / (v^T v) to remaining columns and rhs:
+      for (size_t j = k; j < cols; ++j) {
+        double dot{};
+        for (size_t i = k; i < rows; ++i) {
+          dot += v[i - k] * matrix[i * cols + j];
+        }
+
+        double factor = 2 * dot / v_norm;
+        for (size_t i = k; i < rows; ++i) {
+          matrix[i * cols + j] -= factor * v[i - k];
+        }
+      }
+
+      double dot{};
+      for (size_t i = k; i < rows; ++i) {
+        dot += v[i - k] * rhs[i];
+      }
+
+      double factor = 2 * dot / v_norm;
+      for (size_t i = k; i < rows; ++i) {
+        rhs[i] -= factor * v[i - k];
+      }
+    }
+
+    // Back substitution with R:
+    std::vector<double> solution(cols);
+    for (size_t k = cols; k-- > 0;) {
+      double sum = rhs[k];
+      for (size_t j = k + 1; j < cols; ++j) {
+        sum -= matrix[k * cols + j] * solution[j];
+      }
+
+      double diagonal = matrix[k * cols + k];
+      solution[k] = (diagonal != 0) ? (sum / diagonal) : 0.0;
+    }
+
+    for (size_t j{}; j < cols; ++j) {
+      solution[j] /= column_scale[j];
+    }
+
+    return solution;
+  }
+
+//------------------------------------------------------------------------------
+
+  // Basis functions of each pole entry at s (1 for a real pole, 2 for a pair):
+  std::vector<std::complex<double>> basis(
+    const std::vector<pole_entry> &entries, const std::complex<double> &s)
+  {
+    std::vector<std::complex<double>> values;
+    const std::complex<double> j{0.0, 1.0};
+
+    for (const auto &entry : entries) {
+      std::complex<double> a = entry.value;
+
+      if (entry.is_pair) {
+        values.push_back(1.0 / (s - a) + 1.0 / (s - std::conj(a)));
+        values.push_back(j / (s - a) - j / (s - std::conj(a)));
+
+      } else {
+        values.push_back(1.0 / (s - a));
+      }
+    }
+
+    return values;
+  }
+
+  // All poles (including the lower half of each pair):
+  std::vector<std::complex<double>> all_poles(
+    const std::vector<pole_entry> &entries)
+  {
+    std::vector<std::complex<double>> poles;
+    for (const auto &entry : entries) {
+      poles.push_back(entry.value);
+      if (entry.is_pair) {
+        poles.push_back(std::conj(entry.value));
+      }
+    }
+
+    return poles;
+  }
+
+  // Residues matching all_poles from the real fitting coefficients:
+  std::vector<std::complex<double>> all_residues(
+    const std::vector<pole_entry> &entries, const std::vector<double> &coeffs)
+  {
+    std::vector<std::complex<double>> residues;
+    size_t index{};
+
+    for (const auto &entry : entries) {
+      if (entry.is_pair) {
+        std::complex<double> residue{coeffs[index], coeffs[index + 1]};
+        residues.push_back(residue);
+        residues.push_back(std::conj(residue));
+        index += 2;
+
+      } else {
+        residues.push_back(coeffs[index]);
+        ++index;
+      }
+    }
+
+    return residues;
+  }
+
+//------------------------------------------------------------------------------
+
+  // Zeros of sigma(s) = 1 + sum(r~ / (s - a)) become the new poles:
+  std::vector<pole_entry> relocate_poles(const std::vector<pole_entry> &entries,
+    const std::vector<double> &sigma_coeffs)
+  {
+    std::vector<std::complex<double>> poles = all_poles(entries);
+    std::vector<std::complex<double>> residues
+      = all_residues(entries, sigma_coeffs);
+
+    auto sigma = [&](const std::complex<double> &s,
+      std::complex<double> &value, std::complex<double> &slope) {
+      value = 1.0;
+      slope = 0.0;
+      for (size_t i{}; i < poles.size(); ++i) {
+        value += residues[i] / (s - poles[i]);
+        slope -= residues[i] / ((s - poles[i]) * (s - poles[i]));
+      }
+    };
+
+    // Old poles (nudged off themselves) are good starting guesses:
+    std::vector<std::complex<double>> guesses;
+    for (const auto &pole : poles) {
+      guesses.push_back(pole * std::complex<double>{1.001, 0.001});
+    }
+
+    std::vector<std::complex<double>> zeros
+      = find_function_roots(sigma, poles, guesses);
+
+    // Imaginary parts below this are rounding noise on a real pole:
+    double largest{};
+    for (const auto &zero : zeros) {
+      largest = std::max(largest, std::abs(zero));
+    }
+    double tolerance = 1e-8 * largest;
+
+    // Stable, conjugate symmetric poles:
+    std::vector<pole_entry> relocated;
+    size_t count{};
+
+    for (auto zero : zeros) {
+      if (zero.real() > 0) {
+        zero = std::complex<double>{-zero.real(), zero.imag()};
+      }
+
+      if (std::abs(zero.imag()) <= tolerance) {
+        relocated.push_back(pole_entry{zero.real(), false});
+        ++count;
+
+      } else if (zero.imag() > 0) {
+        relocated.push_back(pole_entry{zero, true});
+        count += 2;
+      }
+    }
+
+    // Numerical noise broke the conjugate pairing, so keep the old poles:
+    if (count != poles.size()) {
+      return entries;
+    }
+
+    return relocated;
+  }
+}
+
+//------------------------------------------------------------------------------
+
+std::shared_ptr<reduced_model> circuits::vector_fit(
+  const std::vector<double> &freqs,
+  const std::vector<std::complex<double>> &impedances,
+  const size_t &order, const size_t &iterations)
+{
+  if (freqs.size() != impedances.size() || freqs.size() == 0) {
+    throw std::invalid_argument{"Need one impedance for each frequency."};
+  }
+
+  if (order == 0 || (2 * freqs.size()) < (2 * order + 2)) {
+    throw std::out_of_range{"Order must be above 0 and below the samples."};
+  }
+
+  double f_low = *std::min_element(freqs.begin(), freqs.end());
+  double f_high = *std::max_element(freqs.begin(), freqs.end());
+
+  if (f_low <= 0.0) {
+    throw std::out_of_range{"Fitting frequencies must be above 0 Hz."};
+  }
+
+  // Normalise s and Z so the least squares problem is well scaled:
+  double omega_scale = 2 * M_PI * std::sqrt(f_low * f_high);
+
+  double log_sum{};
+  size_t nonzero{};
+  for (const auto &z : impedances) {
+    if (std::abs(z) > 0) {
+      log_sum += std::log(std::abs(z));
+      ++nonzero;
+    }
+  }
+  double z_scale = (nonzero != 0) ? std::exp(log_sum / nonzero) : 1.0;
+
+  size_t samples = freqs.size();
+  std::vector<std::complex<double>> s(samples), h(samples);
+  std::vector<double> weight(samples);
+
+  for (size_t k{}; k < samples; ++k) {
+    s[k] = std::complex<double>{0.0, (2 * M_PI * freqs[k] / omega_scale)};
+    h[k] = impedances[k] / z_scale;
+
+    // Relative (not absolute) error is minimised:
+    weight[k] = (std::abs(h[k]) > 0) ? (1.0 / std::abs(h[k])) : 1.0;
+  }
+
+  // Starting poles: lightly damped pairs spread (log) over the band:
+  std::vector<pole_entry> entries;
+  double beta_low = 2 * M_PI * f_low / omega_scale;
+  double beta_high = 2 * M_PI * f_high / omega_scale;
+  size_t pairs = order / 2;
+
+  for (size_t i{}; i < pairs; ++i) {
+    double fraction = (pairs > 1) ? (double(i) / (pairs - 1)) : 0.5;
+    double beta = beta_low * std::pow(beta_high / beta_low, fraction);
+    entries.push_back(pole_entry{{-0.01 * beta, beta}, true});
+  }
+
+  if (order % 2 == 1) {
+    entries.push_back(
+      pole_entry{-std::sqrt(beta_low * beta_high), false});
+  }
+
+  size_t rows = 2 * samples;
+
+//------------------------------------------------------------------------------
+
+  // Pole relocation: fit [sum(c phi) + d + s e] - h [sum(c~ phi)] = h:
+  for (size_t iteration{}; iteration < iterations; ++iteration) {
+    size_t cols = 2 * order + 2;
+    std::vector<double> matrix(rows * cols);
+    std::vector<double> rhs(rows);
+
+    for (size_t k{}; k < samples; ++k) {
+      std::vector<std::complex<double>> phi = basis(entries, s[k]);
+      std::vector<std::complex<double>> row(cols);
+
+      for (size_t i{}; i < order; ++i) {
+        row[i] = phi[i];
+        row[order + 2 + i] = -h[k] * phi[i];
+      }
+      row[order] = 1.0;
+      row[order + 1] = s[k];
+
+      for (size_t j{}; j < cols; ++j) {
+        matrix[(2 * k) * cols + j] = weight[k] * row[j].real();
+        matrix[(2 * k + 1) * cols + j] = weight[k] * row[j].imag();
+      }
+
+      rhs[2 * k] = weight[k] * h[k].real();
+      rhs[2 * k + 1] = weight[k] * h[k].imag();
+    }
+
+    std::vector<double> solution = least_squares(matrix, rhs, rows, cols);
+    std::vector<double> sigma_coeffs(
+      solution.begin() + order + 2, solution.end());
+
+    entries = relocate_poles(entries, sigma_coeffs);
+  }
+
+//------------------------------------------------------------------------------
+
+  // Residue identification with the final poles:
+  size_t cols = order + 2;
+  std::vector<double> matrix(rows * cols);
+  std::vector<double> rhs(rows);
+
+  for (size_t k{}; k < samples; ++k) {
+    std::vector<std::complex<double>> phi = basis(entries, s[k]);
+    std::vector<std::complex<double>> row(cols);
+
+    for (size_t i{}; i < order; ++i) {
+      row[i] = phi[i];
+    }
+    row[order] = 1.0;
+    row[order + 1] = s[k];
+
+    for (size_t j{}; j < cols; ++j) {
+      matrix[(2 * k) * cols + j] = weight[k] * row[j].real();
+      matrix[(2 * k + 1) * cols + j] = weight[k] * row[j].imag();
+    }
+
+    rhs[2 * k] = weight[k] * h[k].real();
+    rhs[2 * k + 1] = weight[k] * h[k].imag();
+  }
+
+  std::vector<double> solution = least_squares(matrix, rhs, rows, cols);
+
+  // Back to physical units (s = omega_scale s', Z = z_scale Z'):
+  std::vector<std::complex<double>> poles = all_poles(entries);
+  std::vector<std::complex<double>> residues = all_residues(entries, solution);
+
+  for (size_t i{}; i < poles.size(); ++i) {
+    poles[i] *= omega_scale;
+    residues[i] *= omega_scale * z_scale;
+  }
+
+  double constant = solution[order] * z_scale;
+  double proportional = solution[order + 1] * z_scale / omega_scale;
+
+  return std::make_shared<reduced_model>(
+    poles, residues, constant, proportional, f_low, f_high, 0.0);
+}
+
+//------------------------------------------------------------------------------
+
+std::shared_ptr<reduced_model> circuits::reduce_circuit(
+  const circuit &circ, const reduction_options &options)
+{
+  if (options.f_min <= 0.0 || options.f_max <= options.f_min) {
+    throw std::out_of_range{"Invalid frequency band for reduction."};
+  }
+
+  // Log spaced samples (check grid is denser and offset from the fit grid):
+  auto sample = [&](const size_t &count, const double &offset,
+    std::vector<double> &freqs, std::vector<std::complex<double>> &values) {
+    double log_step = std::log(options.f_max / options.f_min) / (count - 1);
+
+    for (size_t i{}; i < count; ++i) {
+      double freq = options.f_min * std::exp(log_step * (i + offset));
+      freq = std::min(freq, options.f_max);
+      freqs.push_back(freq);
+      values.push_back(circ.evaluate(freq));
+    }
+  };
+
+  std::vector<double> fit_freqs, check_freqs;
+  std::vector<std::complex<double>> fit_values, check_values;
+  sample(options.samples, 0.0, fit_freqs, fit_values);
+  sample(options.check_samples, 0.5, check_freqs, check_values);
+
+  std::shared_ptr<reduced_model> best;
+  double best_error = std::numeric_limits<double>::infinity();
+
+  // Raise order (a pole pair at a time) until the check grid passes:
+  for (size_t order{2}; order <= options.max_order; order += 2) {
+    std::shared_ptr<reduced_model> model
+      = vector_fit(fit_freqs, fit_values, order, options.iterations);
+
+    double error{};
+    for (size_t i{}; i < check_freqs.size(); ++i) {
+      model->set_frequency(check_freqs[i]);
+      double difference = std::abs(model->get_impedance() - check_values[i]);
+      error = std::max(error, difference / std::abs(check_values[i]));
+    }
+
+    // NaN error (failed fit) is never accepted:
+    if (error < best_error) {
+      best = model;
+      best_error = error;
+    }
+
+    if (best_error <= options.tolerance) {
+      break;
+    }
+  }
+
+  if (!best) {
+    throw std::runtime_error{"Vector fitting failed for this circuit."};
+  }
+
+  if (!(best_error <= options.tolerance)) {
+    std::ostringstream message;
+    message << "Reduction did not reach the tolerance by order "
+      << options.max_order << " (best relative error " << best_error << ").";
+    throw std::runtime_error{message.str()};
+  }
+
+  best->set_error_bound(best_error);
+  best->set_frequency(circ.get_frequency());
+
+  return best;
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,116 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Reduced order (pole / residue) model of a circuit, used as a component:
+//------------------------------------------------------------------------------
+
+#ifndef reduced_model_hpp
+#define reduced_model_hpp
+
+#include "circuit.hpp"
+
+//------------------------------------------------------------------------------
+// Reduced Model Class:
+//------------------------------------------------------------------------------
+
+// Z(s) = d + s e + sum(r_i / (s - p_i)), with s = j 2 pi f (rad/s):
+class reduced_model : public component
+{
+private:
+  std::vector<std::complex<double>> poles;
+  std::vector<std::complex<double>> residues;
+  double constant;
+  double proportional;
+
+  // Band the model was fitted over (Hz):
+  double f_min;
+  double f_max;
+
+  // Largest relative error found when checking against the circuit:
+  double error_bound;
+
+public:
+  // For cloning unique_ptr of reduced model component:
+  std::unique_ptr<component> clone() const;
+
+  // Default constructor:
+  reduced_model();
+
+  // Parameterised constructor:
+  reduced_model(const std::vector<std::complex<double>> &pole_list,
+    const std::vector<std::complex<double>> &residue_list,
+    const double &d, const double &e, const double &min_freq,
+    const double &max_freq, const double &error);
+
+  // Copy constructor for deep copying:
+  reduced_model(const reduced_model &model);
+
+  // Move constructor (note double &&):
+  reduced_model(reduced_model &&model);
+
+  // Destructor:
+  ~reduced_model();
+
+//------------------------------------------------------------------------------
+
+  std::complex<double> evaluate(const double &freq) const;
+  void set_impedance();
+
+  // Value of a reduced model is its frequency (like circuit):
+  void set_value(const double &freq);
+  double get_value() const;
+
+  void set_frequency(const double &freq);
+  double get_frequency() const;
+
+  std::complex<double> get_impedance_derivative() const;
+
+  size_t get_order() const;
+
+  void set_error_bound(const double &error);
+  double get_error_bound() const;
+
+  void write_info(circuits::report_writer &out) const;
+};
+
+//------------------------------------------------------------------------------
+
+namespace circuits
+{
+  struct reduction_options
+  {
+    // Band to fit over (Hz):
+    double f_min = 1.0;
+    double f_max = 1e9;
+
+    // Samples used for fitting (checking uses check_samples):
+    size_t samples = 200;
+    size_t check_samples = 1000;
+
+    // Largest allowed relative error on the check grid:
+    double tolerance = 1e-3;
+
+    size_t max_order = 40;
+    size_t iterations = 10;
+  };
+
+  // Vector fitting of sampled impedances with a given number of poles:
+  std::shared_ptr<reduced_model> vector_fit(
+    const std::vector<double> &freqs,
+    const std::vector<std::complex<double>> &impedances,
+    const size_t &order, const size_t &iterations = 10);
+
+  // Samples the circuit (through evaluate(), so it isn't changed) and
+  // raises the order until the tolerance is met. The model is set to the
+  // circuit's frequency. Throws std::runtime_error if max_order is reached
+  // first (the best error found is in the message):
+  std::shared_ptr<reduced_model> reduce_circuit(const circuit &circ,
+    const reduction_options &options = reduction_options{});
+}
+
+//------------------------------------------------------------------------------
+#endif
+//------------------------------------------------------------------------------
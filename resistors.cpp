@@ -22,8 +22,7 @@ std::unique_ptr<component> resistor::clone() const
 // Default constructor:
 resistor::resistor() : component{}
 {
-  type = "resistor";
-  symbol = 'R';
+  kind = component_kind::resistor;
   resistance = 0;
   set_impedance();
 }
@@ -43,8 +42,7 @@ resistor::resistor(const double &res)
     throw std::out_of_range{"Resistance must be below 10 GOhms."};
   }
 
-  type = "resistor";
-  symbol = 'R';
+  kind = component_kind::resistor;
   resistance = res;
   set_impedance();
 }
@@ -54,8 +52,7 @@ resistor::resistor(const double &res)
 // Copy constructor:
 resistor::resistor(const resistor &resis)
 {
-  type = resis.type;
-  symbol = resis.symbol;
+  kind = resis.kind;
   impedance = resis.impedance;
   frequency = resis.frequency;
   resistance = resis.resistance;
@@ -67,15 +64,13 @@ resistor::resistor(const resistor &resis)
 resistor::resistor(resistor &&resis)
 {
   // Steal the data:
-  type = resis.type;
-  symbol = resis.symbol;
+  kind = resis.kind;
   impedance = resis.impedance;
   frequency = resis.frequency;
   resistance = resis.resistance;
 
   // Empty 'old' resistor data:
-  resis.type = "empty";
-  resis.symbol = 'N';
+  resis.kind = component_kind::empty;
   resis.impedance = 0;
   resis.frequency = 0;
   resis.resistance = 0;
@@ -90,9 +85,18 @@ resistor::~resistor() {}
 // Access Functions:
 //------------------------------------------------------------------------------
 
+std::complex<double> resistor::evaluate(const double &freq) const
+{
+  if (freq < 0.0) {
+    throw std::out_of_range{"Cannot have negative frequency."};
+  }
+
+  return std::complex<double>{resistance, 0.0};
+}
+
 void resistor::set_impedance()
 {
-  impedance = resistance;
+  impedance = evaluate(frequency);
 }
 
 //------------------------------------------------------------------------------
@@ -153,17 +157,18 @@ double resistor::get_frequency() const
   return frequency;
 }
 
+// Resistance is independent of frequency:
+std::complex<double> resistor::get_impedance_derivative() const
+{
+  return std::complex<double>{};
+}
+
 //------------------------------------------------------------------------------
 
-void resistor::print_info() const
+void resistor::write_info(circuits::report_writer &out) const
 {
-  if (resistance <= 1e-2 || resistance >= 1e3) {
-    std::cout << std::scientific;
-  } else {
-    std::cout << std::fixed;
-  }
-  std::cout << "Resistor:" << std::endl
-  << "    Resistance, R = " << resistance << " Ohms." << std::endl;
+  out << "Resistor:" << '\n'
+  << "    Resistance, R = " << resistance << " Ohms." << '\n';
 }
 
 
@@ -180,8 +185,7 @@ std::unique_ptr<component> real_resistor::clone() const
 // Default constructor:
 real_resistor::real_resistor()
 {
-  type = "real resistor";
-  symbol = 'r';
+  kind = component_kind::real_resistor;
   resistance = 0;
   inductance = 0;
   capacitance = 0;
@@ -224,8 +228,7 @@ real_resistor::real_resistor(
 
 //------------------------------------------------------------------------------
 
-  type = "real resistor";
-  symbol = 'r';
+  kind = component_kind::real_resistor;
   resistance = res;
   inductance = ind;
   capacitance = cap;
@@ -237,8 +240,7 @@ real_resistor::real_resistor(
 // Copy constructor:
 real_resistor::real_resistor(const real_resistor &resis)
 {
-  type = resis.type;
-  symbol = resis.symbol;
+  kind = resis.kind;
   impedance = resis.impedance;
   frequency = resis.frequency;
   resistance = resis.resistance;
@@ -252,8 +254,7 @@ real_resistor::real_resistor(const real_resistor &resis)
 real_resistor::real_resistor(real_resistor &&resis)
 {
   // Steal the data:
-  type = resis.type;
-  symbol = resis.symbol;
+  kind = resis.kind;
   impedance = resis.impedance;
   frequency = resis.frequency;
   resistance = resis.resistance;
@@ -261,8 +262,7 @@ real_resistor::real_resistor(real_resistor &&resis)
   capacitance = resis.capacitance;
 
   // Empty 'old' real_resistor data:
-  resis.type = "empty";
-  resis.symbol = 'N';
+  resis.kind = component_kind::empty;
   resis.impedance = 0;
   resis.frequency = 0;
   resis.resistance = 0;
@@ -279,10 +279,14 @@ real_resistor::~real_resistor() {}
 // Access Functions:
 //------------------------------------------------------------------------------
 
-void real_resistor::set_impedance()
+std::complex<double> real_resistor::evaluate(const double &freq) const
 {
+  if (freq < 0.0) {
+    throw std::out_of_range{"Cannot have negative frequency."};
+  }
+
   // Break up into smaller calcs:
-  double omega = (2 * M_PI * frequency);
+  double omega = (2 * M_PI * freq);
 
   double real_a = (1 - (pow(omega, 2) * capacitance * inductance));
   double real_b = (omega * resistance * capacitance);
@@ -295,12 +299,12 @@ void real_resistor::set_impedance()
   double ind_squared = pow(inductance, 2);
   double res_squared = pow(resistance, 2);
 
-  // Separate numerator terms:
+  // Separate numerator terms, Im[(R + jwL)(a - jb)] = wL - w^3 L^2 C - w R^2 C:
   double imag_a = (omega * inductance);
   double imag_b = (omega_cubed * capacitance * ind_squared);
   double imag_c = (omega * capacitance * res_squared);
 
-  double imag_numerator = (imag_a + imag_b - imag_c);
+  double imag_numerator = (imag_a - imag_b - imag_c);
 
 //------------------------------------------------------------------------------
 
@@ -311,36 +315,61 @@ void real_resistor::set_impedance()
 
   double imag_part = imag_numerator / imag_denominator;
 
-  impedance = std::complex<double>{real_part, imag_part};
+  return std::complex<double>{real_part, imag_part};
+}
+
+void real_resistor::set_impedance()
+{
+  impedance = evaluate(frequency);
 }
 
 //------------------------------------------------------------------------------
 
-void real_resistor::print_info() const
+// Derivative of Z = (R + jwL) / (1 - w^2 LC + jwRC) with respect to f:
+std::complex<double> real_resistor::get_impedance_derivative() const
 {
-  std::cout << "Non-ideal resistor:" << std::endl;
+  double omega = (2 * M_PI * frequency);
 
-  // Converts to scientific notation:
-  if (resistance <= 1e-2 || resistance >= 1e3) {
-    std::cout << std::scientific;
-  } else {
-    std::cout << std::fixed;
-  }
-  std::cout << "    Resistance, R = " << resistance << " Ohms," << std::endl;
+  std::complex<double> numerator{resistance, (omega * inductance)};
+  std::complex<double> denominator{
+    (1 - (pow(omega, 2) * capacitance * inductance)),
+    (omega * resistance * capacitance)};
 
-  if (inductance <= 1e-2 || inductance >= 1e3) {
-    std::cout << std::scientific;
-  } else {
-    std::cout << std::fixed;
-  }
-  std::cout << "    Inductance, L = " << inductance << " H," << std::endl;
+  // Derivatives of each part with respect to omega:
+  std::complex<double> d_numerator{0.0, inductance};
+  std::complex<double> d_denominator{
+    (-2 * omega * capacitance * inductance), (resistance * capacitance)};
 
-  if (capacitance <= 1e-2 || capacitance >= 1e3) {
-    std::cout << std::scientific;
-  } else {
-    std::cout << std::fixed;
-  }
-  std::cout << "    Capacitance, C = " << capacitance << " F." << std::endl;
+  std::complex<double> d_impedance = ((d_numerator * denominator)
+    - (numerator * d_denominator)) / (denominator * denominator);
+
+  // Chain rule, since omega = 2 pi f:
+  return (2 * M_PI * d_impedance);
+}
+
+//------------------------------------------------------------------------------
+
+double real_resistor::get_inductance() const
+{
+  return inductance;
+}
+
+double real_resistor::get_capacitance() const
+{
+  return capacitance;
+}
+
+//------------------------------------------------------------------------------
+
+void real_resistor::write_info(circuits::report_writer &out) const
+{
+  out << "Non-ideal resistor:" << '\n';
+
+  out << "    Resistance, R = " << resistance << " Ohms," << '\n';
+
+  out << "    Inductance, L = " << inductance << " H," << '\n';
+
+  out << "    Capacitance, C = " << capacitance << " F." << '\n';
 }
 
 //------------------------------------------------------------------------------
\ No newline at end of file
@@ -0,0 +1,414 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Resonance, Q factor and bandwidth analysis of circuits:
+//------------------------------------------------------------------------------
+
+#include "resonance.hpp"
+#include "parallel.hpp"
+
+#include <limits>
+
+//------------------------------------------------------------------------------
+// Helper functions (only used in this file):
+//------------------------------------------------------------------------------
+
+namespace
+{
+  using namespace circuits;
+
+  const size_t max_iterations = 100;
+  const double relative_tolerance = 1e-12;
+
+  // Impedance and its derivative at one frequency:
+  struct sample
+  {
+    double frequency;
+    std::complex<double> impedance;
+    std::complex<double> derivative;
+  };
+
+  sample evaluate_at(circuit &circ, const double &freq)
+  {
+    circ.set_frequency(freq);
+    return sample{freq, circ.get_impedance(), circ.get_impedance_derivative()};
+  }
+
+  // Puts the circuit back to its original frequency once analysis is done:
+  class frequency_guard
+  {
+  private:
+    circuit &circ;
+    double original_frequency;
+
+  public:
+    frequency_guard(circuit &c) : circ{c}, original_frequency{c.get_frequency()}
+    {}
+
+    ~frequency_guard()
+    {
+      circ.set_frequency(original_frequency);
+    }
+  };
+
+//------------------------------------------------------------------------------
+
+  // Log spaced frequencies between f_min and f_max (inclusive):
+  std::vector<double> log_grid(
+    const double &f_min, const double &f_max, const size_t &samples)
+  {
+    if (f_min <= 0.0) {
+      throw std::out_of_range{"Minimum frequency must be above 0 Hz."};
+    }
+
+    if (f_max <= f_min) {
+      throw std::out_of_range{"Maximum frequency must be above the minimum."};
+    }
+
+    if (samples < 2) {
+      throw std::out_of_range{"Need at least 2 frequency samples."};
+    }
+
+    std::vector<double> grid(samples);
+    double log_step = std::log(f_max / f_min) / (samples - 1);
+
+    for (size_t i{}; i < samples; ++i) {
+      grid[i] = f_min * std::exp(log_step * i);
+    }
+
+    // Avoids rounding past the end of the range:
+    grid.back() = f_max;
+
+    return grid;
+  }
+
+  std::vector<sample> sample_circuit(
+    circuit &circ, const std::vector<double> &grid)
+  {
+    std::vector<sample> samples;
+    samples.reserve(grid.size());
+
+    for (const auto &freq : grid) {
+      samples.push_back(evaluate_at(circ, freq));
+    }
+
+    return samples;
+  }
+
+//------------------------------------------------------------------------------
+
+  // Safeguarded Newton iteration on Im(Z) = 0 inside a sign change bracket:
+  // (falls back to bisection whenever Newton would leave the bracket)
+  sample newton_phase_root(circuit &circ, const sample &lo, const sample &hi)
+  {
+    // Keep track of which end has negative reactance:
+    double x_negative = lo.frequency;
+    double x_positive = hi.frequency;
+
+    if (lo.impedance.imag() > 0) {
+      std::swap(x_negative, x_positive);
+    }
+
+    double x = std::sqrt(lo.frequency * hi.frequency);
+    sample current = evaluate_at(circ, x);
+
+    for (size_t i{}; i < max_iterations; ++i) {
+      double reactance = current.impedance.imag();
+      double d_reactance = current.derivative.imag();
+
+      // Landed exactly on the root:
+      if (reactance == 0) {
+        break;
+      }
+
+      if (reactance < 0) {
+        x_negative = x;
+      } else {
+        x_positive = x;
+      }
+
+      double lower = std::min(x_negative, x_positive);
+      double upper = std::max(x_negative, x_positive);
+
+      double x_new = x - (reactance / d_reactance);
+
+      // Newton step unusable, so bisect the bracket instead:
+      if (!std::isfinite(x_new) || x_new < lower || x_new > upper) {
+        x_new = 0.5 * (lower + upper);
+      }
+
+      bool converged = std::abs(x_new - x) <= (relative_tolerance * x);
+
+      x = x_new;
+      current = evaluate_at(circ, x);
+
+      if (converged) {
+        break;
+      }
+    }
+
+    return current;
+  }
+
+//------------------------------------------------------------------------------
+
+  // Re(conj(Z) dZ/df) = 0.5 d|Z|^2/df, so its roots are |Z| extrema:
+  double magnitude_slope(const sample &s)
+  {
+    return std::real(std::conj(s.impedance) * s.derivative);
+  }
+
+  // Illinois (modified regula falsi) root of magnitude_slope in a bracket:
+  sample magnitude_slope_root(circuit &circ, sample lo, sample hi)
+  {
+    double slope_lo = magnitude_slope(lo);
+    double slope_hi = magnitude_slope(hi);
+
+    sample current = lo;
+    int last_side = 0;
+
+    for (size_t i{}; i < max_iterations; ++i) {
+      double x = (lo.frequency * slope_hi - hi.frequency * slope_lo)
+        / (slope_hi - slope_lo);
+
+      if (!std::isfinite(x) || x <= lo.frequency || x >= hi.frequency) {
+        x = 0.5 * (lo.frequency + hi.frequency);
+      }
+
+      current = evaluate_at(circ, x);
+      double slope = magnitude_slope(current);
+
+      if (slope == 0
+        || (hi.frequency - lo.frequency) <= (relative_tolerance * x)) {
+        break;
+      }
+
+      // Halve the retained end's value if the same side moves twice:
+      if ((slope < 0) == (slope_lo < 0)) {
+        lo = current;
+        slope_lo = slope;
+        if (last_side == -1) {
+          slope_hi *= 0.5;
+        }
+        last_side = -1;
+
+      } else {
+        hi = current;
+        slope_hi = slope;
+        if (last_side == 1) {
+          slope_lo *= 0.5;
+        }
+        last_side = 1;
+      }
+    }
+
+    return current;
+  }
+
+//------------------------------------------------------------------------------
+
+  // Searches outwards from f0 for the -3 dB edge, then bisects (in log f):
+  bool find_band_edge(circuit &circ, const double &f0, const double &target,
+    const bool &is_series, const double &step_ratio, const double &f_limit,
+    double &edge)
+  {
+    // Series: |Z| rises to target, parallel: |Z| falls to target:
+    auto past_edge = [&](const double &freq) {
+      double magnitude = std::abs(evaluate_at(circ, freq).impedance);
+      return is_series ? (magnitude >= target) : (magnitude <= target);
+    };
+
+    bool going_up = f_limit > f0;
+    double inside = f0;
+    double outside = f0;
+
+    bool found = false;
+    while (!found) {
+      outside = going_up ? (inside * step_ratio) : (inside / step_ratio);
+
+      // Edge lies outside of the search range:
+      if ((going_up && outside > f_limit) || (!going_up && outside < f_limit)) {
+        return false;
+      }
+
+      if (past_edge(outside)) {
+        found = true;
+      } else {
+        inside = outside;
+      }
+    }
+
+    for (size_t i{}; i < max_iterations; ++i) {
+      double middle = std::sqrt(inside * outside);
+
+      if (past_edge(middle)) {
+        outside = middle;
+      } else {
+        inside = middle;
+      }
+
+      if (std::abs(outside - inside) <= (relative_tolerance * middle)) {
+        break;
+      }
+    }
+
+    edge = std::sqrt(inside * outside);
+    return true;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Phase crossings and magnitude extrema:
+//------------------------------------------------------------------------------
+
+std::vector<double> circuits::find_phase_crossings(circuit &circ,
+  const double &f_min, const double &f_max, const size_t &samples)
+{
+  frequency_guard guard{circ};
+
+  std::vector<sample> grid = sample_circuit(circ, log_grid(f_min, f_max, samples));
+  std::vector<double> crossings;
+
+  for (size_t i{1}; i < grid.size(); ++i) {
+    double reactance_lo = grid[i - 1].impedance.imag();
+    double reactance_hi = grid[i].impedance.imag();
+
+    // Exactly on a sample point, a crossing only if the reactance changes
+    // sign across it (not a flat zero, e.g. a lone resistor). Taken here
+    // alone, so neither interval next to it is searched as well:
+    if (reactance_hi == 0) {
+      if (reactance_lo != 0 && i + 1 < grid.size()) {
+        double reactance_next = grid[i + 1].impedance.imag();
+        if (reactance_next != 0 && (reactance_lo < 0) != (reactance_next < 0)) {
+          crossings.push_back(grid[i].frequency);
+        }
+      }
+      continue;
+    }
+
+    if (reactance_lo == 0 || (reactance_lo < 0) == (reactance_hi < 0)) {
+      continue;
+    }
+
+    sample root = newton_phase_root(circ, grid[i - 1], grid[i]);
+
+    // Sign change across a pole (ideal tank), not a zero crossing:
+    double reactance = std::abs(root.impedance.imag());
+    if (reactance > (1e-6 * std::abs(root.impedance))) {
+      continue;
+    }
+
+    crossings.push_back(root.frequency);
+  }
+
+  return crossings;
+}
+
+//------------------------------------------------------------------------------
+
+std::vector<magnitude_extremum> circuits::find_magnitude_extrema(circuit &circ,
+  const double &f_min, const double &f_max, const size_t &samples)
+{
+  frequency_guard guard{circ};
+
+  std::vector<sample> grid = sample_circuit(circ, log_grid(f_min, f_max, samples));
+  std::vector<magnitude_extremum> extrema;
+
+  for (size_t i{1}; i < grid.size(); ++i) {
+    double slope_lo = magnitude_slope(grid[i - 1]);
+    double slope_hi = magnitude_slope(grid[i]);
+
+    if (slope_lo == 0 || (slope_lo < 0) == (slope_hi < 0)) {
+      continue;
+    }
+
+    sample root = magnitude_slope_root(circ, grid[i - 1], grid[i]);
+
+    // Falling then rising = minimum:
+    resonance_type type = (slope_lo < 0)
+      ? resonance_type::series : resonance_type::parallel;
+
+    extrema.push_back(
+      magnitude_extremum{type, root.frequency, std::abs(root.impedance)});
+  }
+
+  return extrema;
+}
+
+//------------------------------------------------------------------------------
+// Resonances with Q factor and bandwidth:
+//------------------------------------------------------------------------------
+
+std::vector<resonance> circuits::find_resonances(circuit &circ,
+  const double &f_min, const double &f_max, const size_t &samples)
+{
+  std::vector<double> crossings = find_phase_crossings(
+    circ, f_min, f_max, samples);
+
+  frequency_guard guard{circ};
+
+  // Same step size as the sampling grid when searching for band edges:
+  double step_ratio = std::pow(f_max / f_min, 1.0 / (samples - 1));
+
+  std::vector<resonance> resonances;
+
+  for (const auto &f0 : crossings) {
+    sample centre = evaluate_at(circ, f0);
+
+    resonance res{};
+    res.frequency = f0;
+    res.magnitude = std::abs(centre.impedance);
+
+    // Reactance rising through zero = series resonance:
+    bool is_series = centre.derivative.imag() > 0;
+    res.type = is_series ? resonance_type::series : resonance_type::parallel;
+
+    // Half power points:
+    double target = is_series
+      ? (res.magnitude * std::sqrt(2.0)) : (res.magnitude / std::sqrt(2.0));
+
+    double lower{}, upper{};
+    res.edges_found
+      = find_band_edge(circ, f0, target, is_series, step_ratio, f_min, lower)
+      && find_band_edge(circ, f0, target, is_series, step_ratio, f_max, upper);
+
+    if (res.edges_found) {
+      res.lower_frequency = lower;
+      res.upper_frequency = upper;
+      res.bandwidth = upper - lower;
+      res.q_factor = f0 / res.bandwidth;
+
+    } else {
+      // Estimate from the slope, Q = f0 |dZ/df| / (2 |Z|):
+      res.q_factor = f0 * std::abs(centre.derivative) / (2 * res.magnitude);
+      res.bandwidth = f0 / res.q_factor;
+      res.lower_frequency = f0 - (0.5 * res.bandwidth);
+      res.upper_frequency = f0 + (0.5 * res.bandwidth);
+    }
+
+    resonances.push_back(res);
+  }
+
+  return resonances;
+}
+
+//------------------------------------------------------------------------------
+
+// Each circuit owns its (cloned) components, so circuits are independent:
+std::vector<std::vector<resonance>> circuits::find_resonances(
+  const std::vector<std::unique_ptr<circuit>> &circs,
+  const double &f_min, const double &f_max, const size_t &samples)
+{
+  std::vector<std::vector<resonance>> results(circs.size());
+
+  parallel_for(circs.size(), [&](const size_t &i) {
+    results[i] = find_resonances(*circs[i], f_min, f_max, samples);
+  });
+
+  return results;
+}
+
+//------------------------------------------------------------------------------
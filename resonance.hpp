@@ -0,0 +1,75 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Resonance, Q factor and bandwidth analysis of circuits:
+//------------------------------------------------------------------------------
+
+#ifndef resonance_hpp
+#define resonance_hpp
+
+#include "circuit.hpp"
+
+//------------------------------------------------------------------------------
+
+namespace circuits
+{
+  // Series = |Z| minimum (reactance rising), parallel = |Z| maximum:
+  enum class resonance_type {series, parallel};
+
+  struct resonance
+  {
+    resonance_type type;
+
+    // Frequency where the phase crosses zero (Hz):
+    double frequency;
+
+    // |Z| at the resonant frequency (Ohms):
+    double magnitude;
+
+    // Q = f0 / bandwidth:
+    double q_factor;
+
+    // -3 dB bandwidth and its edges (Hz):
+    double bandwidth;
+    double lower_frequency;
+    double upper_frequency;
+
+    // False if an edge lies outside the search range (Q is then estimated):
+    bool edges_found;
+  };
+
+  // Magnitude minimum or maximum of |Z|:
+  struct magnitude_extremum
+  {
+    resonance_type type;
+    double frequency;
+    double magnitude;
+  };
+
+//------------------------------------------------------------------------------
+
+  // Frequencies (Hz) in [f_min, f_max] where the phase of Z crosses zero:
+  // (log spaced samples bracket each crossing, then safeguarded Newton)
+  std::vector<double> find_phase_crossings(circuit &circ,
+    const double &f_min, const double &f_max, const size_t &samples = 200);
+
+  // Frequencies (Hz) in [f_min, f_max] where |Z| has a local min / max:
+  std::vector<magnitude_extremum> find_magnitude_extrema(circuit &circ,
+    const double &f_min, const double &f_max, const size_t &samples = 200);
+
+  // Resonances with Q factor and -3 dB bandwidth:
+  std::vector<resonance> find_resonances(circuit &circ,
+    const double &f_min, const double &f_max, const size_t &samples = 200);
+
+  // Analyses many circuits at once (one circuit per thread at a time):
+  std::vector<std::vector<resonance>> find_resonances(
+    const std::vector<std::unique_ptr<circuit>> &circs,
+    const double &f_min, const double &f_max, const size_t &samples = 200);
+}
+
+//------------------------------------------------------------------------------
+#endif
+//------------------------------------------------------------------------------
@@ -0,0 +1,721 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Tolerance sampling (pseudo random, Latin hypercube, Sobol, Halton) and
+// yield estimates:
+//------------------------------------------------------------------------------
+
+#include "sampling.hpp"
+#include "folded_program.hpp"
+#include "parallel.hpp"
+
+#include <array>
+#include <bit>
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace circuits;
+
+//------------------------------------------------------------------------------
+// Helper functions (only used in this file):
+//------------------------------------------------------------------------------
+
+namespace
+{
+  const sampling_mode all_modes[] = {sampling_mode::pseudo_random,
+    sampling_mode::latin_hypercube, sampling_mode::sobol,
+    sampling_mode::halton};
+
+  // Points per job (generation and evaluation alike):
+  const size_t chunk_size = 1024;
+
+  // splitmix64's finaliser:
+  uint64_t mix(uint64_t x)
+  {
+    x += 0x9e3779b97f4a7c15;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+    return x ^ (x >> 31);
+  }
+
+  uint64_t hash_key(const std::initializer_list<uint64_t> &parts)
+  {
+    uint64_t key{};
+    for (const auto &part : parts) {
+      key = mix(key ^ part);
+    }
+    return key;
+  }
+
+  // Top 53 bits as a double in [0, 1):
+  double to_unit(const uint64_t &bits)
+  {
+    return static_cast<double>(bits >> 11) * 0x1.0p-53;
+  }
+
+  double below_one(const double &u)
+  {
+    return std::min(u, 0x1.fffffffffffffp-1);
+  }
+
+//------------------------------------------------------------------------------
+
+  // Initial direction numbers of Joe and Kuo (new-joe-kuo-6.21201) for
+  // dimensions 2 - 21, in the order of their primitive polynomials:
+  const std::vector<std::vector<uint32_t>> joe_kuo_numbers = {
+    {1}, {1, 3}, {1, 3, 1}, {1, 1, 1}, {1, 1, 3, 3}, {1, 3, 5, 13},
+    {1, 1, 5, 5, 17}, {1, 1, 5, 5, 5}, {1, 1, 7, 11, 19}, {1, 1, 5, 1, 1},
+    {1, 1, 1, 3, 11}, {1, 3, 5, 5, 31}, {1, 3, 3, 9, 7, 49},
+    {1, 1, 1, 15, 21, 21}, {1, 3, 1, 13, 27, 49}, {1, 1, 1, 15, 7, 5},
+    {1, 3, 1, 15, 13, 25}, {1, 1, 5, 5, 19, 61}, {1, 3, 7, 11, 23, 15, 103},
+    {1, 3, 7, 13, 13, 15, 69}};
+
+  // Polynomials over GF(2) as bit masks (bit k = coefficient of x^k):
+  uint64_t multiply_mod(uint64_t a, uint64_t b, const uint64_t &poly,
+    const size_t &degree)
+  {
+    uint64_t product{};
+    while (b != 0) {
+      if (b & 1) {
+        product ^= a;
+      }
+      b >>= 1;
+      a <<= 1;
+      if (a >> degree & 1) {
+        a ^= poly;
+      }
+    }
+    return product;
+  }
+
+  uint64_t power_of_x(uint64_t exponent, const uint64_t &poly,
+    const size_t &degree)
+  {
+    uint64_t result{1};
+    uint64_t base = (degree == 1) ? (2 ^ poly) : 2;
+    while (exponent != 0) {
+      if (exponent & 1) {
+        result = multiply_mod(result, base, poly, degree);
+      }
+      base = multiply_mod(base, base, poly, degree);
+      exponent >>= 1;
+    }
+    return result;
+  }
+
+  // Primitive if x has order 2^degree - 1:
+  bool is_primitive(const uint64_t &poly, const size_t &degree)
+  {
+    uint64_t order = (uint64_t{1} << degree) - 1;
+    if (power_of_x(order, poly, degree) != 1) {
+      return false;
+    }
+
+    uint64_t rest = order;
+    for (uint64_t factor{2}; rest > 1; ++factor) {
+      if (factor * factor > rest) {
+        factor = rest;
+      }
+      if (rest % factor != 0) {
+        continue;
+      }
+      if (power_of_x(order / factor, poly, degree) == 1) {
+        return false;
+      }
+      while (rest % factor == 0) {
+        rest /= factor;
+      }
+    }
+    return true;
+  }
+
+  // Direction numbers v_1 ... v_32 (as 32 bit fractions) of the first
+  // dimensions of the Sobol sequence, dimension 0 being van der Corput's:
+  std::vector<std::array<uint32_t, 32>> sobol_directions(
+    const size_t &dimensions)
+  {
+    std::vector<std::array<uint32_t, 32>> directions;
+    if (dimensions == 0) {
+      return directions;
+    }
+
+    std::array<uint32_t, 32> first;
+    for (size_t k{}; k < 32; ++k) {
+      first[k] = uint32_t{1} << (31 - k);
+    }
+    directions.push_back(first);
+
+    // Polynomials x^s + a_1 x^(s-1) + ... + a_(s-1) x + 1 by degree, then
+    // by a (the a_i as bits, a_1 highest), as Joe and Kuo number them:
+    size_t degree{1};
+    uint64_t a{};
+    while (directions.size() < dimensions) {
+      uint64_t poly = (uint64_t{1} << degree) | (a << 1) | 1;
+      size_t s = degree;
+      if (++a == (uint64_t{1} << (degree - 1))) {
+        ++degree;
+        a = 0;
+      }
+      if (!is_primitive(poly, s)) {
+        continue;
+      }
+
+      // m_k odd and below 2^k (past Joe and Kuo's table, any such do):
+      size_t dim = directions.size();
+      std::array<uint64_t, 33> m{};
+      for (size_t k{1}; k <= s; ++k) {
+        if (dim - 1 < joe_kuo_numbers.size()) {
+          m[k] = joe_kuo_numbers[dim - 1][k - 1];
+        } else {
+          m[k] = (hash_key({dim, k}) & ((uint64_t{1} << k) - 1)) | 1;
+        }
+      }
+
+      // m_k = 2 a_1 m_(k-1) ^ 4 a_2 m_(k-2) ^ ... ^ 2^s m_(k-s) ^ m_(k-s):
+      for (size_t k{s + 1}; k <= 32; ++k) {
+        m[k] = (m[k - s] << s) ^ m[k - s];
+        for (size_t i{1}; i < s; ++i) {
+          if ((poly >> (s - i)) & 1) {
+            m[k] ^= m[k - i] << i;
+          }
+        }
+      }
+
+      std::array<uint32_t, 32> v;
+      for (size_t k{1}; k <= 32; ++k) {
+        v[k - 1] = static_cast<uint32_t>(m[k] << (32 - k));
+      }
+      directions.push_back(v);
+    }
+
+    return directions;
+  }
+
+  uint32_t reverse_bits(uint32_t x)
+  {
+    x = ((x >> 1) & 0x55555555) | ((x & 0x55555555) << 1);
+    x = ((x >> 2) & 0x33333333) | ((x & 0x33333333) << 2);
+    x = ((x >> 4) & 0x0f0f0f0f) | ((x & 0x0f0f0f0f) << 4);
+    x = ((x >> 8) & 0x00ff00ff) | ((x & 0x00ff00ff) << 8);
+    return (x >> 16) | (x << 16);
+  }
+
+  // Burley's nested uniform (Owen) scramble: in bit reversed order every bit
+  // is flipped by a hash of the bits below it, i.e. of the digits above it:
+  uint32_t owen_scramble(uint32_t x, const uint32_t &seed)
+  {
+    x = reverse_bits(x);
+    x += seed;
+    x ^= x * 0x6c50b47c;
+    x ^= x * 0xb82f1e52;
+    x ^= x * 0xc7afe638;
+    x ^= x * 0x8d22f6e6;
+    return reverse_bits(x);
+  }
+
+//------------------------------------------------------------------------------
+
+  std::vector<uint32_t> first_primes(const size_t &count)
+  {
+    std::vector<uint32_t> primes;
+    for (uint32_t n{2}; primes.size() < count; ++n) {
+      bool prime{true};
+      for (const auto &p : primes) {
+        if (p * p > n) {
+          break;
+        }
+        if (n % p == 0) {
+          prime = false;
+          break;
+        }
+      }
+      if (prime) {
+        primes.push_back(n);
+      }
+    }
+    return primes;
+  }
+
+  // Digit d goes to (scale x d + shift) mod base:
+  struct digit_map
+  {
+    uint32_t scale;
+    uint32_t shift;
+  };
+
+  // Kensler's hashed permutation of [0, length) (cycle walking a bijection
+  // of the next power of 2 up):
+  uint64_t permute(uint32_t i, const uint64_t &length, const uint32_t &key)
+  {
+    uint32_t w = static_cast<uint32_t>(length - 1);
+    w |= w >> 1;
+    w |= w >> 2;
+    w |= w >> 4;
+    w |= w >> 8;
+    w |= w >> 16;
+
+    do {
+      i ^= key;
+      i *= 0xe170893d;
+      i ^= key >> 16;
+      i ^= (i & w) >> 4;
+      i ^= key >> 8;
+      i *= 0x0929eb3f;
+      i ^= key >> 23;
+      i ^= (i & w) >> 1;
+      i *= 1 | key >> 27;
+      i *= 0x6935fa69;
+      i ^= (i & w) >> 11;
+      i *= 0x74dcb303;
+      i ^= (i & w) >> 2;
+      i *= 0x9e501cc3;
+      i ^= (i & w) >> 2;
+      i *= 0xc860a3df;
+      i &= w;
+      i ^= i >> 5;
+    } while (i >= length);
+
+    return (i + uint64_t{key}) % length;
+  }
+
+//------------------------------------------------------------------------------
+
+  class point_sampler
+  {
+  private:
+    sampling_mode mode;
+    size_t dimensions;
+    uint64_t seed;
+
+    std::vector<std::array<uint32_t, 32>> directions;
+
+    // Halton bases, and each (replicate, dimension)'s digit maps from
+    // digit_start[replicate x dimensions + dimension] on:
+    std::vector<uint32_t> bases;
+    std::vector<size_t> digit_start;
+    std::vector<digit_map> digit_maps;
+
+  public:
+    point_sampler(const sampling_mode &mode, const size_t &dimensions,
+      const uint64_t &seed, const size_t &replicates)
+      : mode{mode}, dimensions{dimensions}, seed{seed}
+    {
+      if (mode == sampling_mode::sobol) {
+        directions = sobol_directions(dimensions);
+      }
+      if (mode != sampling_mode::halton) {
+        return;
+      }
+
+      // Enough digits to fill a double:
+      bases = first_primes(dimensions);
+      for (size_t r{}; r < replicates; ++r) {
+        for (size_t d{}; d < dimensions; ++d) {
+          digit_start.push_back(digit_maps.size());
+          double scale{1.0};
+          for (size_t k{}; scale > 0x1.0p-53; ++k) {
+            uint64_t key = hash_key({seed, r, d, k});
+            uint32_t base = bases[d];
+            digit_maps.push_back(digit_map{
+              1 + static_cast<uint32_t>((key >> 32) % (base - 1)),
+              static_cast<uint32_t>((key & 0xffffffff) % base)});
+            scale /= base;
+          }
+        }
+      }
+      digit_start.push_back(digit_maps.size());
+    }
+
+    // Point index of a replicate. Sequences run on over the rounds, Latin
+    // hypercubes are a new design of design_size points each round:
+    void get_point(const size_t &replicate, const size_t &round,
+      const size_t &design_size, const size_t &index, double *point) const
+    {
+      for (size_t d{}; d < dimensions; ++d) {
+        switch (mode) {
+          case sampling_mode::pseudo_random:
+            point[d] = to_unit(hash_key({seed, replicate, index, d}));
+            break;
+
+          case sampling_mode::latin_hypercube: {
+            uint64_t key = hash_key({seed, replicate, round, d});
+            uint64_t stratum = permute(static_cast<uint32_t>(index),
+              design_size, static_cast<uint32_t>(key));
+            double offset = to_unit(hash_key({key, index}));
+            point[d] = below_one((stratum + offset) / design_size);
+            break;
+          }
+
+          case sampling_mode::sobol: {
+            uint32_t x{};
+            for (size_t bits = index, k{}; bits != 0; bits >>= 1, ++k) {
+              if (bits & 1) {
+                x ^= directions[d][k];
+              }
+            }
+
+            uint64_t key = hash_key({seed, replicate, d});
+            x = owen_scramble(x, static_cast<uint32_t>(key));
+            double low = to_unit(hash_key({key, index}));
+            point[d] = below_one((x + low) * 0x1.0p-32);
+            break;
+          }
+
+          case sampling_mode::halton: {
+            uint32_t base = bases[d];
+            size_t at = digit_start[(replicate * dimensions) + d];
+            size_t end = digit_start[(replicate * dimensions) + d + 1];
+
+            double u{};
+            double scale = 1.0 / base;
+            for (size_t rest{index}; at < end; ++at) {
+              uint64_t digit = rest % base;
+              rest /= base;
+              const digit_map &map = digit_maps[at];
+              u += ((map.scale * digit + map.shift) % base) * scale;
+              scale /= base;
+            }
+            point[d] = below_one(u);
+            break;
+          }
+        }
+      }
+    }
+  };
+
+//------------------------------------------------------------------------------
+
+  struct varied_part
+  {
+    flat_component part;
+    double value;
+    double relative;
+  };
+
+  // Impedance with the value at u (0 = bottom of its range, 1 = top):
+  std::complex<double> varied_impedance(const varied_part &varied,
+    const double &u, const double &omega)
+  {
+    double value = varied.value * (1.0 + (varied.relative * (2 * u - 1)));
+    return std::visit([&](auto part) {
+      set_flat_value(part, value);
+      return flat_impedance(part, omega);
+    }, varied.part);
+  }
+
+//------------------------------------------------------------------------------
+
+  struct compiled_limit
+  {
+    impedance_limits limits;
+    double omega;
+    std::vector<folded_step> program;
+  };
+
+  // Scratch space of one job:
+  struct workspace
+  {
+    std::vector<double> point;
+    std::vector<std::complex<double>> parts;
+    std::vector<level_sums<std::complex<double>>> levels{1};
+  };
+
+  std::complex<double> run_program(const std::vector<folded_step> &program,
+    workspace &space)
+  {
+    std::vector<level_sums<std::complex<double>>> &levels = space.levels;
+    size_t depth{};
+    levels[0] = {};
+
+    for (const auto &s : program) {
+      std::complex<double> z;
+      switch (s.type) {
+        case folded_step_type::fixed:
+          start_run(levels[depth], s.conn);
+          levels[depth].sum += s.term;
+          continue;
+
+        case folded_step_type::part:
+          z = space.parts[s.index];
+          break;
+
+        case folded_step_type::begin:
+          ++depth;
+          if (depth == levels.size()) {
+            levels.emplace_back();
+          }
+          levels[depth] = {};
+          continue;
+
+        // The sub circuit's total is then added to its parent as a part:
+        case folded_step_type::end:
+          close_run(levels[depth]);
+          z = levels[depth].closed;
+          --depth;
+          break;
+      }
+
+      start_run(levels[depth], s.conn);
+      levels[depth].sum += (s.conn == 'p') ? (1.0 / z) : z;
+    }
+
+    close_run(levels[0]);
+    return levels[0].closed;
+  }
+
+  // True if the circuit at the point in space.point meets every limit:
+  bool passes(const std::vector<compiled_limit> &compiled,
+    const std::vector<varied_part> &parts, workspace &space)
+  {
+    for (const auto &limit : compiled) {
+      for (size_t k{}; k < parts.size(); ++k) {
+        space.parts[k] = varied_impedance(parts[k], space.point[k],
+          limit.omega);
+      }
+
+      std::complex<double> z = run_program(limit.program, space);
+      double magnitude = std::abs(z);
+      double phase = std::arg(z);
+      const impedance_limits &l = limit.limits;
+      if (!(magnitude >= l.min_magnitude && magnitude <= l.max_magnitude
+        && phase >= l.min_phase && phase <= l.max_phase)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+//------------------------------------------------------------------------------
+
+  // Two sided 95% quantile of Student's t (Cornish-Fisher past 10 degrees of
+  // freedom, within 2e-3 there):
+  double t_quantile(const size_t &freedom)
+  {
+    const double table[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447,
+      2.365, 2.306, 2.262, 2.228};
+    if (freedom <= 10) {
+      return table[freedom - 1];
+    }
+
+    double z = 1.959964;
+    double n = static_cast<double>(freedom);
+    return z + ((z * z * z + z) / (4 * n))
+      + ((5 * std::pow(z, 5) + 16 * z * z * z + 3 * z) / (96 * n * n));
+  }
+}
+
+//------------------------------------------------------------------------------
+
+std::string circuits::get_sampling_name(const sampling_mode &mode)
+{
+  switch (mode) {
+    case sampling_mode::pseudo_random: return "pseudo_random";
+    case sampling_mode::latin_hypercube: return "latin_hypercube";
+    case sampling_mode::sobol: return "sobol";
+    case sampling_mode::halton: return "halton";
+  }
+  return "unknown";
+}
+
+sampling_mode circuits::parse_sampling_name(const std::string &name)
+{
+  for (const auto &mode : all_modes) {
+    if (get_sampling_name(mode) == name) {
+      return mode;
+    }
+  }
+  throw std::invalid_argument{"Unknown sampling mode " + name + "."};
+}
+
+//------------------------------------------------------------------------------
+
+std::vector<double> circuits::generate_samples(const sampling_mode &mode,
+  const size_t &count, const size_t &dimensions, const uint64_t &seed,
+  const size_t &threads)
+{
+  if (count > max_sample_points) {
+    throw std::out_of_range{"At most 2^32 points can be sampled at once."};
+  }
+
+  point_sampler sampler{mode, dimensions, seed, 1};
+  std::vector<double> points(count * dimensions);
+
+  size_t chunks = (count + chunk_size - 1) / chunk_size;
+  parallel_for(chunks, [&](const size_t &chunk) {
+    size_t end = std::min(count, (chunk + 1) * chunk_size);
+    for (size_t i{chunk * chunk_size}; i < end; ++i) {
+      sampler.get_point(0, 0, count, i, &points[i * dimensions]);
+    }
+  }, threads);
+
+  return points;
+}
+
+//------------------------------------------------------------------------------
+
+yield_estimate circuits::estimate_yield(const circuit &circ,
+  const std::vector<component_tolerance> &tolerances,
+  const std::vector<impedance_limits> &limits, const yield_options &options)
+{
+  if (limits.empty()) {
+    throw std::invalid_argument{"Yield needs at least one limit."};
+  }
+  if (options.replicates < 2) {
+    throw std::invalid_argument{"Yield needs at least 2 replicates (for "
+      "its standard error)."};
+  }
+  for (const auto &l : limits) {
+    if (!(l.frequency > 0.0)) {
+      throw std::out_of_range{"Yield limits need a positive frequency."};
+    }
+    if (!(l.min_magnitude <= l.max_magnitude && l.min_phase <= l.max_phase)) {
+      throw std::invalid_argument{"Yield limits are empty or reversed."};
+    }
+  }
+
+  std::unordered_map<const component *, size_t> tolerance_index;
+  std::vector<const component *> toleranced = check_tolerances(circ,
+    tolerances, tolerance_index);
+
+  std::vector<varied_part> parts;
+  for (size_t k{}; k < tolerances.size(); ++k) {
+    parts.push_back(varied_part{make_flat_component(*toleranced[k]),
+      toleranced[k]->get_value(), tolerances[k].relative});
+  }
+
+  std::vector<compiled_limit> compiled;
+  for (const auto &l : limits) {
+    compiled.push_back(compiled_limit{l, 2 * M_PI * l.frequency, {}});
+    compile_folded(circ, tolerance_index, l.frequency,
+      compiled.back().program);
+  }
+
+  size_t replicates = options.replicates;
+  size_t dimensions = parts.size();
+  point_sampler sampler{options.mode, dimensions, options.seed, replicates};
+
+  yield_estimate estimate{};
+  std::vector<size_t> passed(replicates);
+  size_t per_replicate{};
+  size_t round{};
+
+  while (true) {
+    // First round, then as many points as all before:
+    size_t added = (round == 0)
+      ? std::bit_ceil(std::max<size_t>(options.first_samples, 1))
+      : per_replicate;
+    if (round > 0 && ((per_replicate + added) * replicates
+      > options.max_samples || per_replicate + added > max_sample_points)) {
+      break;
+    }
+    added = std::min(added, max_sample_points);
+
+    size_t chunks = (added + chunk_size - 1) / chunk_size;
+    std::vector<size_t> job_passes(replicates * chunks);
+
+    parallel_for(replicates * chunks, [&](const size_t &job) {
+      size_t replicate = job / chunks;
+      size_t begin = (job % chunks) * chunk_size;
+      size_t end = std::min(added, begin + chunk_size);
+
+      workspace space;
+      space.point.resize(dimensions);
+      space.parts.resize(dimensions);
+
+      size_t count{};
+      for (size_t i{begin}; i < end; ++i) {
+        if (options.mode == sampling_mode::latin_hypercube) {
+          sampler.get_point(replicate, round, added, i, space.point.data());
+        } else {
+          sampler.get_point(replicate, round, added, per_replicate + i,
+            space.point.data());
+        }
+        count += passes(compiled, parts, space);
+      }
+      job_passes[job] = count;
+    }, options.threads);
+
+    for (size_t job{}; job < job_passes.size(); ++job) {
+      passed[job / chunks] += job_passes[job];
+    }
+    per_replicate += added;
+    ++round;
+
+    // Replicate yields, their mean and standard error:
+    double n = static_cast<double>(per_replicate);
+    double mean{};
+    size_t total_passed{};
+    for (const auto &p : passed) {
+      mean += p / n;
+      total_passed += p;
+    }
+    mean /= replicates;
+
+    double spread{};
+    for (const auto &p : passed) {
+      spread += (p / n - mean) * (p / n - mean);
+    }
+    double error = std::sqrt(spread / (replicates - 1) / replicates);
+
+    size_t samples = per_replicate * replicates;
+    double half = t_quantile(replicates - 1) * error;
+    double lower = mean - half;
+    double upper = mean + half;
+    if (total_passed == samples) {
+      lower = std::min(lower, 1.0 - (3.0 / samples));
+    }
+    if (total_passed == 0) {
+      upper = std::max(upper, 3.0 / samples);
+    }
+    lower = std::max(lower, 0.0);
+    upper = std::min(upper, 1.0);
+
+    estimate.yield = mean;
+    estimate.standard_error = error;
+    estimate.lower = lower;
+    estimate.upper = upper;
+    estimate.samples = samples;
+    estimate.rounds.push_back(yield_round{samples, mean, error,
+      0.5 * (upper - lower)});
+
+    if (options.target_half_width > 0.0
+      && 0.5 * (upper - lower) <= options.target_half_width) {
+      estimate.converged = true;
+      break;
+    }
+  }
+
+  double y = estimate.yield;
+  estimate.efficiency = std::numeric_limits<double>::quiet_NaN();
+  if (y > 0.0 && y < 1.0) {
+    estimate.efficiency = (y * (1.0 - y) / estimate.samples)
+      / (estimate.standard_error * estimate.standard_error);
+  }
+
+  // Least squares slope over the rounds with a nonzero error:
+  double sx{}, sy{}, sxx{}, sxy{};
+  size_t fitted{};
+  for (const auto &r : estimate.rounds) {
+    if (r.standard_error > 0.0) {
+      double x = std::log(static_cast<double>(r.samples));
+      double e = std::log(r.standard_error);
+      sx += x;
+      sy += e;
+      sxx += x * x;
+      sxy += x * e;
+      ++fitted;
+    }
+  }
+  estimate.convergence_rate = std::numeric_limits<double>::quiet_NaN();
+  if (fitted >= 2) {
+    estimate.convergence_rate = ((fitted * sxy) - (sx * sy))
+      / ((fitted * sxx) - (sx * sx));
+  }
+
+  return estimate;
+}
+
+//------------------------------------------------------------------------------
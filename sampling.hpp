@@ -0,0 +1,159 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Tolerance sampling (pseudo random, Latin hypercube, Sobol, Halton) and
+// yield estimates:
+//------------------------------------------------------------------------------
+
+#ifndef sampling_hpp
+#define sampling_hpp
+
+#include "corners.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+//------------------------------------------------------------------------------
+// Every coordinate of every point is a function of (seed, replicate, index,
+// dimension) only, so points can be made in any order on any number of
+// threads and come out the same:
+// - pseudo_random: a hash of those (a counter based generator),
+// - latin_hypercube: each dimension is a hashed permutation of the design's
+//   n strata, with a hashed offset inside the stratum,
+// - sobol: Joe and Kuo's direction numbers (arbitrary odd ones past
+//   dimension 21), Owen scrambled by hashing (Burley's nested uniform
+//   scramble),
+// - halton: radical inverses in the first primes, each digit put through its
+//   own random linear map (which also breaks up the correlation between
+//   dimensions of nearby primes).
+//
+// A yield estimate evaluates the circuit at each point of several
+// independent randomisations (replicates) of the design. The spread of their
+// yields gives the standard error, so the confidence interval is honest for
+// every mode (quasi random points have no variance formula of their own).
+// Each round doubles the points of every replicate: sequences carry on where
+// they left off, Latin hypercubes add a fresh design as large as all before.
+// The circuit is compiled once per frequency (parts without a tolerance
+// folded to fixed values), leaving a handful of steps per point.
+//------------------------------------------------------------------------------
+
+namespace circuits
+{
+  enum class sampling_mode
+  {
+    pseudo_random,
+    latin_hypercube,
+    sobol,
+    halton
+  };
+
+  // Name used in reports / on the command line, e.g. "sobol":
+  std::string get_sampling_name(const sampling_mode &mode);
+
+  // Throws std::invalid_argument for an unknown name:
+  sampling_mode parse_sampling_name(const std::string &name);
+
+  // Most points of one design / replicate:
+  const size_t max_sample_points = size_t{1} << 32;
+
+  // A pass if the impedance at frequency (Hz) has magnitude and phase
+  // (radians) within these (inclusive):
+  struct impedance_limits
+  {
+    double frequency;
+
+    double min_magnitude = 0.0;
+    double max_magnitude = std::numeric_limits<double>::infinity();
+    double min_phase = -M_PI;
+    double max_phase = M_PI;
+  };
+
+  struct yield_options
+  {
+    sampling_mode mode = sampling_mode::sobol;
+    uint64_t seed = 0;
+
+    // Independent randomisations of the design (at least 2):
+    size_t replicates = 16;
+
+    // Points per replicate in the first round (rounded up to a power of 2):
+    size_t first_samples = 256;
+
+    // Stops once the 95% confidence interval is at most +/- this (0 = run
+    // to max_samples), or before a round would take more evaluations than
+    // max_samples (over all replicates):
+    double target_half_width = 1e-3;
+    size_t max_samples = size_t{1} << 22;
+
+    // 0 = one per core:
+    size_t threads = 0;
+  };
+
+  // The estimate after one round:
+  struct yield_round
+  {
+    size_t samples;
+    double yield;
+    double standard_error;
+    double half_width;
+  };
+
+  struct yield_estimate
+  {
+    // Mean over the replicates, its standard error, and 95% confidence
+    // interval (t interval over the replicates, at least the rule of three
+    // if no point failed / passed, clipped to [0, 1]):
+    double yield;
+    double standard_error;
+    double lower;
+    double upper;
+
+    // Points evaluated (each at every frequency of the limits):
+    size_t samples;
+
+    // Convergence diagnostics:
+    // - efficiency: variance plain Monte Carlo would have at this many points
+    //   over the variance found, i.e. how many times fewer points it took
+    //   (about 1 for pseudo_random, NaN if every point passed or every
+    //   point failed),
+    // - convergence_rate: slope of log(standard error) against log(samples)
+    //   over the rounds (-0.5 for plain Monte Carlo, towards -1 for quasi
+    //   random points; NaN with fewer than 2 rounds of nonzero error):
+    double efficiency;
+    double convergence_rate;
+    std::vector<yield_round> rounds;
+
+    // True if the target half width was met:
+    bool converged;
+  };
+
+//------------------------------------------------------------------------------
+
+  // count points of one randomisation (by seed) in [0, 1)^dimensions, point
+  // i at [i x dimensions, (i + 1) x dimensions). For latin_hypercube the
+  // points are one design of count strata. Split across threads (0 = one per
+  // core):
+  std::vector<double> generate_samples(const sampling_mode &mode,
+    const size_t &count, const size_t &dimensions, const uint64_t &seed,
+    const size_t &threads = 0);
+
+  // Fraction of the circuits with every toleranced value uniform within its
+  // tolerance (as find_worst_corners(), a point's coordinate k taking
+  // tolerance k from its bottom to its top) that meet every limit. Throws
+  // std::out_of_range for a frequency that isn't positive, and
+  // std::invalid_argument for empty or reversed limits or fewer than 2
+  // replicates:
+  yield_estimate estimate_yield(const circuit &circ,
+    const std::vector<component_tolerance> &tolerances,
+    const std::vector<impedance_limits> &limits,
+    const yield_options &options = yield_options{});
+}
+
+//------------------------------------------------------------------------------
+#endif
+//------------------------------------------------------------------------------
@@ -0,0 +1,604 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Evaluation server on a Unix domain socket (batched, thread pooled):
+//------------------------------------------------------------------------------
+
+#include "server.hpp"
+#include "netlist.hpp"
+
+#include <cstring>
+#include <sstream>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+//------------------------------------------------------------------------------
+// Helper functions (only used in this file):
+//------------------------------------------------------------------------------
+
+namespace
+{
+  using namespace circuits;
+  using server_clock = std::chrono::steady_clock;
+
+  sockaddr_un socket_address(const std::string &path)
+  {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+
+    if (path.size() >= sizeof(address.sun_path)) {
+      throw std::invalid_argument{"Socket path is too long: " + path};
+    }
+
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return address;
+  }
+
+  // Writes all of text (no SIGPIPE if the client has gone):
+  bool send_all(const int &descriptor, const std::string &text)
+  {
+    size_t sent{};
+    while (sent < text.size()) {
+      ssize_t count = ::send(descriptor, text.data() + sent,
+        text.size() - sent, MSG_NOSIGNAL);
+
+      if (count <= 0) {
+        return false;
+      }
+      sent += static_cast<size_t>(count);
+    }
+
+    return true;
+  }
+
+  // Buffered line reader over a socket:
+  class line_reader
+  {
+  private:
+    int descriptor;
+    std::string buffer;
+    size_t position = 0;
+
+  public:
+    line_reader(const int &d) : descriptor{d} {}
+
+    bool read_line(std::string &line)
+    {
+      while (true) {
+        size_t end = buffer.find('\n', position);
+
+        if (end != std::string::npos) {
+          line.assign(buffer, position, end - position);
+          position = end + 1;
+
+          if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+          }
+          return true;
+        }
+
+        // Drop what has been used before reading more:
+        buffer.erase(0, position);
+        position = 0;
+
+        char chunk[4096];
+        ssize_t count = ::recv(descriptor, chunk, sizeof(chunk), 0);
+
+        if (count <= 0) {
+          // Last line without a newline:
+          if (!buffer.empty()) {
+            line = buffer;
+            buffer.clear();
+            return true;
+          }
+          return false;
+        }
+
+        buffer.append(chunk, static_cast<size_t>(count));
+      }
+    }
+  };
+
+//------------------------------------------------------------------------------
+
+  // Reads netlist lines up to END:
+  std::string read_netlist(line_reader &reader)
+  {
+    std::string netlist;
+    std::string line;
+
+    while (reader.read_line(line)) {
+      if (line == "END") {
+        return netlist;
+      }
+      netlist += line;
+      netlist += '\n';
+    }
+
+    throw std::invalid_argument{"Netlist ended without END."};
+  }
+
+  std::vector<double> read_frequencies(std::istringstream &fields)
+  {
+    std::vector<double> frequencies;
+    std::string field;
+
+    while (fields >> field) {
+      double freq = parse_spice_value(field);
+
+      if (freq < 0.0) {
+        throw std::out_of_range{"Cannot have negative frequency."};
+      }
+      frequencies.push_back(freq);
+    }
+
+    if (frequencies.empty()) {
+      throw std::invalid_argument{"No frequencies given."};
+    }
+
+    return frequencies;
+  }
+
+  std::string format_impedances(const std::vector<double> &frequencies,
+    const std::vector<std::complex<double>> &impedances, const double &latency)
+  {
+    std::string reply = "OK " + std::to_string(frequencies.size()) + " "
+      + std::to_string(static_cast<long long>(latency)) + "\n";
+
+    char line[96];
+    for (size_t i{}; i < frequencies.size(); ++i) {
+      int length = std::snprintf(line, sizeof(line), "%.17g %.17g %.17g\n",
+        frequencies[i], impedances[i].real(), impedances[i].imag());
+      reply.append(line, static_cast<size_t>(length));
+    }
+
+    return reply;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Constructors and destructors:
+//------------------------------------------------------------------------------
+
+// Parameterised constructor:
+evaluation_server::evaluation_server(const server_options &opts)
+  : options{opts}, pool{opts.threads}
+{
+  if (options.max_batch == 0 || options.chunk_size == 0) {
+    throw std::out_of_range{"Batch and chunk sizes must be above 0."};
+  }
+
+  latencies.reserve(latency_history);
+}
+
+// Destructor:
+evaluation_server::~evaluation_server()
+{
+  stop();
+}
+
+//------------------------------------------------------------------------------
+// Starting / stopping:
+//------------------------------------------------------------------------------
+
+void evaluation_server::start()
+{
+  if (running) {
+    return;
+  }
+
+  sockaddr_un address = socket_address(options.socket_path);
+
+  listen_descriptor = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listen_descriptor < 0) {
+    throw std::runtime_error{"Could not create socket."};
+  }
+
+  // Left over from a previous run:
+  ::unlink(options.socket_path.c_str());
+
+  if (::bind(listen_descriptor, reinterpret_cast<sockaddr *>(&address),
+      sizeof(address)) != 0
+    || ::listen(listen_descriptor, 64) != 0) {
+    ::close(listen_descriptor);
+    listen_descriptor = -1;
+    throw std::runtime_error{"Could not listen on " + options.socket_path};
+  }
+
+  running = true;
+  batch_thread = std::thread{[this]() { batch_loop(); }};
+  accept_thread = std::thread{[this]() { accept_loop(); }};
+}
+
+//------------------------------------------------------------------------------
+
+void evaluation_server::stop()
+{
+  if (!running.exchange(false)) {
+    return;
+  }
+
+  // Wakes accept() up:
+  ::shutdown(listen_descriptor, SHUT_RDWR);
+  accept_thread.join();
+  ::close(listen_descriptor);
+  listen_descriptor = -1;
+  ::unlink(options.socket_path.c_str());
+
+  // Wakes clients blocked in recv() up:
+  {
+    std::lock_guard<std::mutex> lock{connections_mutex};
+    for (const auto &descriptor : connection_descriptors) {
+      ::shutdown(descriptor, SHUT_RDWR);
+    }
+  }
+
+  // Batch thread finishes what is queued first:
+  {
+    std::lock_guard<std::mutex> lock{queue_mutex};
+  }
+  queue_ready.notify_all();
+  batch_thread.join();
+
+  std::unique_lock<std::mutex> lock{connections_mutex};
+  connections_done.wait(lock, [&]() { return active_connections == 0; });
+}
+
+bool evaluation_server::is_running() const
+{
+  return running;
+}
+
+//------------------------------------------------------------------------------
+// Definitions:
+//------------------------------------------------------------------------------
+
+void evaluation_server::define(const std::string &name, const circuit &circ)
+{
+  auto definition = std::make_shared<const circuit>(circ);
+
+  std::unique_lock<std::shared_mutex> lock{definitions_mutex};
+  definitions[name] = definition;
+}
+
+void evaluation_server::undefine(const std::string &name)
+{
+  std::unique_lock<std::shared_mutex> lock{definitions_mutex};
+  definitions.erase(name);
+}
+
+//------------------------------------------------------------------------------
+// Threads:
+//------------------------------------------------------------------------------
+
+void evaluation_server::accept_loop()
+{
+  while (running) {
+    int descriptor = ::accept(listen_descriptor, nullptr, nullptr);
+
+    if (descriptor < 0) {
+      if (!running) {
+        return;
+      }
+      continue;
+    }
+
+    std::lock_guard<std::mutex> lock{connections_mutex};
+    connection_descriptors.push_back(descriptor);
+    ++active_connections;
+
+    std::thread{[this, descriptor]() { serve_connection(descriptor); }}.detach();
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void evaluation_server::batch_loop()
+{
+  std::unique_lock<std::mutex> lock{queue_mutex};
+
+  while (true) {
+    queue_ready.wait(lock, [&]() { return !running || !queue.empty(); });
+
+    if (queue.empty()) {
+      return;
+    }
+
+    // Give other clients a moment to join this batch:
+    queue_ready.wait_for(lock, options.batch_window, [&]() {
+      return !running || queue.size() >= options.max_batch;
+    });
+
+    std::vector<std::shared_ptr<pending_evaluation>> batch;
+    while (!queue.empty() && batch.size() < options.max_batch) {
+      batch.push_back(queue.front());
+      queue.pop_front();
+    }
+
+    lock.unlock();
+    evaluate_batch(batch);
+    lock.lock();
+  }
+}
+
+//------------------------------------------------------------------------------
+
+// Splits every request into chunks and shares them across the pool:
+void evaluation_server::evaluate_batch(
+  std::vector<std::shared_ptr<pending_evaluation>> &batch)
+{
+  std::vector<std::pair<size_t, size_t>> chunks;
+
+  for (size_t i{}; i < batch.size(); ++i) {
+    batch[i]->impedances.resize(batch[i]->frequencies.size());
+
+    for (size_t start{}; start < batch[i]->frequencies.size();
+      start += options.chunk_size) {
+      chunks.emplace_back(i, start);
+    }
+  }
+
+  try {
+    pool.run(chunks.size(), [&](const size_t &c) {
+      pending_evaluation &job = *batch[chunks[c].first];
+      size_t start = chunks[c].second;
+      size_t end = std::min(start + options.chunk_size, job.frequencies.size());
+
+      // Definitions are shared, evaluate() leaves them unchanged:
+      for (size_t i{start}; i < end; ++i) {
+        job.impedances[i] = job.circ->evaluate(job.frequencies[i]);
+      }
+    });
+
+    for (auto &job : batch) {
+      job->done.set_value();
+    }
+  }
+  catch (...) {
+    for (auto &job : batch) {
+      job->done.set_exception(std::current_exception());
+    }
+  }
+
+  std::lock_guard<std::mutex> lock{metrics_mutex};
+  ++totals.batches;
+}
+
+//------------------------------------------------------------------------------
+
+std::vector<std::complex<double>> evaluation_server::evaluate(
+  const std::shared_ptr<const circuit> &circ,
+  const std::vector<double> &frequencies)
+{
+  auto job = std::make_shared<pending_evaluation>();
+  job->circ = circ;
+  job->frequencies = frequencies;
+  std::future<void> done = job->done.get_future();
+
+  {
+    std::lock_guard<std::mutex> lock{queue_mutex};
+
+    // Batch thread may already have drained the queue for the last time:
+    if (!running) {
+      throw std::runtime_error{"Server is stopping."};
+    }
+    queue.push_back(job);
+  }
+  queue_ready.notify_all();
+
+  done.get();
+  return std::move(job->impedances);
+}
+
+//------------------------------------------------------------------------------
+
+void evaluation_server::serve_connection(const int &descriptor)
+{
+  line_reader reader{descriptor};
+  std::string line;
+
+  while (running && reader.read_line(line)) {
+    auto received = server_clock::now();
+
+    std::istringstream fields{line};
+    std::string command;
+    fields >> command;
+
+    if (command.empty()) {
+      continue;
+    }
+
+    if (command == "QUIT") {
+      break;
+    }
+
+    std::string reply;
+
+    try {
+      if (command == "DEFINE") {
+        std::string name;
+        if (!(fields >> name)) {
+          throw std::invalid_argument{"DEFINE needs a name."};
+        }
+
+        std::unique_ptr<circuit> circ = parse_netlist(read_netlist(reader));
+        size_t size = static_cast<size_t>(circ->get_size());
+        define(name, *circ);
+
+        reply = "OK defined " + name + " " + std::to_string(size) + "\n";
+
+      } else if (command == "UNDEFINE") {
+        std::string name;
+        fields >> name;
+        undefine(name);
+
+        reply = "OK\n";
+
+      } else if (command == "EVAL" || command == "CIRCUIT") {
+        std::shared_ptr<const circuit> circ;
+
+        if (command == "EVAL") {
+          std::string name;
+          fields >> name;
+
+          std::shared_lock<std::shared_mutex> lock{definitions_mutex};
+          auto found = definitions.find(name);
+          if (found == definitions.end()) {
+            throw std::invalid_argument{"Unknown circuit " + name};
+          }
+          circ = found->second;
+        }
+
+        std::vector<double> frequencies = read_frequencies(fields);
+
+        if (!circ) {
+          circ = parse_netlist(read_netlist(reader));
+        }
+
+        std::vector<std::complex<double>> impedances
+          = evaluate(circ, frequencies);
+
+        double latency = std::chrono::duration<double, std::micro>(
+          server_clock::now() - received).count();
+        record_latency(latency, frequencies.size());
+
+        reply = format_impedances(frequencies, impedances, latency);
+
+      } else if (command == "STATS") {
+        server_metrics metrics = get_metrics();
+
+        std::ostringstream stats;
+        stats << "OK requests " << metrics.requests
+        << " batches " << metrics.batches
+        << " frequencies " << metrics.frequencies
+        << " mean_us " << metrics.mean_latency
+        << " p50_us " << metrics.p50_latency
+        << " p99_us " << metrics.p99_latency
+        << " max_us " << metrics.max_latency << "\n";
+        reply = stats.str();
+
+      } else {
+        throw std::invalid_argument{"Unknown command " + command};
+      }
+    }
+    catch (const std::exception &e) {
+      reply = std::string{"ERROR "} + e.what() + "\n";
+    }
+
+    if (!send_all(descriptor, reply)) {
+      break;
+    }
+  }
+
+  // Forgotten before it's closed: once closed, accept() can hand out the
+  // same number to a new connection, which stop() must still shut down:
+  std::lock_guard<std::mutex> lock{connections_mutex};
+  connection_descriptors.erase(std::find(connection_descriptors.begin(),
+    connection_descriptors.end(), descriptor));
+  ::close(descriptor);
+
+  --active_connections;
+  connections_done.notify_all();
+}
+
+//------------------------------------------------------------------------------
+// Metrics:
+//------------------------------------------------------------------------------
+
+void evaluation_server::record_latency(
+  const double &latency, const size_t &frequencies)
+{
+  std::lock_guard<std::mutex> lock{metrics_mutex};
+
+  totals.mean_latency = ((totals.mean_latency * totals.requests) + latency)
+    / (totals.requests + 1);
+  totals.max_latency = std::max(totals.max_latency, latency);
+  ++totals.requests;
+  totals.frequencies += frequencies;
+
+  if (latencies.size() < latency_history) {
+    latencies.push_back(latency);
+  } else {
+    latencies[latency_position] = latency;
+    latency_position = (latency_position + 1) % latency_history;
+  }
+}
+
+server_metrics evaluation_server::get_metrics() const
+{
+  std::vector<double> recent;
+  server_metrics metrics;
+  {
+    std::lock_guard<std::mutex> lock{metrics_mutex};
+    metrics = totals;
+    recent = latencies;
+  }
+
+  if (recent.empty()) {
+    return metrics;
+  }
+
+  auto percentile = [&](const double &fraction) {
+    size_t index = static_cast<size_t>(fraction * (recent.size() - 1));
+    std::nth_element(recent.begin(), recent.begin() + index, recent.end());
+    return recent[index];
+  };
+
+  metrics.p50_latency = percentile(0.5);
+  metrics.p99_latency = percentile(0.99);
+
+  return metrics;
+}
+
+//------------------------------------------------------------------------------
+// Client:
+//------------------------------------------------------------------------------
+
+std::string circuits::query_server(
+  const std::string &socket_path, const std::string &request)
+{
+  sockaddr_un address = socket_address(socket_path);
+
+  int descriptor = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (descriptor < 0) {
+    throw std::runtime_error{"Could not create socket."};
+  }
+
+  if (::connect(descriptor, reinterpret_cast<sockaddr *>(&address),
+    sizeof(address)) != 0) {
+    ::close(descriptor);
+    throw std::runtime_error{"Could not connect to " + socket_path};
+  }
+
+  // Closing our side tells the server there are no more requests:
+  std::string message = request;
+  if (message.empty() || message.back() != '\n') {
+    message += '\n';
+  }
+
+  bool sent = send_all(descriptor, message);
+  ::shutdown(descriptor, SHUT_WR);
+
+  std::string reply;
+  char chunk[4096];
+  ssize_t count{};
+
+  while (sent && (count = ::recv(descriptor, chunk, sizeof(chunk), 0)) > 0) {
+    reply.append(chunk, static_cast<size_t>(count));
+  }
+
+  ::close(descriptor);
+
+  if (!sent) {
+    throw std::runtime_error{"Could not send request to " + socket_path};
+  }
+
+  return reply;
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,159 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Evaluation server on a Unix domain socket (batched, thread pooled):
+//------------------------------------------------------------------------------
+
+#ifndef server_hpp
+#define server_hpp
+
+#include "circuit.hpp"
+#include "parallel.hpp"
+
+#include <chrono>
+#include <deque>
+#include <future>
+#include <map>
+#include <shared_mutex>
+
+//------------------------------------------------------------------------------
+// Protocol (one request per line, replies start with OK or ERROR):
+//
+//   DEFINE <name>            netlist lines (title first) then END, kept warm
+//   EVAL <name> <f> ...      impedance of a defined circuit at each f (Hz)
+//   CIRCUIT <f> ...          one off netlist (title first) then END
+//   UNDEFINE <name>          drops a definition
+//   STATS                    latency / batching metrics
+//   QUIT                     closes the connection
+//
+// Evaluations reply "OK <count> <latency us>" then "<f> <re Z> <im Z>" lines.
+//------------------------------------------------------------------------------
+
+namespace circuits
+{
+  struct server_options
+  {
+    std::string socket_path = "/tmp/ac_circuits.sock";
+
+    // Worker threads (0 = one per core):
+    size_t threads = 0;
+
+    // How long the first request of a batch waits for others to join:
+    std::chrono::microseconds batch_window{200};
+    size_t max_batch = 64;
+
+    // Frequencies given to one worker at a time:
+    size_t chunk_size = 256;
+  };
+
+  struct server_metrics
+  {
+    size_t requests = 0;
+    size_t batches = 0;
+    size_t frequencies = 0;
+
+    // Request latency (receipt to reply) in microseconds:
+    double mean_latency = 0.0;
+    double p50_latency = 0.0;
+    double p99_latency = 0.0;
+    double max_latency = 0.0;
+  };
+
+//------------------------------------------------------------------------------
+
+  class evaluation_server
+  {
+  private:
+    // One client request waiting for (or in) a batch:
+    struct pending_evaluation
+    {
+      std::shared_ptr<const circuit> circ;
+      std::vector<double> frequencies;
+      std::vector<std::complex<double>> impedances;
+      std::promise<void> done;
+    };
+
+    server_options options;
+    thread_pool pool;
+
+    int listen_descriptor = -1;
+    std::atomic<bool> running{false};
+
+    // Warm definitions, shared by all connections:
+    std::map<std::string, std::shared_ptr<const circuit>> definitions;
+    mutable std::shared_mutex definitions_mutex;
+
+    std::deque<std::shared_ptr<pending_evaluation>> queue;
+    std::mutex queue_mutex;
+    std::condition_variable queue_ready;
+
+    std::thread accept_thread;
+    std::thread batch_thread;
+
+    // Client threads are detached, so stop() waits on the count instead:
+    std::vector<int> connection_descriptors;
+    size_t active_connections = 0;
+    std::mutex connections_mutex;
+    std::condition_variable connections_done;
+
+    // Metrics (latencies kept for the most recent requests only):
+    static const size_t latency_history = 4096;
+    std::vector<double> latencies;
+    size_t latency_position = 0;
+    server_metrics totals;
+    mutable std::mutex metrics_mutex;
+
+    void accept_loop();
+    void batch_loop();
+    void serve_connection(const int &descriptor);
+
+    void evaluate_batch(
+      std::vector<std::shared_ptr<pending_evaluation>> &batch);
+
+    // Queues an evaluation and waits for its batch to finish:
+    std::vector<std::complex<double>> evaluate(
+      const std::shared_ptr<const circuit> &circ,
+      const std::vector<double> &frequencies);
+
+    void record_latency(const double &latency, const size_t &frequencies);
+
+  public:
+    // Parameterised constructor (doesn't start listening):
+    evaluation_server(const server_options &opts = server_options{});
+
+    // Destructor (stops the server):
+    ~evaluation_server();
+
+    evaluation_server(const evaluation_server &) = delete;
+    evaluation_server &operator=(const evaluation_server &) = delete;
+
+//------------------------------------------------------------------------------
+
+    // Binds the socket and starts accepting clients in the background:
+    void start();
+
+    // Closes the socket and all client connections:
+    void stop();
+
+    bool is_running() const;
+
+    // Definitions can also be added directly (e.g. from circuits_library):
+    void define(const std::string &name, const circuit &circ);
+    void undefine(const std::string &name);
+
+    server_metrics get_metrics() const;
+  };
+
+//------------------------------------------------------------------------------
+
+  // Sends one request (including any netlist lines) and returns the reply:
+  std::string query_server(
+    const std::string &socket_path, const std::string &request);
+}
+
+//------------------------------------------------------------------------------
+#endif
+//------------------------------------------------------------------------------
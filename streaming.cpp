@@ -0,0 +1,298 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Streaming frequency sweeps:
+//------------------------------------------------------------------------------
+
+#include "streaming.hpp"
+#include "parallel.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <mutex>
+
+using namespace circuits;
+
+//------------------------------------------------------------------------------
+// Sinks:
+//------------------------------------------------------------------------------
+
+csv_sink::csv_sink(std::ostream &stream, const bool &header) : out{stream}
+{
+  if (header) {
+    out << "frequency,real,imaginary" << std::endl;
+  }
+}
+
+void csv_sink::write(const double *frequencies,
+  const std::complex<double> *impedances, const size_t &count)
+{
+  // Three shortest round trip doubles (at most 24 chars each) per line:
+  buffer.resize(count * 3 * 25);
+  char *position = buffer.data();
+  char *last = buffer.data() + buffer.size();
+
+  for (size_t i{}; i < count; ++i) {
+    position = std::to_chars(position, last, frequencies[i]).ptr;
+    *position++ = ',';
+    position = std::to_chars(position, last, impedances[i].real()).ptr;
+    *position++ = ',';
+    position = std::to_chars(position, last, impedances[i].imag()).ptr;
+    *position++ = '\n';
+  }
+
+  out.write(buffer.data(), position - buffer.data());
+}
+
+void csv_sink::finish()
+{
+  out.flush();
+}
+
+//------------------------------------------------------------------------------
+
+binary_sink::binary_sink(std::ostream &stream) : out{stream} {}
+
+void binary_sink::write(const double *frequencies,
+  const std::complex<double> *impedances, const size_t &count)
+{
+  buffer.resize(3 * count);
+
+  for (size_t i{}; i < count; ++i) {
+    buffer[3 * i] = frequencies[i];
+    buffer[3 * i + 1] = impedances[i].real();
+    buffer[3 * i + 2] = impedances[i].imag();
+  }
+
+  out.write(reinterpret_cast<const char*>(buffer.data()),
+    buffer.size() * sizeof(double));
+}
+
+void binary_sink::finish()
+{
+  out.flush();
+}
+
+//------------------------------------------------------------------------------
+
+callback_sink::callback_sink(callback func) : on_chunk{std::move(func)}
+{
+  if (!on_chunk) {
+    throw std::invalid_argument("Sweep callback must not be empty.");
+  }
+}
+
+void callback_sink::write(const double *frequencies,
+  const std::complex<double> *impedances, const size_t &count)
+{
+  on_chunk(frequencies, impedances, count);
+}
+
+//------------------------------------------------------------------------------
+// Sweep points:
+//------------------------------------------------------------------------------
+
+double circuits::sweep_frequency(const sweep_range &range, const size_t &index)
+{
+  if (range.points <= 1) {
+    return range.f_min;
+  }
+
+  // Worked out from the index (not accumulated), so no drift over 1e8 points:
+  double fraction = static_cast<double>(index) / (range.points - 1);
+
+  if (range.spacing == sweep_spacing::logarithmic) {
+    return range.f_min * std::pow(range.f_max / range.f_min, fraction);
+  }
+  return range.f_min + (range.f_max - range.f_min) * fraction;
+}
+
+//------------------------------------------------------------------------------
+// Pipeline:
+//------------------------------------------------------------------------------
+
+namespace
+{
+  struct sweep_chunk
+  {
+    std::vector<double> frequencies;
+    std::vector<std::complex<double>> impedances;
+    size_t count = 0;
+  };
+
+  // Rings and chunks owned by one evaluator:
+  struct pipeline_lane
+  {
+    std::vector<std::unique_ptr<sweep_chunk>> pool;
+
+    spsc_ring<sweep_chunk*> to_evaluate;
+    spsc_ring<sweep_chunk*> to_write;
+    spsc_ring<sweep_chunk*> to_reuse;
+
+    pipeline_lane(const size_t &chunks, const size_t &chunk_size,
+      const std::atomic<bool> *abort)
+      : to_evaluate{chunks, abort}, to_write{chunks, abort},
+        to_reuse{chunks, abort}
+    {
+      for (size_t i{}; i < chunks; ++i) {
+        pool.push_back(std::make_unique<sweep_chunk>());
+        pool.back()->frequencies.resize(chunk_size);
+        pool.back()->impedances.resize(chunk_size);
+
+        to_reuse.push(pool.back().get());
+      }
+    }
+  };
+
+  void check_range(const sweep_range &range, const pipeline_options &options)
+  {
+    if (range.points == 0) {
+      throw std::invalid_argument("Sweep needs at least one point.");
+    }
+    if (range.f_min < 0 || range.f_max < range.f_min) {
+      throw std::out_of_range("Sweep range must have 0 <= f_min <= f_max.");
+    }
+    if (range.spacing == sweep_spacing::logarithmic && range.f_min <= 0) {
+      throw std::out_of_range("Logarithmic sweeps need f_min > 0.");
+    }
+    if (options.chunk_size == 0 || options.chunks_per_evaluator == 0) {
+      throw std::invalid_argument(
+        "Chunk size and chunks per evaluator must be at least 1.");
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void circuits::stream_sweep(const circuit &circ, const sweep_range &range,
+  sweep_sink &sink, const pipeline_options &options)
+{
+  check_range(range, options);
+
+  size_t evaluators = options.evaluators;
+  if (evaluators == 0) {
+    size_t cores = get_thread_count();
+    evaluators = (cores > 3) ? cores - 2 : 1;
+  }
+
+  size_t chunk_count = (range.points + options.chunk_size - 1)
+    / options.chunk_size;
+  evaluators = std::min(evaluators, chunk_count);
+
+  // First error from any stage stops the others:
+  std::atomic<bool> abort{false};
+  std::exception_ptr first_error;
+  std::mutex error_mutex;
+
+  auto fail = [&]() {
+    std::lock_guard<std::mutex> lock{error_mutex};
+    if (!first_error) {
+      first_error = std::current_exception();
+    }
+    abort = true;
+  };
+
+  std::vector<std::unique_ptr<pipeline_lane>> lanes;
+  for (size_t i{}; i < evaluators; ++i) {
+    lanes.push_back(std::make_unique<pipeline_lane>(
+      options.chunks_per_evaluator, options.chunk_size, &abort));
+  }
+
+  // Chunk k goes through lane k % evaluators, so the writer reads in order:
+  std::thread generator{[&]() {
+    try {
+      for (size_t k{}; k < chunk_count; ++k) {
+        pipeline_lane &lane = *lanes[k % evaluators];
+
+        sweep_chunk *chunk{};
+        if (!lane.to_reuse.pop(chunk)) {
+          break;
+        }
+
+        size_t first = k * options.chunk_size;
+        chunk->count = std::min(options.chunk_size, range.points - first);
+        for (size_t i{}; i < chunk->count; ++i) {
+          chunk->frequencies[i] = sweep_frequency(range, first + i);
+        }
+
+        if (!lane.to_evaluate.push(chunk)) {
+          break;
+        }
+      }
+    }
+    catch (...) {
+      fail();
+    }
+
+    for (auto &lane : lanes) {
+      lane->to_evaluate.close();
+    }
+  }};
+
+  std::vector<std::thread> workers;
+  for (size_t e{}; e < evaluators; ++e) {
+    workers.emplace_back([&, e]() {
+      pipeline_lane &lane = *lanes[e];
+
+      try {
+        // evaluate() is const, so every lane shares the circuit:
+        sweep_chunk *chunk{};
+        while (lane.to_evaluate.pop(chunk)) {
+          for (size_t i{}; i < chunk->count; ++i) {
+            chunk->impedances[i] = circ.evaluate(chunk->frequencies[i]);
+          }
+
+          if (!lane.to_write.push(chunk)) {
+            break;
+          }
+        }
+      }
+      catch (...) {
+        fail();
+      }
+
+      lane.to_write.close();
+    });
+  }
+
+  // Writer stage runs on the calling thread:
+  try {
+    for (size_t k{}; k < chunk_count; ++k) {
+      pipeline_lane &lane = *lanes[k % evaluators];
+
+      sweep_chunk *chunk{};
+      if (!lane.to_write.pop(chunk)) {
+        break;
+      }
+
+      sink.write(chunk->frequencies.data(), chunk->impedances.data(),
+        chunk->count);
+
+      if (!lane.to_reuse.push(chunk)) {
+        break;
+      }
+    }
+  }
+  catch (...) {
+    fail();
+  }
+
+  // Nothing is waiting on the writer any more, let the others finish:
+  if (first_error) {
+    abort = true;
+  }
+
+  generator.join();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+
+  if (first_error) {
+    std::rethrow_exception(first_error);
+  }
+
+  sink.finish();
+}
@@ -0,0 +1,221 @@
+//------------------------------------------------------------------------------
+
+// Project - AC Circuits
+// Monty Kirner - 14/04/21
+
+//------------------------------------------------------------------------------
+// Streaming frequency sweeps (constant memory, any number of points):
+//------------------------------------------------------------------------------
+
+#ifndef streaming_hpp
+#define streaming_hpp
+
+#include "circuit.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Pipeline:
+//
+//   generator --> evaluator 1 --> writer
+//             --> evaluator 2 -->          (chunks dealt round robin)
+//             --> ...         -->
+//
+// Every link is a bounded single producer / single consumer ring of chunks,
+// and the writer hands used chunks back to the generator, so the number of
+// chunks (and so memory) is fixed. A slow sink fills the rings and stalls the
+// generator (back-pressure) instead of buffering the sweep.
+//------------------------------------------------------------------------------
+
+namespace circuits
+{
+  // Bounded lock free queue for exactly one producer and one consumer thread:
+  template <class T> class spsc_ring
+  {
+  private:
+    std::vector<T> slots;
+
+    // Next slot to pop (written by the consumer) / push (by the producer):
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+    alignas(64) std::atomic<bool> closed{false};
+
+    // Set by either side (or a third party) to make both sides give up:
+    const std::atomic<bool> *abort_flag;
+
+    // Spins briefly, then yields, then sleeps (waits are usually short):
+    static void back_off(size_t &attempts)
+    {
+      if (++attempts < 64) {
+        return;
+      } else if (attempts < 128) {
+        std::this_thread::yield();
+      } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+      }
+    }
+
+  public:
+    spsc_ring(const size_t &capacity, const std::atomic<bool> *abort)
+      : slots(capacity + 1), abort_flag{abort} {}
+
+    // Waits for space, false if the pipeline was aborted:
+    bool push(const T &item)
+    {
+      size_t position = tail.load(std::memory_order_relaxed);
+      size_t next = (position + 1) % slots.size();
+
+      size_t attempts{};
+      while (next == head.load(std::memory_order_acquire)) {
+        if (abort_flag->load(std::memory_order_relaxed)) {
+          return false;
+        }
+        back_off(attempts);
+      }
+
+      slots[position] = item;
+      tail.store(next, std::memory_order_release);
+      return true;
+    }
+
+    // Waits for an item, false once closed and empty (or aborted):
+    bool pop(T &item)
+    {
+      size_t position = head.load(std::memory_order_relaxed);
+
+      size_t attempts{};
+      while (position == tail.load(std::memory_order_acquire)) {
+        if (abort_flag->load(std::memory_order_relaxed)) {
+          return false;
+        }
+        // Closed is checked before tail again, so no push is missed:
+        if (closed.load(std::memory_order_acquire)
+          && position == tail.load(std::memory_order_acquire)) {
+          return false;
+        }
+        back_off(attempts);
+      }
+
+      item = slots[position];
+      head.store((position + 1) % slots.size(), std::memory_order_release);
+      return true;
+    }
+
+    // Producer has finished:
+    void close()
+    {
+      closed.store(true, std::memory_order_release);
+    }
+  };
+
+//------------------------------------------------------------------------------
+// Sweep range:
+//------------------------------------------------------------------------------
+
+  enum class sweep_spacing {linear, logarithmic};
+
+  struct sweep_range
+  {
+    double f_min;
+    double f_max;
+    size_t points;
+    sweep_spacing spacing = sweep_spacing::logarithmic;
+  };
+
+  struct pipeline_options
+  {
+    // Points per chunk:
+    size_t chunk_size = 4096;
+
+    // Chunks in flight per evaluator (bounds memory):
+    size_t chunks_per_evaluator = 4;
+
+    // Evaluator threads (0 = cores left after the generator and writer):
+    size_t evaluators = 0;
+  };
+
+//------------------------------------------------------------------------------
+// Sinks (called from the writer thread, chunks arrive in frequency order):
+//------------------------------------------------------------------------------
+
+  class sweep_sink
+  {
+  public:
+    virtual ~sweep_sink() = default;
+
+    virtual void write(const double *frequencies,
+      const std::complex<double> *impedances, const size_t &count) = 0;
+
+    // Called once after the last chunk:
+    virtual void finish() {}
+  };
+
+  // "frequency,real,imaginary" lines (shortest exact representation):
+  class csv_sink : public sweep_sink
+  {
+  private:
+    std::ostream &out;
+    std::string buffer;
+
+  public:
+    csv_sink(std::ostream &stream, const bool &header = true);
+
+    void write(const double *frequencies,
+      const std::complex<double> *impedances, const size_t &count);
+
+    void finish();
+  };
+
+  // Records of three native doubles (frequency, real, imaginary):
+  class binary_sink : public sweep_sink
+  {
+  private:
+    std::ostream &out;
+    std::vector<double> buffer;
+
+  public:
+    binary_sink(std::ostream &stream);
+
+    void write(const double *frequencies,
+      const std::complex<double> *impedances, const size_t &count);
+
+    void finish();
+  };
+
+  // Hands each chunk to a user function:
+  class callback_sink : public sweep_sink
+  {
+  public:
+    using callback = std::function<void(const double *,
+      const std::complex<double> *, const size_t &)>;
+
+  private:
+    callback on_chunk;
+
+  public:
+    callback_sink(callback func);
+
+    void write(const double *frequencies,
+      const std::complex<double> *impedances, const size_t &count);
+  };
+
+//------------------------------------------------------------------------------
+
+  // Frequency of point index in the sweep (Hz):
+  double sweep_frequency(const sweep_range &range, const size_t &index);
+
+  // Evaluates the circuit over the range, writing to sink as it goes:
+  // (the circuit isn't changed, evaluators share it through evaluate())
+  void stream_sweep(const circuit &circ, const sweep_range &range,
+    sweep_sink &sink, const pipeline_options &options = pipeline_options{});
+}
+
+//------------------------------------------------------------------------------
+#endif
+//------------------------------------------------------------------------------